@@ -0,0 +1,94 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+#include <stdint.h>
+#include <iostream>
+#include <api/api.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *  NB: This is CounterBench, except that the increment is a TM_ADD.  With
+ *      libstm, that is deferred to commit (see stm::tx_add), so the
+ *      transactions don't conflict on the counter, and every transaction
+ *      should land in it exactly once.
+ */
+
+/*** the counter we will manipulate in the experiment */
+long counter;
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Initialize the counter */
+void
+bench_init()
+{
+    counter = 0;
+}
+
+/*** Run a bunch of increment transactions */
+void
+bench_test(uintptr_t, uint32_t*)
+{
+    TM_BEGIN(atomic) {
+        // increment the counter
+        TM_ADD(counter, 1);
+    } TM_END;
+}
+
+/*** Ensure the final state of the benchmark satisfies all invariants */
+bool
+bench_verify()
+{
+    std::cout << "(final value = " << counter << ") ";
+    return (counter == (long)(CFG.txcount + CFG.warmcount));
+}
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** no reparsing needed */
+void
+bench_reparse() {
+    CFG.bmname = "Adder";
+}
@@ -0,0 +1,147 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+
+#include <iostream>
+#include <api/api.hpp>
+#include <api/atomic.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *  NB: This is a bank, written with stm::atomic instead of the macros.
+ *      Each transaction moves money between CFG.ops pairs of accounts, and
+ *      counts itself in a tm_adder.  The total balance never changes.
+ */
+
+static const long     INITIAL_BALANCE = 1000;
+static const uint32_t MAX_OPS = 64;
+
+/*** the accounts, and the count of transfers */
+stm::tm_var<long>*   ACCOUNTS;
+stm::tm_adder<long>* TRANSFERS;
+
+/*** the body of a transaction; the accounts are chosen before it starts */
+struct Transfer
+{
+    typedef long result_type;
+    const uint32_t* from;
+    const uint32_t* to;
+    long operator()(stm::Tx& tx) const
+    {
+        for (uint32_t i = 0; i < CFG.ops; ++i) {
+            long balance = ACCOUNTS[from[i]].load(tx);
+            long amount = balance % 10;
+            ACCOUNTS[from[i]].store(tx, balance - amount);
+            ACCOUNTS[to[i]].store(tx, ACCOUNTS[to[i]].load(tx) + amount);
+        }
+        TRANSFERS->add(tx, 1);
+        return TRANSFERS->load(tx);
+    }
+};
+
+/*** a read-only audit of a range of accounts */
+struct Audit
+{
+    typedef long result_type;
+    uint32_t first;
+    long operator()(stm::Tx& tx) const
+    {
+        long sum = 0;
+        for (uint32_t i = 0; i < CFG.ops * 2; ++i)
+            sum += ACCOUNTS[(first + i) % CFG.elements].load(tx);
+        return sum;
+    }
+};
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Open the accounts */
+void bench_init()
+{
+    ACCOUNTS = new stm::tm_var<long>[CFG.elements];
+    for (uint32_t i = 0; i < CFG.elements; ++i)
+        ACCOUNTS[i].unsafe_store(INITIAL_BALANCE);
+    TRANSFERS = new stm::tm_adder<long>();
+}
+
+/*** Run a transfer or an audit */
+void bench_test(uintptr_t, uint32_t* seed)
+{
+    uint32_t act = rand_r(seed) % 100;
+    if (act < CFG.lookpct) {
+        Audit a = { rand_r(seed) % CFG.elements };
+        stm::atomic(a);
+        return;
+    }
+    uint32_t from[MAX_OPS], to[MAX_OPS];
+    for (uint32_t i = 0; i < CFG.ops; ++i) {
+        from[i] = rand_r(seed) % CFG.elements;
+        to[i] = rand_r(seed) % CFG.elements;
+    }
+    Transfer t = { from, to };
+    stm::atomic(t);
+}
+
+/*** No money was made or lost */
+bool bench_verify()
+{
+    long total = 0;
+    for (uint32_t i = 0; i < CFG.elements; ++i)
+        total += ACCOUNTS[i].unsafe_load();
+    std::cout << "(transfers = " << TRANSFERS->unsafe_load() << ") ";
+    return total == INITIAL_BALANCE * (long)CFG.elements;
+}
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if      (CFG.bmname == "")          CFG.bmname   = "Atomic";
+    else if (CFG.bmname == "Atomic16")  CFG.elements = 16;
+    else if (CFG.bmname == "Atomic256") CFG.elements = 256;
+    else if (CFG.bmname == "Atomic64K") CFG.elements = 65536;
+    if (CFG.ops > MAX_OPS)
+        CFG.ops = MAX_OPS;
+}
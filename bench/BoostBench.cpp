@@ -0,0 +1,267 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+
+#include <iostream>
+#include <vector>
+#include <api/api.hpp>
+#include <api/boosting.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ *
+ *  NB: There are CFG.elements tokens, spread over the four boosted
+ *      containers.  A transaction moves one token from one container to
+ *      another, so an abort that doesn't undo exactly what the transaction
+ *      did loses or duplicates a token, which bench_verify will notice.
+ *      Some transactions take a token from a container and put it back
+ *      twice, so that they undo operations on elements they added
+ *      themselves, and some of those abort once on purpose.
+ *      Since the containers don't instrument their own memory, this works
+ *      the same way with every algorithm.
+ */
+
+enum { HASH, MAP, PQUEUE, QUEUE, CONTAINERS };
+
+stm::BoostedHashMap<long, long>* HASHMAP;
+stm::BoostedMap<long, long>*     TREEMAP;
+stm::BoostedPriorityQueue<long>* PQ;
+stm::BoostedQueue<long>*         FIFO;
+
+/*** take a token out of a container; the maps take the one at key */
+bool take(stm::Tx& tx, uint32_t which, long key, long* tok)
+{
+    switch (which) {
+      case HASH:   return HASHMAP->erase(tx, key, tok);
+      case MAP:    return TREEMAP->erase(tx, key, tok);
+      case PQUEUE: return PQ->pop(tx, tok);
+      default:     return FIFO->dequeue(tx, tok);
+    }
+}
+
+/*** put a token in a container; it can't already be in a map */
+void put(stm::Tx& tx, uint32_t which, long tok)
+{
+    switch (which) {
+      case HASH:   HASHMAP->insert(tx, tok, tok); break;
+      case MAP:    TREEMAP->insert(tx, tok, tok); break;
+      case PQUEUE: PQ->push(tx, tok);             break;
+      default:     FIFO->enqueue(tx, tok);        break;
+    }
+}
+
+/*** move a token, if the source has one to give */
+struct Move
+{
+    typedef bool result_type;
+    uint32_t from, to;
+    long     key;
+    bool operator()(stm::Tx& tx) const
+    {
+        long tok;
+        if (!take(tx, from, key, &tok))
+            return false;
+        put(tx, to, tok);
+        return true;
+    }
+};
+
+/**
+ *  take a token and put it back, twice, so that the second take can get
+ *  the token we just put.  If tries is set, restart the first attempt, so
+ *  that the abort handlers undo all four operations.
+ */
+struct Churn
+{
+    typedef bool result_type;
+    uint32_t  which;
+    long      key;
+    uint32_t* tries;
+    bool operator()(stm::Tx& tx) const
+    {
+        long tok;
+        for (int i = 0; i < 2; ++i) {
+            if (!take(tx, which, key, &tok))
+                return false;
+            put(tx, which, tok);
+        }
+        // an irrevocable transaction can't abort
+        if (tries && (*tries)++ == 0 && !stm::is_irrevoc(*tx.thread()))
+            tx.restart();
+        return true;
+    }
+};
+
+/*** look a key up in one of the maps, or peek at the priority queue */
+struct Lookup
+{
+    typedef bool result_type;
+    uint32_t which;
+    long     key;
+    bool operator()(stm::Tx& tx) const
+    {
+        long v;
+        switch (which) {
+          case HASH: return HASHMAP->get(tx, key, &v);
+          case MAP:  return TREEMAP->get(tx, key, &v);
+          default:   return PQ->top(tx, &v);
+        }
+    }
+};
+
+/*** take every token out of the queues, for bench_verify */
+struct Drain
+{
+    typedef bool result_type;
+    uint32_t          which;
+    std::vector<long>* out;
+    bool operator()(stm::Tx& tx) const
+    {
+        out->clear();
+        long tok;
+        while (take(tx, which, 0, &tok))
+            out->push_back(tok);
+        return true;
+    }
+};
+
+/*** count each token found in one of the maps */
+struct Collect
+{
+    std::vector<uint32_t>* seen;
+    size_t*                count;
+    void operator()(long k, long v)
+    {
+        ++*count;
+        if (k == v && k >= 0 && k < (long)seen->size())
+            ++(*seen)[k];
+    }
+};
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** Deal the tokens out to the containers */
+void bench_init()
+{
+    HASHMAP = new stm::BoostedHashMap<long, long>(CFG.elements);
+    TREEMAP = new stm::BoostedMap<long, long>(CFG.elements);
+    PQ      = new stm::BoostedPriorityQueue<long>();
+    FIFO    = new stm::BoostedQueue<long>();
+    for (long t = 0; t < (long)CFG.elements; ++t) {
+        switch (t % CONTAINERS) {
+          case HASH:   HASHMAP->unsafe_put(t, t); break;
+          case MAP:    TREEMAP->unsafe_put(t, t); break;
+          case PQUEUE: PQ->unsafe_push(t);        break;
+          default:     FIFO->unsafe_enqueue(t);   break;
+        }
+    }
+}
+
+/*** Run a bunch of random transactions */
+void bench_test(uintptr_t, uint32_t* seed)
+{
+    uint32_t act = rand_r(seed) % 100;
+    uint32_t from = rand_r(seed) % CONTAINERS;
+    long key = rand_r(seed) % CFG.elements;
+    if (act < CFG.lookpct) {
+        Lookup l = { from % 3, key };
+        stm::atomic(l);
+    }
+    else if (act % 4 == 0) {
+        uint32_t tries = 0;
+        Churn c = { from, key, (act % 8 == 0) ? &tries : NULL };
+        stm::atomic(c);
+    }
+    else {
+        Move m = { from, (from + 1 + rand_r(seed) % 3) % CONTAINERS, key };
+        stm::atomic(m);
+    }
+}
+
+/**
+ *  Every token must be in exactly one container, each queue must give up
+ *  as many tokens as it holds, and the priority queue must give them up in
+ *  order
+ */
+bool bench_verify()
+{
+    std::vector<uint32_t> seen(CFG.elements, 0);
+    size_t total = 0;
+    Collect c = { &seen, &total };
+    HASHMAP->unsafe_for_each(c);
+    TREEMAP->unsafe_for_each(c);
+    std::cout << "(in queues = " << PQ->unsafe_size() + FIFO->unsafe_size()
+              << ") ";
+    for (uint32_t q = PQUEUE; q <= QUEUE; ++q) {
+        size_t size = (q == PQUEUE) ? PQ->unsafe_size() : FIFO->unsafe_size();
+        std::vector<long> toks;
+        Drain d = { q, &toks };
+        stm::atomic(d);
+        if (toks.size() != size)
+            return false;
+        for (size_t i = 0; i < toks.size(); ++i) {
+            if (q == PQUEUE && i > 0 && toks[i] < toks[i - 1])
+                return false;
+            if (toks[i] >= 0 && toks[i] < (long)CFG.elements)
+                ++seen[toks[i]];
+        }
+        total += toks.size();
+    }
+    if (total != CFG.elements)
+        return false;
+    for (uint32_t t = 0; t < CFG.elements; ++t)
+        if (seen[t] != 1)
+            return false;
+    return true;
+}
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if      (CFG.bmname == "")         CFG.bmname   = "Boost";
+    else if (CFG.bmname == "Boost16")  CFG.elements = 16;
+    else if (CFG.bmname == "Boost256") CFG.elements = 256;
+    else if (CFG.bmname == "Boost64K") CFG.elements = 65536;
+}
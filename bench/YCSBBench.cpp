@@ -0,0 +1,413 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#include <stm/config.h>
+#if defined(STM_CPU_SPARC)
+#include <sys/types.h>
+#endif
+
+/**
+ *  Step 1:
+ *    Include the configuration code for the harness, and the API code.
+ */
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <api/api.hpp>
+#include "bmconfig.hpp"
+
+/**
+ *  We provide the option to build the entire benchmark in a single
+ *  source. The bmconfig.hpp include defines all of the important functions
+ *  that are implemented in this file, and bmharness.cpp defines the
+ *  execution infrastructure.
+ */
+#ifdef SINGLE_SOURCE_BUILD
+#include "bmharness.cpp"
+#endif
+
+/**
+ *  Step 2:
+ *    Declare the data type that will be stress tested via this benchmark.
+ *    Also provide any functions that will be needed to manipulate the data
+ *    type.  Take care to avoid unnecessary indirection.
+ */
+
+#include "Hash.hpp"
+#include "Tree.hpp"
+
+/**
+ *  A YCSB-style key-value store
+ *
+ *    Keys live in a Hash or an RBTree index, and each key's value is a
+ *    record of some number of words in a separate array.  The first half of
+ *    the key range (-m) is loaded at startup, and inserts claim the keys
+ *    after it, wrapping around once the range is used up.
+ *
+ *    The benchmark name picks the configuration:
+ *
+ *        <Hash|Tree>-<A-F>[-<distribution>[-<value bytes>]]
+ *
+ *    The workloads are the YCSB core workloads: A is 50% reads and 50%
+ *    updates, B is 95/5 reads/updates, C is all reads, D is 95% reads of
+ *    recent keys and 5% inserts, E is 95% short scans and 5% inserts, and F
+ *    is 50% reads and 50% read-modify-writes.  The distributions are
+ *    "uniform", "zipf" (a scrambled Zipfian, optionally with its constant,
+ *    e.g. "zipf0.8"; the default is 0.99), "hotspot" (80% of requests go to
+ *    20% of the keys), and "latest" (Zipfian over the most recent inserts).
+ *    D defaults to latest, and the rest to zipf.  Values are 64 bytes unless
+ *    given.  Each transaction runs -O operations, so -O > 1 gives multi-key
+ *    transactions.
+ */
+struct KVStore
+{
+    /*** percentages of each kind of operation, from the workload letter */
+    struct mix_t
+    {
+        char     name;
+        uint32_t read, update, insert, scan, rmw;
+        const char* dist;               // the default distribution
+    };
+
+    enum op_kind_t { READ, UPDATE, INSERT, SCAN, RMW };
+    enum dist_t { UNIFORM, ZIPF, HOTSPOT, LATEST };
+
+    /*** one operation of a transaction, chosen before the transaction */
+    struct op_t
+    {
+        op_kind_t kind;
+        uint32_t  key;
+        uint32_t  len;                  // records to scan
+    };
+
+    static const uint32_t MAX_OPS = 64;     // operations per transaction
+    static const uint32_t MAX_SCAN = 100;   // YCSB's default maxscanlength
+
+    HashTable*         hash;            // the index, if it is a hash...
+    RBTree*            tree;            // ... or if it is a tree
+    uintptr_t*         values;          // value_words per key
+    uint32_t           value_words;
+    uint32_t           keys;            // size of the key range
+    uint32_t           loaded;          // keys loaded at startup
+    volatile uint32_t  inserted;        // keys claimed so far
+    mix_t              mix;
+    dist_t             dist;
+
+    // Zipfian constants (Gray et al., "Quickly Generating Billion-Record
+    // Synthetic Databases"), for `loaded` items
+    double theta, zetan, alpha, eta;
+
+    KVStore(const std::string& name, uint32_t nkeys);
+
+    /*** a uniform double in [0, 1) */
+    static double uniform(uint32_t* seed)
+    {
+        return rand_r(seed) / ((double)RAND_MAX + 1.0);
+    }
+
+    /*** a Zipfian rank in [0, loaded), where 0 is the most popular */
+    uint32_t zipf(uint32_t* seed) const
+    {
+        double u = uniform(seed);
+        double uz = u * zetan;
+        if (uz < 1.0)
+            return 0;
+        if (uz < 1.0 + std::pow(0.5, theta))
+            return 1;
+        uint32_t r = (uint32_t)(loaded * std::pow(eta * u - eta + 1, alpha));
+        return (r < loaded) ? r : loaded - 1;
+    }
+
+    /*** FNV-1a, to spread popular ranks over the key range */
+    static uint32_t scramble(uint32_t v)
+    {
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < 4; ++i) {
+            h ^= (v >> (8 * i)) & 0xff;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    /*** pick an existing key according to the distribution */
+    uint32_t next_key(uint32_t* seed) const
+    {
+        uint32_t n = inserted;
+        if (n > keys)
+            n = keys;
+        switch (dist) {
+          case ZIPF:
+            return scramble(zipf(seed)) % n;
+          case HOTSPOT: {
+              uint32_t hot = n / 5 ? n / 5 : 1;
+              if (rand_r(seed) % 100 < 80 || hot == n)
+                  return rand_r(seed) % hot;
+              return hot + rand_r(seed) % (n - hot);
+          }
+          case LATEST: {
+              uint32_t back = zipf(seed);
+              return (back < n) ? n - 1 - back : 0;
+          }
+          default:
+            return rand_r(seed) % n;
+        }
+    }
+
+    /*** choose the operation and keys of one step of a transaction */
+    void next_op(op_t& op, uint32_t* seed)
+    {
+        uint32_t act = rand_r(seed) % 100;
+        op.len = 1;
+        if (act < mix.read)
+            op.kind = READ;
+        else if ((act -= mix.read) < mix.update)
+            op.kind = UPDATE;
+        else if ((act -= mix.update) < mix.insert)
+            op.kind = INSERT;
+        else if ((act -= mix.insert) < mix.scan)
+            op.kind = SCAN;
+        else
+            op.kind = RMW;
+
+        if (op.kind == INSERT) {
+            op.key = fai32(&inserted) % keys;
+            return;
+        }
+        op.key = next_key(seed);
+        if (op.kind == SCAN)
+            op.len = 1 + rand_r(seed) % MAX_SCAN;
+    }
+
+    TM_CALLABLE
+    bool index_lookup(uint32_t key TM_ARG) const
+    {
+        return hash ? hash->lookup(key TM_PARAM) : tree->lookup(key TM_PARAM);
+    }
+
+    TM_CALLABLE
+    void index_insert(uint32_t key TM_ARG)
+    {
+        if (hash)
+            hash->insert(key TM_PARAM);
+        else
+            tree->insert(key TM_PARAM);
+    }
+
+    /*** read a record, if its key is in the index */
+    TM_CALLABLE
+    uintptr_t read(uint32_t key TM_ARG) const
+    {
+        if (!index_lookup(key TM_PARAM))
+            return 0;
+        uintptr_t sum = 0;
+        uintptr_t* v = &values[key * value_words];
+        for (uint32_t i = 0; i < value_words; ++i)
+            sum += TM_READ(v[i]);
+        return sum;
+    }
+
+    /*** overwrite every word of a record with the same value */
+    TM_CALLABLE
+    void write(uint32_t key, uintptr_t val TM_ARG)
+    {
+        uintptr_t* v = &values[key * value_words];
+        for (uint32_t i = 0; i < value_words; ++i)
+            TM_WRITE(v[i], val);
+    }
+
+    TM_CALLABLE
+    uintptr_t run(const op_t& op, uintptr_t salt TM_ARG)
+    {
+        switch (op.kind) {
+          case READ:
+            return read(op.key TM_PARAM);
+          case UPDATE:
+            if (index_lookup(op.key TM_PARAM))
+                write(op.key, salt TM_PARAM);
+            return 0;
+          case INSERT:
+            index_insert(op.key TM_PARAM);
+            write(op.key, salt TM_PARAM);
+            return 0;
+          case SCAN: {
+              uintptr_t sum = 0;
+              for (uint32_t k = op.key; k < op.key + op.len && k < keys; ++k)
+                  sum += read(k TM_PARAM);
+              return sum;
+          }
+          default: {
+              // read-modify-write: every word of the record gets one added
+              if (!index_lookup(op.key TM_PARAM))
+                  return 0;
+              uintptr_t* v = &values[op.key * value_words];
+              uintptr_t first = TM_READ(v[0]);
+              for (uint32_t i = 0; i < value_words; ++i)
+                  TM_WRITE(v[i], TM_READ(v[i]) + 1);
+              return first;
+          }
+        }
+    }
+
+    /**
+     *  Updates and read-modify-writes touch every word of a record, so a
+     *  record whose words differ saw a partial transaction
+     */
+    bool isSane() const
+    {
+        if (hash ? !hash->isSane() : !tree->isSane())
+            return false;
+        for (uint32_t k = 0; k < keys; ++k)
+            for (uint32_t i = 1; i < value_words; ++i)
+                if (values[k * value_words + i] != values[k * value_words])
+                    return false;
+        return true;
+    }
+};
+
+KVStore::KVStore(const std::string& name, uint32_t nkeys)
+    : hash(NULL), tree(NULL), values(NULL), value_words(8), keys(nkeys),
+      loaded(nkeys / 2 ? nkeys / 2 : 1), inserted(0), dist(ZIPF),
+      theta(0.99), zetan(0), alpha(0), eta(0)
+{
+    static const mix_t mixes[] = {
+        // name  read update insert scan rmw dist
+        { 'A',     50,   50,     0,   0,   0, "zipf"   },
+        { 'B',     95,    5,     0,   0,   0, "zipf"   },
+        { 'C',    100,    0,     0,   0,   0, "zipf"   },
+        { 'D',     95,    0,     5,   0,   0, "latest" },
+        { 'E',      0,    0,     5,  95,   0, "zipf"   },
+        { 'F',     50,    0,     0,   0,  50, "zipf"   }
+    };
+
+    // split <index>-<workload>-<distribution>-<value bytes>
+    std::string part[4];
+    size_t start = 0;
+    for (int i = 0; i < 4 && start <= name.size(); ++i) {
+        size_t end = name.find('-', start);
+        if (end == std::string::npos)
+            end = name.size();
+        part[i] = name.substr(start, end - start);
+        start = end + 1;
+    }
+
+    if (part[0] == "Hash")
+        hash = new HashTable();
+    else if (part[0] == "Tree")
+        tree = new RBTree();
+    else {
+        std::cerr << "YCSB index must be Hash or Tree: " << name << "\n";
+        exit(1);
+    }
+
+    char w = part[1].empty() ? 'A' : part[1][0];
+    if (w < 'A' || w > 'F' || part[1].size() > 1) {
+        std::cerr << "YCSB workload must be A-F: " << name << "\n";
+        exit(1);
+    }
+    mix = mixes[w - 'A'];
+
+    std::string d = part[2].empty() ? mix.dist : part[2];
+    if (d == "uniform")
+        dist = UNIFORM;
+    else if (d == "hotspot")
+        dist = HOTSPOT;
+    else if (d == "latest")
+        dist = LATEST;
+    else if (d.compare(0, 4, "zipf") == 0) {
+        dist = ZIPF;
+        if (d.size() > 4)
+            theta = strtod(d.c_str() + 4, NULL);
+    }
+    else {
+        std::cerr << "Unknown YCSB distribution: " << d << "\n";
+        exit(1);
+    }
+    if (theta <= 0 || theta >= 1) {
+        std::cerr << "The Zipfian constant must be in (0, 1): " << d << "\n";
+        exit(1);
+    }
+
+    if (!part[3].empty()) {
+        uint32_t bytes = strtol(part[3].c_str(), NULL, 10);
+        value_words = (bytes + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+        if (!value_words)
+            value_words = 1;
+    }
+
+    // the Zipfian constants only depend on the loaded keys, so that the
+    // popular keys stay put as inserts grow the store
+    for (uint32_t i = 1; i <= loaded; ++i)
+        zetan += 1.0 / std::pow((double)i, theta);
+    double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+    alpha = 1.0 / (1.0 - theta);
+    eta = (1.0 - std::pow(2.0 / loaded, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+
+    values = (uintptr_t*)calloc((size_t)keys * value_words, sizeof(uintptr_t));
+
+    // load the first half of the keys
+    TM_BEGIN_FAST_INITIALIZATION();
+    for (uint32_t k = 0; k < loaded; ++k) {
+        index_insert(k TM_PARAM);
+        write(k, k TM_PARAM);
+    }
+    TM_END_FAST_INITIALIZATION();
+    inserted = loaded;
+}
+
+/**
+ *  Step 3:
+ *    Declare an instance of the data type, and provide init, test, and verify
+ *    functions
+ */
+
+/*** the store we will manipulate in the experiment */
+KVStore* SET;
+
+/*** Initialize the store */
+void bench_init()
+{
+    if (CFG.ops > KVStore::MAX_OPS)
+        CFG.ops = KVStore::MAX_OPS;
+    if (CFG.ops == 0)
+        CFG.ops = 1;
+    SET = new KVStore(CFG.bmname, CFG.elements);
+}
+
+/*** Run a transaction of CFG.ops key-value operations */
+void bench_test(uintptr_t, uint32_t* seed)
+{
+    // choose the operations up front, so that a retry runs the same ones,
+    // and so that an insert claims its key only once
+    KVStore::op_t ops[KVStore::MAX_OPS];
+    for (uint32_t i = 0; i < CFG.ops; ++i)
+        SET->next_op(ops[i], seed);
+    uintptr_t salt = rand_r(seed);
+
+    TM_BEGIN(atomic) {
+        for (uint32_t i = 0; i < CFG.ops; ++i)
+            SET->run(ops[i], salt TM_PARAM);
+    } TM_END;
+}
+
+/*** Ensure the final state of the benchmark satisfies all invariants */
+bool bench_verify() { return SET->isSane(); }
+
+/**
+ *  Step 4:
+ *    Include the code that has the main() function, and the code for creating
+ *    threads and calling the three above-named functions.  Don't forget to
+ *    provide an arg reparser.
+ */
+
+/*** Deal with special names that map to different M values */
+void bench_reparse()
+{
+    if (CFG.bmname == "") CFG.bmname = "Hash-A";
+}
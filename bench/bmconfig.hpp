@@ -31,11 +31,22 @@ struct Config
     uint32_t    inspct;                 // insert percent
     uint32_t    sets;                   // number of sets to create
     uint32_t    ops;                    // operations per transaction
+    uint32_t    warmup;                 // untimed seconds before timing
+    std::string pin;                    // cores to pin threads to, or ""
+    std::string placement;              // compact, scatter, or ""
+    bool        latency;                // time every transaction?
+    bool        json;                   // also print results as json
+    std::string qtable;                 // train a CBR qtable into this file
+    std::string train_algs;             // algorithms to train on
+    std::string train_mixes;            // lookup percents to train on
+    uint32_t    trials;                 // runs to average when training
 
     /*** THESE GET UPDATED LATER ***/
     volatile uint64_t time;
     volatile bool     running;
-    volatile uint32_t txcount;
+    volatile bool     warming;
+    volatile uint32_t txcount;          // transactions while timing
+    volatile uint32_t warmcount;        // transactions during warmup
 
     Config();
 };
@@ -11,10 +11,19 @@
 #ifndef BMHARNESS_HPP__
 #define BMHARNESS_HPP__
 
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <vector>
 #include <signal.h>
 #include <pthread.h>
+#if defined(STM_OS_SOLARIS)
+#include <sys/types.h>
+#include <sys/processor.h>
+#include <sys/procset.h>
+#endif
 #include <api/api.hpp>
 #include <common/platform.hpp>
 #include <common/locks.hpp>
@@ -34,9 +43,20 @@ Config::Config() :
     inspct(66),
     sets(1),
     ops(1),
+    warmup(0),
+    pin(""),
+    placement(""),
+    latency(false),
+    json(false),
+    qtable(""),
+    train_algs("OrecEager,OrecLazy,NOrec,RingSW"),
+    train_mixes(""),
+    trials(3),
     time(0),
     running(true),
-    txcount(0)
+    warming(false),
+    txcount(0),
+    warmcount(0)
 {
 }
 
@@ -44,6 +64,82 @@ Config CFG TM_ALIGN(64);
 
 namespace
 {
+  /**
+   *  Each thread's results.  Threads allocate their own, so that the
+   *  histograms are local to them.
+   */
+  struct thread_result_t
+  {
+      uint64_t            txns;         // transactions while timing
+      stm::latency_hist_t latency;      // ticks per transaction, with -L
+
+      thread_result_t() : txns(0), latency() { }
+  };
+
+  thread_result_t* results[256];
+
+  /*** how the program was invoked, to name the rows of a qtable */
+  std::string progname;
+
+  /**
+   *  Training (-Q) runs many experiments on one set of threads: thread 0
+   *  starts a round by bumping round_gen, and the first round_threads
+   *  threads take part in it.  A round with no threads ends the training.
+   */
+  volatile uint32_t round_gen = 0;
+  volatile uint32_t round_threads = 0;
+  volatile uint32_t round_done = 0;
+
+  /*** cores from -P or -T, in the order threads are placed on them */
+  std::vector<int> cores;
+
+  /*** where a cpu sits, for -T */
+  struct cpu_info_t
+  {
+      int cpu;
+      int socket;                       // physical package
+      int core;                         // index of its core in the socket
+      int rank;                         // index of the cpu in its core
+  };
+
+  /*** fill one socket, then the next, with a core's siblings together */
+  bool compact_order(const cpu_info_t& a, const cpu_info_t& b)
+  {
+      if (a.socket != b.socket) return a.socket < b.socket;
+      if (a.core != b.core)     return a.core < b.core;
+      return a.rank < b.rank;
+  }
+
+  /*** alternate sockets, and use every core before any second sibling */
+  bool scatter_order(const cpu_info_t& a, const cpu_info_t& b)
+  {
+      if (a.rank != b.rank)     return a.rank < b.rank;
+      if (a.core != b.core)     return a.core < b.core;
+      return a.socket < b.socket;
+  }
+
+#if !defined(ITM)
+  /*** libstm's counters when timing starts and ends (not for icc's libitm) */
+  stm::stats_t stats_start, stats_end;
+#endif
+
+  /*** the first line of a sysfs file, or "" if it can't be read */
+  std::string read_sysfs(const std::string& path)
+  {
+      std::ifstream f(path.c_str());
+      std::string line;
+      std::getline(f, line);
+      return line;
+  }
+
+  /*** a value from a cpu's topology directory in sysfs, or -1 */
+  int cpu_topology(int cpu, const char* what)
+  {
+      std::ostringstream path;
+      path << "/sys/devices/system/cpu/cpu" << cpu << "/topology/" << what;
+      std::string value = read_sysfs(path.str());
+      return value.empty() ? -1 : atoi(value.c_str());
+  }
 
   /**
    * Print benchmark configuration output
@@ -63,6 +159,93 @@ namespace
                 << std::endl;
   }
 
+  /*** write s as a json string */
+  void json_string(std::ostream& os, const std::string& s)
+  {
+      os << '"';
+      for (size_t i = 0; i < s.size(); ++i) {
+          if (s[i] == '"' || s[i] == '\\')
+              os << '\\';
+          os << s[i];
+      }
+      os << '"';
+  }
+
+  /**
+   *  Print the configuration and results as one json object, on one line,
+   *  for tools that want more than the csv line has: per-thread throughput,
+   *  latency percentiles (with -L), and the abort rate.
+   */
+  void dump_json()
+  {
+      std::ostringstream os;
+      os << "{\"alg\": ";
+      json_string(os, TM_GET_ALGNAME());
+      os << ", \"bench\": ";
+      json_string(os, CFG.bmname);
+      os << ", \"R\": " << CFG.lookpct
+         << ", \"d\": " << CFG.duration
+         << ", \"W\": " << CFG.warmup
+         << ", \"p\": " << CFG.threads
+         << ", \"X\": " << CFG.execute
+         << ", \"m\": " << CFG.elements
+         << ", \"S\": " << CFG.sets
+         << ", \"O\": " << CFG.ops
+         << ", \"N\": " << CFG.nops_after_tx
+         << ", \"P\": ";
+      json_string(os, CFG.pin);
+      os << ", \"T\": ";
+      json_string(os, CFG.placement);
+      os << ", \"txns\": " << CFG.txcount
+         << ", \"time_ns\": " << CFG.time
+         << ", \"throughput\": "
+         << (1000000000LL * CFG.txcount) / (CFG.time);
+
+      // the socket of each thread, and how many sockets were used, so that
+      // runs that cross sockets can be told apart
+      std::vector<int> used;
+      os << ", \"thread_socket\": [";
+      for (uint32_t i = 0; i < CFG.threads; ++i) {
+          int socket = cores.empty() ? -1
+                     : cpu_topology(cores[i % cores.size()],
+                                    "physical_package_id");
+          os << (i ? ", " : "") << socket;
+          if (socket >= 0 &&
+              std::find(used.begin(), used.end(), socket) == used.end())
+              used.push_back(socket);
+      }
+      os << "], \"sockets\": " << used.size();
+
+      os << ", \"thread_throughput\": [";
+      for (uint32_t i = 0; i < CFG.threads; ++i)
+          os << (i ? ", " : "")
+             << (1000000000LL * results[i]->txns) / (CFG.time);
+      os << "]";
+
+#if !defined(ITM)
+      uint64_t commits = (stats_end.commits + stats_end.ro_commits)
+                       - (stats_start.commits + stats_start.ro_commits);
+      uint64_t aborts = stats_end.aborts - stats_start.aborts;
+      os << ", \"commits\": " << commits
+         << ", \"aborts\": " << aborts
+         << ", \"abort_rate\": "
+         << ((commits + aborts) ? (double)aborts / (commits + aborts) : 0.0);
+#endif
+
+      if (CFG.latency) {
+          stm::latency_hist_t all;
+          for (uint32_t i = 0; i < CFG.threads; ++i)
+              all.merge(results[i]->latency);
+          os << ", \"latency_ticks\": {\"n\": " << all.count
+             << ", \"p50\": " << all.percentile(50)
+             << ", \"p99\": " << all.percentile(99)
+             << ", \"p999\": " << all.percentile(99.9)
+             << ", \"max\": " << all.max << "}";
+      }
+      os << "}";
+      std::cout << os.str() << std::endl;
+  }
+
   /**
    *  Print usage
    */
@@ -78,9 +261,134 @@ namespace
       std::cerr << "    -B: name of benchmark\n";
       std::cerr << "    -S: number of sets to build (default 1)\n";
       std::cerr << "    -O: operations per transaction (default 1)\n";
+      std::cerr << "    -W: seconds of untimed warmup (default 0)\n";
+      std::cerr << "    -P: pin threads to cores, e.g. 0,2,4-7\n";
+      std::cerr << "    -T: pin threads by topology: compact or scatter\n";
+      std::cerr << "    -L: time each transaction, report percentiles\n";
+      std::cerr << "    -J: also print the results as json\n";
+      std::cerr << "    -Q: train a CBR qtable, appending rows to this file\n";
+      std::cerr << "    -A: algorithms to train on (default "
+                << "OrecEager,OrecLazy,NOrec,RingSW)\n";
+      std::cerr << "    -M: lookup percents to train on, e.g. 33,90 "
+                << "(default -R)\n";
+      std::cerr << "    -K: runs to average per point when training "
+                << "(default 3)\n";
       std::cerr << "    -h: print help (this message)\n\n";
   }
 
+/**
+ *  Parse a cpu list such as "0,2,4-7" (the format of -P, and of sysfs) onto
+ *  the end of out.  Returns false if the list is malformed or empty.
+ */
+bool
+parse_cpu_list(const std::string& list, std::vector<int>& out)
+{
+    const char* p = list.c_str();
+    size_t size = out.size();
+    while (*p) {
+        char* end;
+        long lo = strtol(p, &end, 10);
+        long hi = lo;
+        if (end == p || lo < 0)
+            return false;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+            if (end == p || hi < lo)
+                return false;
+        }
+        for (long c = lo; c <= hi; ++c)
+            out.push_back((int)c);
+        p = end;
+        if (*p == ',')
+            ++p;
+        else if (*p)
+            return false;
+    }
+    return out.size() > size;
+}
+
+/**
+ *  Order the online cpus by their sysfs topology, for -T.  compact packs
+ *  threads onto as few sockets and cores as it can; scatter spreads them
+ *  over every socket, and over every core before doubling up on one.
+ */
+void
+place_by_topology(const std::string& policy)
+{
+    std::vector<int> online;
+    if (!parse_cpu_list(read_sysfs("/sys/devices/system/cpu/online"),
+                        online))
+    {
+        std::cerr << "Can't read the cpu topology from sysfs\n";
+        exit(1);
+    }
+
+    std::vector<cpu_info_t> cpus;
+    for (size_t i = 0; i < online.size(); ++i) {
+        cpu_info_t c;
+        c.cpu    = online[i];
+        c.socket = cpu_topology(c.cpu, "physical_package_id");
+        c.core   = cpu_topology(c.cpu, "core_id");
+        c.rank   = 0;
+        for (size_t j = 0; j < cpus.size(); ++j)
+            if (cpus[j].socket == c.socket && cpus[j].core == c.core)
+                ++c.rank;
+        cpus.push_back(c);
+    }
+
+    // core ids are sparse, so number each socket's cores from zero
+    std::vector<cpu_info_t> sparse(cpus);
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        std::vector<int> below;
+        for (size_t j = 0; j < sparse.size(); ++j)
+            if (sparse[j].socket == sparse[i].socket &&
+                sparse[j].core < sparse[i].core &&
+                std::find(below.begin(), below.end(), sparse[j].core)
+                    == below.end())
+                below.push_back(sparse[j].core);
+        cpus[i].core = (int)below.size();
+    }
+
+    if (policy == "compact")
+        std::sort(cpus.begin(), cpus.end(), compact_order);
+    else if (policy == "scatter")
+        std::sort(cpus.begin(), cpus.end(), scatter_order);
+    else {
+        std::cerr << "Unknown placement for -T: " << policy << "\n";
+        exit(1);
+    }
+    for (size_t i = 0; i < cpus.size(); ++i)
+        cores.push_back(cpus[i].cpu);
+}
+
+/**
+ *  Pin the calling thread to its core from -P or -T.  Threads are placed in
+ *  order, wrapping around if there are more threads than cores.
+ */
+void
+pin_thread(uintptr_t id)
+{
+    if (cores.empty())
+        return;
+    int core = cores[id % cores.size()];
+#if defined(STM_OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+        std::cerr << "Warning: could not pin thread " << id
+                  << " to core " << core << "\n";
+#elif defined(STM_OS_SOLARIS)
+    if (processor_bind(P_LWPID, P_MYID, core, NULL))
+        std::cerr << "Warning: could not pin thread " << id
+                  << " to core " << core << "\n";
+#else
+    if (id == 0)
+        std::cerr << "Warning: -P is not supported on this platform\n";
+#endif
+}
+
 /**
  *  Parse command line arguments
  */
@@ -89,7 +397,7 @@ parseargs(int argc, char** argv)
 {
     // parse the command-line options
     int opt;
-    while ((opt = getopt(argc, argv, "N:d:p:hX:B:m:R:S:O:")) != -1) {
+    while ((opt = getopt(argc, argv, "N:d:p:hX:B:m:R:S:O:W:P:T:LJQ:A:M:K:")) != -1) {
         switch(opt) {
           case 'd': CFG.duration      = strtol(optarg, NULL, 10); break;
           case 'p': CFG.threads       = strtol(optarg, NULL, 10); break;
@@ -99,6 +407,15 @@ parseargs(int argc, char** argv)
           case 'm': CFG.elements      = strtol(optarg, NULL, 10); break;
           case 'S': CFG.sets          = strtol(optarg, NULL, 10); break;
           case 'O': CFG.ops           = strtol(optarg, NULL, 10); break;
+          case 'W': CFG.warmup        = strtol(optarg, NULL, 10); break;
+          case 'P': CFG.pin           = std::string(optarg); break;
+          case 'T': CFG.placement     = std::string(optarg); break;
+          case 'L': CFG.latency       = true; break;
+          case 'J': CFG.json          = true; break;
+          case 'Q': CFG.qtable        = std::string(optarg); break;
+          case 'A': CFG.train_algs    = std::string(optarg); break;
+          case 'M': CFG.train_mixes   = std::string(optarg); break;
+          case 'K': CFG.trials        = strtol(optarg, NULL, 10); break;
           case 'R':
             CFG.lookpct = strtol(optarg, NULL, 10);
             CFG.inspct = (100 - CFG.lookpct)/2 + strtol(optarg, NULL, 10);
@@ -107,6 +424,43 @@ parseargs(int argc, char** argv)
             usage();
         }
     }
+    if (!CFG.pin.empty() && !CFG.placement.empty()) {
+        std::cerr << "Use -P or -T, not both\n";
+        exit(1);
+    }
+    if (!CFG.pin.empty() && !parse_cpu_list(CFG.pin, cores)) {
+        std::cerr << "Bad core list for -P: " << CFG.pin << "\n";
+        exit(1);
+    }
+    if (!CFG.placement.empty())
+        place_by_topology(CFG.placement);
+#if defined(ITM)
+    if (!CFG.qtable.empty()) {
+        std::cerr << "-Q needs libstm's ProfileApp and set_policy\n";
+        exit(1);
+    }
+#endif
+    if (CFG.trials == 0)
+        CFG.trials = 1;
+    if (!CFG.qtable.empty() && CFG.train_algs.find_first_not_of(',') ==
+        std::string::npos)
+    {
+        std::cerr << "-Q needs at least one algorithm in -A\n";
+        exit(1);
+    }
+}
+
+/*** Split a comma-separated list, such as the argument of -A */
+std::vector<std::string>
+split_list(const std::string& list)
+{
+    std::vector<std::string> out;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ','))
+        if (!item.empty())
+            out.push_back(item);
+    return out;
 }
 
 /**
@@ -126,6 +480,24 @@ extern "C" void catch_SIGALRM(int) {
     CFG.running = false;
 }
 
+/*** Signal handler to end the warmup */
+extern "C" void catch_warmup_SIGALRM(int) {
+    CFG.warming = false;
+}
+
+/*** Run one transaction, timing it if -L was given */
+inline void
+test(uintptr_t id, uint32_t* seed, thread_result_t* r)
+{
+    if (!CFG.latency) {
+        bench_test(id, seed);
+        return;
+    }
+    uint64_t start = tick();
+    bench_test(id, seed);
+    r->latency.record(tick() - start);
+}
+
 /**
  *  Support a few lightweight barriers
  */
@@ -139,16 +511,217 @@ barrier(uint32_t which)
     CFENCE;
 }
 
+/**
+ *  Run transactions until the alarm fires, or for the fixed count of -X, and
+ *  return how many ran
+ */
+uint32_t
+run_txns(uintptr_t id, uint32_t* seed, thread_result_t* r)
+{
+    uint32_t count = 0;
+    if (!CFG.execute) {
+        // run txns until alarm fires
+        while (CFG.running) {
+            test(id, seed, r);
+            ++count;
+            nontxnwork(); // some nontx work between txns?
+        }
+    }
+    else {
+        // run fixed number of txns
+        for (uint32_t e = 0; e < CFG.execute; e++) {
+            test(id, seed, r);
+            ++count;
+            nontxnwork(); // some nontx work between txns?
+        }
+    }
+    return count;
+}
+
+/*** Wait for rounds of a training run, and take part in those that need us */
+void
+train_worker(uintptr_t id, uint32_t* seed, thread_result_t* r)
+{
+    uint32_t gen = 0;
+    while (true) {
+        // idle threads yield, so as not to slow the threads being timed
+        while (round_gen == gen)
+            yield_cpu();
+        gen = round_gen;
+        CFENCE;
+        if (!round_threads)
+            return;
+        if (id < round_threads) {
+            uint32_t count = run_txns(id, seed, r);
+            r->txns += count;
+            faa32(&CFG.txcount, count);
+        }
+        fai32(&round_done);
+    }
+}
+
+/**
+ *  Called by thread 0 to run one round of a training run on p threads, and
+ *  return its throughput
+ */
+uint64_t
+train_round(uint32_t p, uint32_t* seed, thread_result_t* r, uint64_t& total)
+{
+    CFG.txcount = 0;
+    round_done = 0;
+    round_threads = p;
+    CFG.running = true;
+    if (!CFG.execute) {
+        signal(SIGALRM, catch_SIGALRM);
+        alarm(CFG.duration);
+    }
+    uint64_t start = getElapsedTime();
+    fai32(&round_gen);
+
+    uint32_t count = run_txns(0, seed, r);
+    r->txns += count;
+    faa32(&CFG.txcount, count);
+    while (round_done != CFG.threads - 1)
+        yield_cpu();
+
+    uint64_t time = getElapsedTime() - start;
+    total += CFG.txcount;
+    return time ? (1000000000LL * CFG.txcount) / time : 0;
+}
+
+#if !defined(ITM)
+/**
+ *  Train a CBR qtable, as demo_train_cbr.pl does, without leaving the
+ *  process: for each workload mix, profile one thread with ProfileAppAvg,
+ *  then for each thread count up to -p, find the algorithm with the best
+ *  average throughput, and append a row for it to the -Q file.  Running each
+ *  benchmark with the same -Q file builds the whole table.
+ */
+void
+train(uint32_t* seed, thread_result_t* r)
+{
+    std::vector<std::string> algs = split_list(CFG.train_algs);
+    std::vector<std::string> mixes = split_list(CFG.train_mixes);
+    if (mixes.empty()) {
+        std::ostringstream R;
+        R << CFG.lookpct;
+        mixes.push_back(R.str());
+    }
+
+    // append to the qtable, starting it with the header that load_qtable
+    // skips if it is new
+    std::ofstream q(CFG.qtable.c_str(), std::ios::app);
+    if (!q) {
+        std::cerr << "Can't open " << CFG.qtable << " for -Q\n";
+        exit(1);
+    }
+    q.seekp(0, std::ios::end);
+    if (q.tellp() == 0)
+        q << "#BM,ALG,threads,read_ro,read_rw_nonraw,read_rw_raw,"
+          << "write_nonwaw,write_waw,txn_time,pct_txtime,roratio\n";
+
+    uint64_t total = 0;
+    uint64_t start = getElapsedTime();
+    for (size_t m = 0; m < mixes.size(); ++m) {
+        CFG.lookpct = strtol(mixes[m].c_str(), NULL, 10);
+        CFG.inspct = (100 - CFG.lookpct)/2 + CFG.lookpct;
+
+        // name the workload the way demo_train_cbr.pl does: the command
+        // line, without spaces
+        std::ostringstream bm;
+        bm << progname.substr(progname.find_last_of('/') + 1)
+           << "-B" << CFG.bmname << "-R" << CFG.lookpct;
+        std::cout << "Training " << bm.str() << "\n";
+
+        // get the single-thread characterization of the workload
+        stm::set_policy("ProfileAppAvg");
+        stm::reset_app_profile();
+        train_round(1, seed, r, total);
+        stm::app_profile_t ap;
+        stm::get_app_profile(ap);
+
+        // now for each thread count, test each alg, and find the best alg
+        for (uint32_t p = 1; p <= CFG.threads; ++p) {
+            std::string bestalg = "Dead";
+            uint64_t bestval = 0;
+            for (size_t a = 0; a < algs.size(); ++a) {
+                stm::set_policy(algs[a].c_str());
+                uint64_t val = 0;
+                for (uint32_t t = 0; t < CFG.trials; ++t)
+                    val += train_round(p, seed, r, total);
+                val /= CFG.trials;
+                std::cout << "  p=" << p << " " << algs[a]
+                          << " throughput=" << val << "\n";
+                if (val > bestval) {
+                    bestval = val;
+                    bestalg = algs[a];
+                }
+            }
+            q << bm.str() << "," << bestalg << "," << p << ","
+              << ap.read_ro << "," << ap.read_rw_nonraw << ","
+              << ap.read_rw_raw << "," << ap.write_nonwaw << ","
+              << ap.write_waw << "," << ap.txn_time << ","
+              << ap.pct_txtime << "," << ap.roratio << "\n";
+        }
+    }
+
+    // release the workers, and report the totals of all rounds
+    round_threads = 0;
+    fai32(&round_gen);
+    CFG.txcount = total;
+    CFG.time = getElapsedTime() - start;
+}
+#endif
+
 /*** Run a timed or fixed-count experiment */
 void
 run(uintptr_t id)
 {
+    // pin before anything else, so that this thread's metadata is
+    // allocated near the core it runs on (main pinned thread 0)
+    if (id != 0)
+        pin_thread(id);
+
     // create a transactional context (repeat calls from thread 0 are OK)
     TM_THREAD_INIT();
+    thread_result_t* r = new thread_result_t();
+    results[id] = r;
 
-    // wait until all threads created, then set alarm and read timer
+    uint32_t seed = id; // not everyone needs a seed, but we have to support it
+
+    // wait until all threads created, then run the untimed warmup, if any
     barrier(0);
+#if !defined(ITM)
+    if (!CFG.qtable.empty()) {
+        if (id == 0)
+            train(&seed, r);
+        else
+            train_worker(id, &seed, r);
+        return;
+    }
+#endif
+    if (CFG.warmup) {
+        if (id == 0) {
+            CFG.warming = true;
+            signal(SIGALRM, catch_warmup_SIGALRM);
+            alarm(CFG.warmup);
+        }
+        barrier(3);
+        uint32_t warm = 0;
+        while (CFG.warming) {
+            bench_test(id, &seed);
+            ++warm;
+            nontxnwork();
+        }
+        faa32(&CFG.warmcount, warm);
+        barrier(4);
+    }
+
+    // set alarm and read timer
     if (id == 0) {
+#if !defined(ITM)
+        stats_start = stm::get_stats();
+#endif
         if (!CFG.execute) {
             signal(SIGALRM, catch_SIGALRM);
             alarm(CFG.duration);
@@ -159,31 +732,19 @@ run(uintptr_t id)
     // wait until read of start timer finishes, then start transactios
     barrier(1);
 
-    uint32_t count = 0;
-    uint32_t seed = id; // not everyone needs a seed, but we have to support it
-    if (!CFG.execute) {
-        // run txns until alarm fires
-        while (CFG.running) {
-            bench_test(id, &seed);
-            ++count;
-            nontxnwork(); // some nontx work between txns?
-        }
-    }
-    else {
-        // run fixed number of txns
-        for (uint32_t e = 0; e < CFG.execute; e++) {
-            bench_test(id, &seed);
-            ++count;
-            nontxnwork(); // some nontx work between txns?
-        }
-    }
+    uint32_t count = run_txns(id, &seed, r);
 
     // wait until all txns finish, then get time
     barrier(2);
-    if (id == 0)
+    if (id == 0) {
         CFG.time = getElapsedTime() - CFG.time;
+#if !defined(ITM)
+        stats_end = stm::get_stats();
+#endif
+    }
 
     // add this thread's count to an accumulator
+    r->txns = count;
     faa32(&CFG.txcount, count);
 }
 
@@ -210,12 +771,21 @@ run_wrapper(void* i)
  *  the experiments, verify results, print results, and shut down the system
  */
 int main(int argc, char** argv) {
+    progname = argv[0];
     parseargs(argc, argv);
     bench_reparse();
+    pin_thread(0);
     TM_SYS_INIT();
     TM_THREAD_INIT();
     bench_init();
 
+#if !defined(ITM)
+    // when training, start in the first algorithm to train, so that an
+    // adaptive STM_CONFIG can't begin profiling as the threads are created
+    if (!CFG.qtable.empty())
+        stm::set_policy(split_list(CFG.train_algs)[0].c_str());
+#endif
+
     void* args[256];
     pthread_t tid[256];
 
@@ -247,6 +817,8 @@ int main(int argc, char** argv) {
     std::cout << "Verification: " << (v ? "Passed" : "Failed") << "\n";
 
     dump_csv();
+    if (CFG.json)
+        dump_json();
 
     // And call sys shutdown stuff
     TM_SYS_SHUTDOWN();
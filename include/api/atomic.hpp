@@ -0,0 +1,238 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  A function-based alternative to the TM_BEGIN/TM_END macros of the library
+ *  API.  A transaction is a function object that takes an stm::Tx&, and
+ *  stm::atomic runs it until it commits:
+ *
+ *      stm::tm_var<int> counter;
+ *      ...
+ *      int v = stm::atomic([&](stm::Tx& tx) {
+ *          int c = counter.load(tx) + 1;
+ *          counter.store(tx, c);
+ *          return c;
+ *      });
+ *
+ *  The checkpoint is taken inside of stm::atomic, and every attempt calls
+ *  the body again, so the body's locals start over on a retry and never
+ *  need to be volatile.  The body can return a value, which stm::atomic
+ *  returns after the commit.  Since each body instantiates its own
+ *  stm::atomic, the body (and, in a single-algorithm build, its barriers)
+ *  can be inlined there.
+ *
+ *  Everything goes through the same TxThread and algorithm tables as the
+ *  macro API, so the two can be mixed, and nest (by subsumption) in either
+ *  order.  As with the macros, the body must not throw, and writes to
+ *  captured nontransactional variables are not undone on abort.
+ *
+ *  With a pre-C++11 compiler the body is a function object whose
+ *  result_type typedef names its return type.
+ */
+
+#ifndef API_ATOMIC_HPP__
+#define API_ATOMIC_HPP__
+
+#include <api/library.hpp>
+
+namespace stm
+{
+  /**
+   *  The handle a transaction body gets.  It is only valid for the attempt
+   *  that it was made for.
+   */
+  class Tx
+  {
+      TxThread* tx;
+
+    public:
+      explicit Tx(TxThread* t) : tx(t) { }
+
+      /*** the thread's descriptor, for code that uses TM_ARG/TM_PARAM */
+      TxThread* thread() const { return tx; }
+
+      /*** read and write any location, as TM_READ and TM_WRITE do */
+      template <typename T>
+      T read(T* addr) const { return stm_read(addr, tx); }
+
+      template <typename T>
+      void write(T* addr, T val) const { stm_write(addr, val, tx); }
+
+      /*** transactional allocation, as TM_ALLOC and TM_FREE */
+      void* alloc(size_t size) const { return tx_alloc(size); }
+      void free(void* p) const { tx_free(p); }
+
+      /*** handlers for the end of the transaction (see stm::on_commit) */
+      void on_commit(void (*f)(void*), void* arg) const
+      {
+          stm::on_commit(f, arg);
+      }
+
+      void on_abort(void (*f)(void*), void* arg) const
+      {
+          stm::on_abort(f, arg);
+      }
+
+      /*** abort this attempt and run the body again */
+      void restart() const { stm::restart(); }
+  };
+
+  /**
+   *  A shared variable whose transactional loads and stores go through the
+   *  DISPATCH templates, so the usual granularity rules for sub-word types
+   *  apply.  unsafe_load and unsafe_store are for nontransactional code.
+   */
+  template <typename T>
+  class tm_var
+  {
+      T val;
+
+    public:
+      tm_var() : val() { }
+      tm_var(T v) : val(v) { }
+
+      T load(const Tx& tx) const
+      {
+          return DISPATCH<T, sizeof(T)>::read(const_cast<T*>(&val),
+                                              tx.thread());
+      }
+
+      void store(const Tx& tx, T v)
+      {
+          DISPATCH<T, sizeof(T)>::write(&val, v, tx.thread());
+      }
+
+      T unsafe_load() const { return val; }
+      void unsafe_store(T v) { val = v; }
+
+      /*** for code that mixes tm_var with TM_READ/TM_WRITE */
+      T* address() { return &val; }
+  };
+
+  /**
+   *  A counter that transactions add to without conflicting.  Each add is
+   *  deferred to commit (see stm::tx_add), and lands in one of several
+   *  cache-line-sized shards, picked by thread id, so that the commit-time
+   *  fetch-and-adds don't contend either.  T must be a word-sized integer.
+   *
+   *  load() sums the shards, plus this transaction's own pending adds.  It
+   *  is not ordered with concurrent adds, so it suits statistics and
+   *  heuristics rather than decisions that must be serializable.
+   */
+  template <typename T>
+  class tm_adder
+  {
+      pad_word_t* shards;
+      uint32_t    mask;
+
+      tm_adder(const tm_adder&);
+      tm_adder& operator=(const tm_adder&);
+
+    public:
+      /*** nshards is rounded up to a power of two */
+      explicit tm_adder(T v = T(), uint32_t nshards = 16)
+          : shards(NULL), mask(0)
+      {
+          uint32_t n = 1;
+          while (n < nshards)
+              n <<= 1;
+          shards = new pad_word_t[n];
+          mask = n - 1;
+          unsafe_store(v);
+      }
+
+      ~tm_adder() { delete[] shards; }
+
+      void add(const Tx& tx, T delta)
+      {
+          TxThread* t = tx.thread();
+          tx_add_word(t, &shards[t->id & mask].val, (uintptr_t)delta);
+      }
+
+      T load(const Tx& tx) const
+      {
+          TxThread* t = tx.thread();
+          return (T)(unsafe_load()
+                     + (T)pending_adds(t, &shards[t->id & mask].val));
+      }
+
+      T unsafe_load() const
+      {
+          uintptr_t sum = 0;
+          for (uint32_t i = 0; i <= mask; ++i)
+              sum += shards[i].val;
+          return (T)sum;
+      }
+
+      void unsafe_store(T v)
+      {
+          shards[0].val = (uintptr_t)v;
+          for (uint32_t i = 1; i <= mask; ++i)
+              shards[i].val = 0;
+      }
+  };
+
+  /**
+   *  Run one transaction.  NOINLINE keeps the checkpoint in this frame,
+   *  which is what lets the body's locals live in their own frame.  (g++
+   *  won't inline a returns_twice caller anyway.)
+   */
+  template <typename R, typename F>
+  struct ATOMIC
+  {
+      NOINLINE
+      static R run(F& f)
+      {
+          TxThread* tx = (TxThread*)Self;
+          STM_CHECKPOINT_T checkpoint;
+          uint32_t abort_flags = STM_CHECKPOINT(checkpoint);
+          begin(tx, &checkpoint, abort_flags);
+          CFENCE;
+          Tx handle(tx);
+          R result = f(handle);
+          commit(tx);
+          return result;
+      }
+  };
+
+  /*** a body with no result */
+  template <typename F>
+  struct ATOMIC<void, F>
+  {
+      NOINLINE
+      static void run(F& f)
+      {
+          TxThread* tx = (TxThread*)Self;
+          STM_CHECKPOINT_T checkpoint;
+          uint32_t abort_flags = STM_CHECKPOINT(checkpoint);
+          begin(tx, &checkpoint, abort_flags);
+          CFENCE;
+          Tx handle(tx);
+          f(handle);
+          commit(tx);
+      }
+  };
+
+#if __cplusplus >= 201103L
+  template <typename F>
+  inline auto atomic(F f) -> decltype(f(*(Tx*)0))
+  {
+      return ATOMIC<decltype(f(*(Tx*)0)), F>::run(f);
+  }
+#else
+  template <typename F>
+  inline typename F::result_type atomic(F f)
+  {
+      return ATOMIC<typename F::result_type, F>::run(f);
+  }
+#endif
+} // namespace stm
+
+#endif // API_ATOMIC_HPP__
@@ -0,0 +1,864 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  Transactionally boosted containers for the library API.
+ *
+ *  A boosted container does not instrument its own memory.  Each operation
+ *  runs immediately on a thread-safe base structure, under an abstract lock
+ *  that the transaction holds until it commits or aborts.  The operation
+ *  registers its inverse as an abort handler (see stm::on_abort), so an
+ *  abort rolls the base structure back before the locks are released.  Two
+ *  transactions conflict only when their operations do not commute, e.g.
+ *  when they touch the same key, so there are no false conflicts on the
+ *  internals of the structure (buckets, tree nodes, the heap array, ...):
+ *
+ *      stm::BoostedHashMap<long, long> map;
+ *      ...
+ *      stm::atomic([&](stm::Tx& tx) {
+ *          long v;
+ *          if (map.erase(tx, k1, &v))
+ *              map.insert(tx, k2, v);
+ *      });
+ *
+ *  Abstract locks are never waited on for long: a transaction that cannot
+ *  get one aborts (with ABORT_LOCKED), which releases the locks it holds, so
+ *  boosted operations cannot deadlock.  From TM_BEGIN/TM_END code, pass
+ *  stm::Tx(tx) as the handle.
+ *
+ *  The containers are:
+ *
+ *    BoostedHashMap<K, V, Hash>      : per-key locks, striped bucket locks
+ *    BoostedMap<K, V, Compare, Hash> : per-key locks, std::map base
+ *    BoostedPriorityQueue<T, Compare>: push is shared, top/pop exclusive
+ *    BoostedQueue<T>                 : dequeuers exclusive, enqueues shared
+ *
+ *  Keys are mapped to abstract locks with Hash, which by default accepts any
+ *  type that converts to uintptr_t.  Values are copied into and out of the
+ *  containers; V and T must be copyable without side effects, since undo
+ *  records hold copies.
+ *
+ *  NB: a boosted container is only isolated from other boosted operations.
+ *      Its effects are visible to nontransactional code (e.g., the unsafe_
+ *      methods) before commit, and an update is not undone if the abort
+ *      handler is never run, as with the itm shim's abort mechanism.
+ */
+
+#ifndef API_BOOSTING_HPP__
+#define API_BOOSTING_HPP__
+
+#include <map>
+#include <set>
+#include <deque>
+#include <api/atomic.hpp>
+#include <stm/lib_globals.hpp>
+#include <common/locks.hpp>
+
+namespace stm
+{
+  namespace boosting
+  {
+    /**
+     *  How many times we spin64() on an abstract lock before aborting.  The
+     *  holder usually has only a few instructions left, but might also be
+     *  waiting on a lock that we hold.
+     */
+    static const uint32_t LOCK_SPINS = 256;
+
+    /*** abort because another transaction holds an abstract lock */
+    NORETURN
+    inline void conflict(TxThread* tx, const volatile void* lock,
+                         uintptr_t owner)
+    {
+        tx_abort(tx, ABORT_LOCKED, lock, (uint32_t)owner);
+    }
+
+    /**
+     *  Back off after the i'th failed try for an abstract lock, or abort if
+     *  we have tried long enough.  An irrevocable transaction (including
+     *  any CGL or TML writer) can't abort, but it never has to: the holder
+     *  has either committed and is about to run its handlers, or is a TML
+     *  reader that will abort once it notices the writer.
+     */
+    inline void wait(TxThread* tx, uint32_t i, const volatile void* lock,
+                     uintptr_t owner)
+    {
+        if (i >= LOCK_SPINS && !is_irrevoc(*tx))
+            conflict(tx, lock, owner);
+        spin64();
+    }
+
+    /*** the default key hash, for integers, pointers, and enums */
+    template <typename K>
+    struct hash
+    {
+        size_t operator()(const K& k) const
+        {
+            // the 64-bit finalizer from MurmurHash3
+            uint64_t x = (uint64_t)(uintptr_t)k;
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            return (size_t)x;
+        }
+    };
+
+    /*** scoped ownership of a base structure's TATAS lock */
+    class Guard
+    {
+        tatas_lock_t* lock;
+      public:
+        explicit Guard(tatas_lock_t* l) : lock(l) { tatas_acquire(lock); }
+        ~Guard() { tatas_release(lock); }
+    };
+
+    /*** release an abstract lock word, from a commit or abort handler */
+    inline void release(void* lock)
+    {
+        CFENCE;
+        *(volatile uintptr_t*)lock = 0;
+    }
+
+    inline void release_shared(void* flag)
+    {
+        CFENCE;
+        *(volatile uint8_t*)flag = 0;
+    }
+
+    /**
+     *  A table of exclusive abstract locks, indexed by key hash.  Each lock
+     *  word holds the id of the transaction that owns it, or 0.  Keys that
+     *  share a stripe share a lock, which is a (rare) false conflict but
+     *  never a missed one.
+     */
+    class LockTable
+    {
+        volatile uintptr_t* owners;
+        size_t              mask;
+
+        /*** the table can't be copied */
+        LockTable(const LockTable&);
+        LockTable& operator=(const LockTable&);
+
+      public:
+        /*** stripes is rounded up to a power of two */
+        explicit LockTable(size_t stripes)
+            : owners(NULL), mask(0)
+        {
+            size_t n = 1;
+            while (n < stripes)
+                n <<= 1;
+            owners = new uintptr_t[n]();
+            mask = n - 1;
+        }
+
+        ~LockTable() { delete[] owners; }
+
+        /**
+         *  Get the lock for a key hash, and arrange for it to be released
+         *  when the transaction commits or aborts.  Re-acquiring is free.
+         */
+        void acquire(TxThread* tx, size_t h)
+        {
+            volatile uintptr_t* l = &owners[h & mask];
+            uintptr_t o = *l;
+            if (o == tx->id)
+                return;
+            for (uint32_t i = 0; ; ++i) {
+                if (o == 0 && bcasptr(l, (uintptr_t)0, (uintptr_t)tx->id))
+                    break;
+                wait(tx, i, l, o);
+                o = *l;
+            }
+            on_commit(release, (void*)l);
+            on_abort(release, (void*)l);
+        }
+    };
+
+    /**
+     *  A reader/writer abstract lock.  Any number of transactions can hold
+     *  it in shared mode, or one can hold it in exclusive mode (and also in
+     *  shared mode).  Readers announce themselves with a per-thread flag, so
+     *  shared acquisitions don't write a common word.
+     */
+    class SharedLock
+    {
+        volatile uintptr_t writer;
+        volatile uint8_t   readers[MAX_THREADS + 1];
+
+        /*** the lock can't be copied */
+        SharedLock(const SharedLock&);
+        SharedLock& operator=(const SharedLock&);
+
+      public:
+        SharedLock() : writer(0) {
+            for (uint32_t i = 0; i <= MAX_THREADS; ++i)
+                readers[i] = 0;
+        }
+
+        void acquire_shared(TxThread* tx)
+        {
+            volatile uint8_t* flag = &readers[tx->id];
+            if (*flag || writer == tx->id)
+                return;
+            for (uint32_t i = 0; ; ++i) {
+                *flag = 1;
+                WBR;
+                uintptr_t w = writer;
+                if (w == 0)
+                    break;
+                *flag = 0;
+                wait(tx, i, &writer, w);
+            }
+            on_commit(release_shared, (void*)flag);
+            on_abort(release_shared, (void*)flag);
+        }
+
+        void acquire_exclusive(TxThread* tx)
+        {
+            uintptr_t w = writer;
+            if (w == tx->id)
+                return;
+            for (uint32_t i = 0; ; ++i) {
+                if (w == 0 && bcasptr(&writer, (uintptr_t)0,
+                                      (uintptr_t)tx->id))
+                    break;
+                wait(tx, i, &writer, w);
+                w = writer;
+            }
+            // the handlers go in before we wait, so that an abort below
+            // also gives up the writer word
+            on_commit(release, (void*)&writer);
+            on_abort(release, (void*)&writer);
+            WBR;
+            // wait for the readers (other than us) to drain
+            for (uint32_t r = 1; r <= MAX_THREADS; ++r) {
+                if (r == tx->id)
+                    continue;
+                for (uint32_t i = 0; readers[r]; ++i)
+                    wait(tx, i, &readers[r], r);
+            }
+        }
+    };
+
+    /**
+     *  The base structure for BoostedHashMap: a fixed array of buckets, each
+     *  a list protected by its own TATAS lock.
+     */
+    template <typename K, typename V, typename Hash>
+    class HashBase
+    {
+        struct node_t
+        {
+            K       key;
+            V       val;
+            node_t* next;
+            node_t(const K& k, const V& v, node_t* n)
+                : key(k), val(v), next(n) { }
+        };
+
+        struct bucket_t
+        {
+            tatas_lock_t lock;
+            node_t*      head;
+        };
+
+        bucket_t* buckets;
+        size_t    mask;
+
+        HashBase(const HashBase&);
+        HashBase& operator=(const HashBase&);
+
+        bucket_t& bucket(size_t h) { return buckets[h & mask]; }
+
+      public:
+        explicit HashBase(size_t nbuckets) : buckets(NULL), mask(0)
+        {
+            size_t n = 1;
+            while (n < nbuckets)
+                n <<= 1;
+            buckets = new bucket_t[n]();
+            mask = n - 1;
+        }
+
+        ~HashBase()
+        {
+            for (size_t i = 0; i <= mask; ++i)
+                while (node_t* n = buckets[i].head) {
+                    buckets[i].head = n->next;
+                    delete n;
+                }
+            delete[] buckets;
+        }
+
+        bool find(size_t h, const K& k, V* out)
+        {
+            bucket_t& b = bucket(h);
+            Guard g(&b.lock);
+            for (node_t* n = b.head; n; n = n->next)
+                if (n->key == k) {
+                    if (out)
+                        *out = n->val;
+                    return true;
+                }
+            return false;
+        }
+
+        /*** set k to v; returns true and the old value if k was present */
+        bool put(size_t h, const K& k, const V& v, V* old)
+        {
+            bucket_t& b = bucket(h);
+            Guard g(&b.lock);
+            for (node_t* n = b.head; n; n = n->next)
+                if (n->key == k) {
+                    if (old)
+                        *old = n->val;
+                    n->val = v;
+                    return true;
+                }
+            b.head = new node_t(k, v, b.head);
+            return false;
+        }
+
+        bool erase(size_t h, const K& k, V* old)
+        {
+            bucket_t& b = bucket(h);
+            Guard g(&b.lock);
+            for (node_t** p = &b.head; *p; p = &(*p)->next)
+                if ((*p)->key == k) {
+                    node_t* n = *p;
+                    if (old)
+                        *old = n->val;
+                    *p = n->next;
+                    delete n;
+                    return true;
+                }
+            return false;
+        }
+
+        template <typename F>
+        void for_each(F& f)
+        {
+            for (size_t i = 0; i <= mask; ++i) {
+                Guard g(&buckets[i].lock);
+                for (node_t* n = buckets[i].head; n; n = n->next)
+                    f(n->key, n->val);
+            }
+        }
+    };
+
+    /*** The base structure for BoostedMap: a std::map behind a TATAS lock */
+    template <typename K, typename V, typename Compare>
+    class TreeBase
+    {
+        typedef std::map<K, V, Compare> map_t;
+
+        tatas_lock_t lock;
+        map_t        map;
+
+      public:
+        explicit TreeBase(size_t) : lock(0), map() { }
+
+        bool find(size_t, const K& k, V* out)
+        {
+            Guard g(&lock);
+            typename map_t::iterator i = map.find(k);
+            if (i == map.end())
+                return false;
+            if (out)
+                *out = i->second;
+            return true;
+        }
+
+        bool put(size_t, const K& k, const V& v, V* old)
+        {
+            Guard g(&lock);
+            std::pair<typename map_t::iterator, bool> r =
+                map.insert(std::make_pair(k, v));
+            if (r.second)
+                return false;
+            if (old)
+                *old = r.first->second;
+            r.first->second = v;
+            return true;
+        }
+
+        bool erase(size_t, const K& k, V* old)
+        {
+            Guard g(&lock);
+            typename map_t::iterator i = map.find(k);
+            if (i == map.end())
+                return false;
+            if (old)
+                *old = i->second;
+            map.erase(i);
+            return true;
+        }
+
+        template <typename F>
+        void for_each(F& f)
+        {
+            Guard g(&lock);
+            for (typename map_t::iterator i = map.begin(); i != map.end(); ++i)
+                f(i->first, i->second);
+        }
+    };
+
+    /**
+     *  The transactional half of the two maps.  Every operation locks its
+     *  key, so operations on different keys commute and never conflict.
+     *  Reads lock too: a reader must not see a value that an uncommitted
+     *  writer might still undo.
+     */
+    template <typename K, typename V, typename Base, typename Hash>
+    class BoostedMapImpl
+    {
+        /*** the inverse of one update */
+        struct undo_t
+        {
+            BoostedMapImpl* map;
+            size_t          h;
+            K               key;
+            V               val;
+            bool            had;   // key was present before the update
+        };
+
+        Base      base;
+        LockTable locks;
+        Hash      hasher;
+
+        static void undo(void* arg)
+        {
+            undo_t* u = static_cast<undo_t*>(arg);
+            if (u->had)
+                u->map->base.put(u->h, u->key, u->val, NULL);
+            else
+                u->map->base.erase(u->h, u->key, NULL);
+            delete u;
+        }
+
+        static void forget(void* arg) { delete static_cast<undo_t*>(arg); }
+
+        void log(size_t h, const K& k, const V& old, bool had)
+        {
+            undo_t* u = new undo_t();
+            u->map = this;
+            u->h = h;
+            u->key = k;
+            u->val = old;
+            u->had = had;
+            on_abort(undo, u);
+            on_commit(forget, u);
+        }
+
+        BoostedMapImpl(const BoostedMapImpl&);
+        BoostedMapImpl& operator=(const BoostedMapImpl&);
+
+      public:
+        BoostedMapImpl(size_t nbuckets, size_t stripes)
+            : base(nbuckets), locks(stripes), hasher() { }
+
+        /*** look up k; returns false if absent */
+        bool get(const Tx& tx, const K& k, V* out = NULL)
+        {
+            size_t h = hasher(k);
+            locks.acquire(tx.thread(), h);
+            return base.find(h, k, out);
+        }
+
+        /*** add k->v if k is absent; returns false if k was present */
+        bool insert(const Tx& tx, const K& k, const V& v)
+        {
+            size_t h = hasher(k);
+            locks.acquire(tx.thread(), h);
+            V old = V();
+            if (base.find(h, k, &old))
+                return false;
+            base.put(h, k, v, NULL);
+            log(h, k, old, false);
+            return true;
+        }
+
+        /*** set k->v; returns true (and the old value) if k was present */
+        bool put(const Tx& tx, const K& k, const V& v, V* prev = NULL)
+        {
+            size_t h = hasher(k);
+            locks.acquire(tx.thread(), h);
+            V old = V();
+            bool had = base.put(h, k, v, &old);
+            log(h, k, old, had);
+            if (had && prev)
+                *prev = old;
+            return had;
+        }
+
+        /*** remove k; returns true (and the old value) if k was present */
+        bool erase(const Tx& tx, const K& k, V* prev = NULL)
+        {
+            size_t h = hasher(k);
+            locks.acquire(tx.thread(), h);
+            V old = V();
+            if (!base.erase(h, k, &old))
+                return false;
+            log(h, k, old, true);
+            if (prev)
+                *prev = old;
+            return true;
+        }
+
+        /**
+         *  Nontransactional access, for initialization and for checking
+         *  results.  unsafe_for_each calls f(key, value) for every entry,
+         *  and returns f.
+         */
+        void unsafe_put(const K& k, const V& v)
+        {
+            base.put(hasher(k), k, v, NULL);
+        }
+
+        template <typename F>
+        F unsafe_for_each(F f)
+        {
+            base.for_each(f);
+            return f;
+        }
+    };
+  } // namespace stm::boosting
+
+  /**
+   *  A hash map.  The bucket count is fixed at construction; the abstract
+   *  lock table defaults to the same size.
+   */
+  template <typename K, typename V, typename Hash = boosting::hash<K> >
+  class BoostedHashMap
+      : public boosting::BoostedMapImpl<K, V,
+                                        boosting::HashBase<K, V, Hash>, Hash>
+  {
+    public:
+      explicit BoostedHashMap(size_t nbuckets = 1024, size_t stripes = 0)
+          : boosting::BoostedMapImpl<K, V, boosting::HashBase<K, V, Hash>,
+                                     Hash>(nbuckets,
+                                           stripes ? stripes : nbuckets)
+      { }
+  };
+
+  /**
+   *  An ordered map.  Its base is a std::map under one short-held TATAS
+   *  lock; unsafe_for_each visits the entries in key order.  There are no
+   *  transactional range operations, since those would need range locks.
+   */
+  template <typename K, typename V, typename Compare = std::less<K>,
+            typename Hash = boosting::hash<K> >
+  class BoostedMap
+      : public boosting::BoostedMapImpl<K, V,
+                                        boosting::TreeBase<K, V, Compare>,
+                                        Hash>
+  {
+    public:
+      explicit BoostedMap(size_t stripes = 1024)
+          : boosting::BoostedMapImpl<K, V, boosting::TreeBase<K, V, Compare>,
+                                     Hash>(0, stripes)
+      { }
+  };
+
+  /**
+   *  A priority queue (smallest first, by Compare).  Pushes commute with
+   *  each other, so they share the abstract lock; top and pop depend on
+   *  every push, so they take it exclusively.  The base is a std::multiset,
+   *  so that an aborted push can remove an element equal to the one it
+   *  added.  (Not necessarily the same node: if the transaction popped it,
+   *  undoing the pop inserted a new one.)
+   */
+  template <typename T, typename Compare = std::less<T> >
+  class BoostedPriorityQueue
+  {
+      typedef std::multiset<T, Compare> set_t;
+
+      struct undo_push_t
+      {
+          BoostedPriorityQueue* q;
+          T                     val;
+      };
+
+      struct undo_pop_t
+      {
+          BoostedPriorityQueue* q;
+          T                     val;
+      };
+
+      boosting::SharedLock lock;
+      tatas_lock_t         base_lock;
+      set_t                base;
+
+      static void undo_push(void* arg)
+      {
+          undo_push_t* u = static_cast<undo_push_t*>(arg);
+          {
+              boosting::Guard g(&u->q->base_lock);
+              u->q->base.erase(u->q->base.find(u->val));
+          }
+          delete u;
+      }
+
+      static void undo_pop(void* arg)
+      {
+          undo_pop_t* u = static_cast<undo_pop_t*>(arg);
+          {
+              boosting::Guard g(&u->q->base_lock);
+              u->q->base.insert(u->val);
+          }
+          delete u;
+      }
+
+      static void forget_push(void* arg)
+      {
+          delete static_cast<undo_push_t*>(arg);
+      }
+
+      static void forget_pop(void* arg)
+      {
+          delete static_cast<undo_pop_t*>(arg);
+      }
+
+      BoostedPriorityQueue(const BoostedPriorityQueue&);
+      BoostedPriorityQueue& operator=(const BoostedPriorityQueue&);
+
+    public:
+      BoostedPriorityQueue() : lock(), base_lock(0), base() { }
+
+      void push(const Tx& tx, const T& v)
+      {
+          lock.acquire_shared(tx.thread());
+          undo_push_t* u = new undo_push_t();
+          u->q = this;
+          u->val = v;
+          {
+              boosting::Guard g(&base_lock);
+              base.insert(v);
+          }
+          on_abort(undo_push, u);
+          on_commit(forget_push, u);
+      }
+
+      /*** copy out the smallest element; returns false if empty */
+      bool top(const Tx& tx, T* out)
+      {
+          lock.acquire_exclusive(tx.thread());
+          boosting::Guard g(&base_lock);
+          if (base.empty())
+              return false;
+          *out = *base.begin();
+          return true;
+      }
+
+      /*** remove the smallest element; returns false if empty */
+      bool pop(const Tx& tx, T* out = NULL)
+      {
+          lock.acquire_exclusive(tx.thread());
+          undo_pop_t* u;
+          {
+              boosting::Guard g(&base_lock);
+              if (base.empty())
+                  return false;
+              u = new undo_pop_t();
+              u->q = this;
+              u->val = *base.begin();
+              base.erase(base.begin());
+          }
+          if (out)
+              *out = u->val;
+          on_abort(undo_pop, u);
+          on_commit(forget_pop, u);
+          return true;
+      }
+
+      /*** nontransactional access, for initialization and checking */
+      void unsafe_push(const T& v)
+      {
+          boosting::Guard g(&base_lock);
+          base.insert(v);
+      }
+
+      size_t unsafe_size()
+      {
+          boosting::Guard g(&base_lock);
+          return base.size();
+      }
+  };
+
+  /**
+   *  A FIFO queue.  An enqueue is buffered in a transaction-private list,
+   *  which the commit handler appends to the base, so elements join the
+   *  queue in commit order.  Enqueues commute with each other, so they
+   *  share the tail lock.  Dequeues do not commute with each other, so they
+   *  hold one exclusive head lock.  A dequeue from a nonempty base commutes
+   *  with enqueues, but a dequeue that finds the base empty does not: it
+   *  takes the tail lock exclusively, which waits out pending enqueues and
+   *  holds off new ones, and then it can take from this transaction's own
+   *  buffered elements.
+   */
+  template <typename T>
+  class BoostedQueue
+  {
+      /*** one transaction's buffered enqueues */
+      struct pending_t
+      {
+          BoostedQueue* q;
+          uintptr_t     id;
+          std::deque<T> vals;
+      };
+
+      struct undo_t
+      {
+          BoostedQueue* q;
+          T             val;
+      };
+
+      boosting::LockTable  head;       // the dequeue lock (one stripe)
+      boosting::SharedLock tail;
+      tatas_lock_t         base_lock;
+      std::deque<T>        base;
+      pending_t*           pending[MAX_THREADS + 1];
+
+      /*** pending handlers: commit appends the list to the base */
+      static void flush(void* arg)
+      {
+          pending_t* p = static_cast<pending_t*>(arg);
+          if (!p->vals.empty()) {
+              boosting::Guard g(&p->q->base_lock);
+              p->q->base.insert(p->q->base.end(), p->vals.begin(),
+                                p->vals.end());
+          }
+          p->q->pending[p->id] = NULL;
+          delete p;
+      }
+
+      static void drop(void* arg)
+      {
+          pending_t* p = static_cast<pending_t*>(arg);
+          p->q->pending[p->id] = NULL;
+          delete p;
+      }
+
+      /**
+       *  Get this transaction's pending list.  It must be created before
+       *  we take the tail lock in either mode, so that flush runs before
+       *  the lock is released: a dequeuer that gets the lock next must see
+       *  our elements.
+       */
+      pending_t* mine(TxThread* self)
+      {
+          pending_t* p = pending[self->id];
+          if (!p) {
+              p = new pending_t();
+              p->q = this;
+              p->id = self->id;
+              pending[self->id] = p;
+              on_commit(flush, p);
+              on_abort(drop, p);
+          }
+          return p;
+      }
+
+      /*** dequeue abort handler: the element goes back in front */
+      static void unget(void* arg)
+      {
+          undo_t* u = static_cast<undo_t*>(arg);
+          {
+              boosting::Guard g(&u->q->base_lock);
+              u->q->base.push_front(u->val);
+          }
+          delete u;
+      }
+
+      static void forget(void* arg)
+      {
+          delete static_cast<undo_t*>(arg);
+      }
+
+      /*** take the oldest committed element, if there is one */
+      bool take_base(T* out)
+      {
+          undo_t* u;
+          {
+              boosting::Guard g(&base_lock);
+              if (base.empty())
+                  return false;
+              u = new undo_t();
+              u->q = this;
+              u->val = base.front();
+              base.pop_front();
+          }
+          if (out)
+              *out = u->val;
+          on_commit(forget, u);
+          on_abort(unget, u);
+          return true;
+      }
+
+      BoostedQueue(const BoostedQueue&);
+      BoostedQueue& operator=(const BoostedQueue&);
+
+    public:
+      BoostedQueue() : head(1), tail(), base_lock(0), base()
+      {
+          for (uint32_t i = 0; i <= MAX_THREADS; ++i)
+              pending[i] = NULL;
+      }
+
+      void enqueue(const Tx& tx, const T& v)
+      {
+          TxThread* self = tx.thread();
+          pending_t* p = mine(self);
+          tail.acquire_shared(self);
+          p->vals.push_back(v);
+      }
+
+      /**
+       *  Remove the oldest element, counting this transaction's own
+       *  enqueues; returns false if there is none
+       */
+      bool dequeue(const Tx& tx, T* out = NULL)
+      {
+          TxThread* self = tx.thread();
+          head.acquire(self, 0);
+          if (take_base(out))
+              return true;
+          // the queue looks empty, which doesn't commute with enqueues.
+          // Once we have the tail lock, all other enqueuers have flushed.
+          pending_t* p = mine(self);
+          tail.acquire_exclusive(self);
+          if (take_base(out))
+              return true;
+          // our own enqueues are discarded on abort, so no undo is needed
+          if (p->vals.empty())
+              return false;
+          if (out)
+              *out = p->vals.front();
+          p->vals.pop_front();
+          return true;
+      }
+
+      /*** nontransactional access, for initialization and checking */
+      void unsafe_enqueue(const T& v)
+      {
+          boosting::Guard g(&base_lock);
+          base.push_back(v);
+      }
+
+      size_t unsafe_size()
+      {
+          boosting::Guard g(&base_lock);
+          return base.size();
+      }
+  };
+} // namespace stm
+
+#endif // API_BOOSTING_HPP__
@@ -14,12 +14,15 @@
  *  API, but also compilable with a TM C++ compiler, then we need to map the
  *  library calls to the calls the TM compiler expects.
  *
- *  NB: Right now this only works with the Intel compiler
+ *  NB: This works with the Intel compiler, and with gcc's -fgnu-tm (using
+ *      libitm2stm's gccitm2stm library)
  */
 
 #ifndef STM_API_CXXTM_HPP
 #define STM_API_CXXTM_HPP
 
+#include <stm/metadata.hpp> // stats_t
+
 // The prototype icc stm compiler version 4.0 doesn't understand transactional
 // malloc and free without some help. The ifdef guard could be more intelligent.
 #if defined(__ICC)
@@ -29,12 +32,21 @@ extern "C" {
 }
 #endif
 
+#if defined(__GNUC__) && !defined(__ICC)
+// gcc uses attributes and __transaction_atomic/__transaction_relaxed, and has
+// no waivers.
+#define TM_CALLABLE         __attribute__((transaction_safe))
+
+#define TM_BEGIN(TYPE)      __transaction_##TYPE {
+#define TM_END              }
+#else
 #define TM_CALLABLE         [[transaction_safe]]
 
 #define TM_BEGIN(TYPE)      __transaction [[TYPE]] {
 #define TM_END              }
 
 #define TM_WAIVER           __transaction [[waiver]]
+#endif
 
 #define TM_GET_THREAD()
 #define TM_ARG
@@ -44,6 +56,7 @@ extern "C" {
 
 #define TM_READ(x) (x)
 #define TM_WRITE(x, y) (x) = (y)
+#define TM_ADD(x, y) (x) += (y)
 
 namespace stm
 {
@@ -55,6 +68,13 @@ namespace stm
 
   /***  Report the algorithm name that was used to initialize libstm */
   const char* get_algname();
+
+  /***  Sum the per-thread counters of libstm (see api/library.hpp) */
+  stats_t get_stats();
+
+  /***  ProfileApp's counters as a qtable row (see api/library.hpp) */
+  void reset_app_profile();
+  bool get_app_profile(app_profile_t&);
 }
 
 #if defined(ITM) || defined(ITM2STM)
@@ -22,12 +22,15 @@
  *  TM_BECOME_IRREVOC() : Become irrevocable or abort
  *  TM_READ(var)        : Read from shared memory from a txn
  *  TM_WRITE(var, val)  : Write to shared memory from a txn
+ *  TM_ADD(var, delta)  : Add to a shared counter when the txn commits
  *  TM_BEGIN(type)      : Start a transaction... use 'atomic' as type
  *  TM_END              : End a transaction
  *
  *  Custom Features:
  *
  *  stm::restart()                : Self-abort and immediately retry a txn
+ *  stm::on_commit(f, arg)        : Call f(arg) after the txn commits
+ *  stm::on_abort(f, arg)         : Call f(arg) when the txn aborts
  *  TM_BEGIN_FAST_INITIALIZATION  : For fast initialization
  *  TM_END_FAST_INITIALIZATION    : For fast initialization
  *  TM_GET_ALGNAME()              : Get the current algorithm name
@@ -49,16 +52,17 @@
 #ifndef API_LIBRARY_HPP__
 #define API_LIBRARY_HPP__
 
-#include <setjmp.h>
 #include <stm/config.h>
 #include <common/platform.hpp>
 #include <stm/txthread.hpp>
+#include <stm/checkpoint.hpp>
 
 namespace stm
 {
   /**
-   *  Code to start a transaction.  We assume the caller already performed a
-   *  setjmp, and is passing a valid setjmp buffer to this function.
+   *  Code to start a transaction.  We assume the caller already took a
+   *  checkpoint (see stm/checkpoint.hpp), and is passing it to this
+   *  function.
    *
    *  The code to begin a transaction *could* all live on the far side of a
    *  function pointer.  By putting some of the code into this inlined
@@ -85,16 +89,23 @@ namespace stm
 #endif
 
       // some adaptivity mechanisms need to know nontransactional and
-      // transactional time.  This code suffices, because it gets the time
-      // between transactions.  If we need the time for a single transaction,
-      // we can run ProfileTM
-      if (tx->end_txn_time)
-          tx->total_nontxn_time += (tick() - tx->end_txn_time);
+      // transactional time.  We only sample the clock on the first attempt,
+      // so that time spent in aborted attempts counts as transactional.
+      if (!tx->begin_txn_time) {
+          uint64_t now = tick();
+          if (tx->end_txn_time)
+              tx->stats.nontx_time += (now - tx->end_txn_time);
+          tx->begin_txn_time = now;
+          STM_TRACE(tx, EV_BEGIN, 0, 0);
+      }
 
       // now call the per-algorithm begin function
       TxThread::tmbegin(tx);
   }
 
+  /*** run and clear the commit handlers (see on_commit, below) */
+  void run_commit_handlers(TxThread* tx);
+
   /**
    *  Code to commit a transaction.  As in begin(), we are using forced
    *  inlining to save a little bit of overhead for subsumption nesting, and to
@@ -107,6 +118,9 @@ namespace stm
       if (--tx->nesting_depth)
           return;
 
+      // the commit hooks reset consec_aborts, so read it first
+      uint32_t attempts = tx->consec_aborts + 1;
+
       // dispatch to the appropriate end function
       tx->tmcommit(tx);
 
@@ -114,8 +128,20 @@ namespace stm
       CFENCE;
       tx->scope = NULL;
 
-      // record start of nontransactional time
-      tx->end_txn_time = tick();
+      // the handlers often release things (such as abstract locks) that
+      // other transactions are waiting for, so run them before the
+      // bookkeeping
+      if (tx->commit_handlers.size() | tx->abort_handlers.size())
+          run_commit_handlers(tx);
+
+      // record end of transactional time / start of nontransactional time
+      uint64_t now = tick();
+      uint64_t latency = now - tx->begin_txn_time;
+      tx->stats.tx_time += latency;
+      tx->stats.onCommit(latency, attempts);
+      STM_TRACE(tx, EV_COMMIT, 0, attempts);
+      tx->begin_txn_time = 0;
+      tx->end_txn_time = now;
   }
 
   /**
@@ -143,6 +169,80 @@ namespace stm
    */
   inline void tx_free(void* p) { Self->allocator.txFree(p); }
 
+  /**
+   *  Register a handler for the current transaction.  Commit handlers run
+   *  in registration order once the outermost transaction has committed.
+   *  Abort handlers run newest-first after each aborted attempt has been
+   *  rolled back, before the transaction restarts, so they can undo
+   *  nontransactional side effects (as the boosted containers in
+   *  api/boosting.hpp do).  Either way, both lists are then cleared.
+   *
+   *  Handlers run outside of the transaction, and must not start
+   *  transactions or register handlers.  They are a library API feature:
+   *  the itm shim has its own (_ITM_addUserCommitAction).
+   */
+  inline void on_commit(void (*f)(void*), void* arg)
+  {
+      tx_handler_t h = { f, arg };
+      Self->commit_handlers.insert(h);
+  }
+
+  inline void on_abort(void (*f)(void*), void* arg)
+  {
+      tx_handler_t h = { f, arg };
+      Self->abort_handlers.insert(h);
+  }
+
+  /*** the handlers behind tx_add, and its pending-increment lookup */
+  void apply_deferred_adds(void* tx);
+  void drop_deferred_adds(void* tx);
+  uintptr_t pending_adds(TxThread* tx, const volatile uintptr_t* addr);
+
+  /**
+   *  Deferred increments.  Inside of a transaction, tx_add doesn't touch
+   *  *addr: it logs the delta, and the commit applies it with an atomic
+   *  fetch-and-add (consecutive adds to the same word are combined).  An
+   *  abort drops it.  Transactions that only bump a shared counter thus
+   *  never conflict on it, and don't even make it a write.  Outside of a
+   *  transaction the add happens immediately.
+   *
+   *  The catch is that the word must only ever be updated this way (never
+   *  by TM_WRITE), and that a transactional read of it is not ordered with
+   *  concurrent increments.  Use it for counters that don't feed back into
+   *  transactional decisions: statistics, totals, heuristic sizes.
+   */
+  TM_INLINE
+  inline void tx_add_word(TxThread* tx, volatile uintptr_t* addr,
+                          uintptr_t delta)
+  {
+      if (!tx->nesting_depth) {
+          faaptr(addr, delta);
+          return;
+      }
+      if (tx->adds.size()) {
+          deferred_add_t* last = tx->adds.end() - 1;
+          if (last->addr == addr) {
+              last->delta += delta;
+              return;
+          }
+      }
+      else {
+          on_commit(apply_deferred_adds, tx);
+          on_abort(drop_deferred_adds, tx);
+      }
+      deferred_add_t a = { addr, delta };
+      tx->adds.insert(a);
+  }
+
+  /*** for any word-sized integer type */
+  template <typename T, typename D>
+  inline void tx_add(T* addr, D delta, TxThread* tx)
+  {
+      typedef char word_sized[(sizeof(T) == sizeof(uintptr_t)) ? 1 : -1];
+      (void)sizeof(word_sized);
+      tx_add_word(tx, (volatile uintptr_t*)addr, (uintptr_t)(T)delta);
+  }
+
   /**
    *  Master class for all objects that are used in transactions, to ensure
    *  that those objects have tx-safe allocation
@@ -177,7 +277,7 @@ namespace stm
   /**
    *  Initialize the library (call before doing any per-thread initialization)
    *
-   *  We rely on the default setjmp/longjmp abort handling when using the
+   *  We rely on the default checkpoint/restore abort handling when using the
    *  library API.
    */
   void sys_init(void (*abort_handler)(TxThread*) = NULL);
@@ -202,6 +302,26 @@ namespace stm
   /***  Report the algorithm name that was used to initialize libstm */
   const char* get_algname();
 
+  /**
+   *  Sum the per-thread commit/abort/time counters, and merge the latency
+   *  and attempts histograms, of all threads.  This is a snapshot: counters
+   *  keep changing while it is being taken.
+   */
+  stats_t get_stats();
+
+  /**
+   *  Restart ProfileApp's counters.  Call this while no transactions are
+   *  running, e.g. right after switching to ProfileAppAvg.
+   */
+  void reset_app_profile();
+
+  /**
+   *  Report what ProfileApp measured since the last reset_app_profile, in
+   *  the form of a row of the CBR qtable.  Returns false if ProfileApp has
+   *  never run.
+   */
+  bool get_app_profile(app_profile_t&);
+
   /**
    *  Become irrevocable.  Call this from within a transaction.
    */
@@ -213,6 +333,14 @@ namespace stm
   void restart();
 }
 
+/**
+ *  A single-algorithm build (libstm_single_algorithm) needs that algorithm's
+ *  barriers, so that library_inst.hpp can inline them
+ */
+#if defined(STM_SINGLE_ALG)
+#include <stm/inline_barriers.hpp>
+#endif
+
 /*** pull in the per-memory-access instrumentation framework */
 #include "library_inst.hpp"
 
@@ -240,6 +368,7 @@ namespace stm
  */
 #define TM_READ(var)       stm::stm_read(&var, tx)
 #define TM_WRITE(var, val) stm::stm_write(&var, val, tx)
+#define TM_ADD(var, delta) stm::tx_add(&var, delta, tx)
 
 /**
  *  This is the way to start a transaction
@@ -247,8 +376,8 @@ namespace stm
 #define TM_BEGIN(TYPE)                                      \
     {                                                       \
     stm::TxThread* tx = (stm::TxThread*)stm::Self;          \
-    jmp_buf _jmpbuf;                                        \
-    uint32_t abort_flags = setjmp(_jmpbuf);                 \
+    STM_CHECKPOINT_T _jmpbuf;                               \
+    uint32_t abort_flags = STM_CHECKPOINT(_jmpbuf);         \
     stm::begin(tx, &_jmpbuf, abort_flags);                  \
     CFENCE;                                                 \
     {
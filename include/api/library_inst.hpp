@@ -34,6 +34,77 @@
 
 namespace stm
 {
+  /**
+   *  Everything below reads and writes words through read_word and
+   *  write_word.  Normally they just call the thread's tmread and tmwrite
+   *  pointers.  When libstm is built for a single algorithm, they compare
+   *  the pointers with that algorithm's barriers, and call the barriers
+   *  directly when they match, so that the compiler can inline them.  Any
+   *  other barrier (e.g., CGL's, while irrevocable) is still called through
+   *  the pointer.
+   */
+#if defined(STM_SINGLE_ALG_NOREC)
+  /*** NOrec has separate read barriers before and after the first write */
+  TM_INLINE
+  inline void* read_word(STM_READ_SIG(tx, addr, mask))
+  {
+      ReadBarrier r = tx->tmread;
+      if (__builtin_expect(r == NOrecBarriers::read_ro, true))
+          return NOrecBarriers::read_ro(tx, addr STM_MASK(mask));
+      if (r == NOrecBarriers::read_rw)
+          return NOrecBarriers::read_rw(tx, addr STM_MASK(mask));
+      return r(tx, addr STM_MASK(mask));
+  }
+
+  /*** the first write switches modes, so only write_rw is worth inlining */
+  TM_INLINE
+  inline void write_word(STM_WRITE_SIG(tx, addr, val, mask))
+  {
+      WriteBarrier w = tx->tmwrite;
+      if (__builtin_expect(w == NOrecBarriers::write_rw, true))
+          NOrecBarriers::write_rw(tx, addr, val STM_MASK(mask));
+      else
+          w(tx, addr, val STM_MASK(mask));
+  }
+#elif defined(STM_SINGLE_ALG_CGL) || defined(STM_SINGLE_ALG_TML)
+#  if defined(STM_SINGLE_ALG_CGL)
+  typedef CGLBarriers SINGLE_ALG_BARRIERS;
+#  else
+  typedef TMLBarriers SINGLE_ALG_BARRIERS;
+#  endif
+
+  TM_INLINE
+  inline void* read_word(STM_READ_SIG(tx, addr, mask))
+  {
+      ReadBarrier r = tx->tmread;
+      if (__builtin_expect(r == SINGLE_ALG_BARRIERS::read, true))
+          return SINGLE_ALG_BARRIERS::read(tx, addr STM_MASK(mask));
+      return r(tx, addr STM_MASK(mask));
+  }
+
+  TM_INLINE
+  inline void write_word(STM_WRITE_SIG(tx, addr, val, mask))
+  {
+      WriteBarrier w = tx->tmwrite;
+      if (__builtin_expect(w == SINGLE_ALG_BARRIERS::write, true))
+          SINGLE_ALG_BARRIERS::write(tx, addr, val STM_MASK(mask));
+      else
+          w(tx, addr, val STM_MASK(mask));
+  }
+#else
+  TM_INLINE
+  inline void* read_word(STM_READ_SIG(tx, addr, mask))
+  {
+      return tx->tmread(tx, addr STM_MASK(mask));
+  }
+
+  TM_INLINE
+  inline void write_word(STM_WRITE_SIG(tx, addr, val, mask))
+  {
+      tx->tmwrite(tx, addr, val STM_MASK(mask));
+  }
+#endif
+
   /**
    *  The DISPATCH class takes an address and a type, and determines which
    *  words (represented as void*s) ought to be read and written to effect a
@@ -77,15 +148,15 @@ namespace stm
       TM_INLINE
       static T read(T* addr, TxThread* thread)
       {
-          return (T)(uintptr_t)thread->tmread(thread, (void**)addr
-                                              STM_MASK(~0x0));
+          return (T)(uintptr_t)read_word(thread, (void**)addr
+                                         STM_MASK(~0x0));
       }
 
       TM_INLINE
       static void write(T* addr, T val, TxThread* thread)
       {
-          thread->tmwrite(thread, (void**)addr, (void*)(uintptr_t)val
-                          STM_MASK(~0x0));
+          write_word(thread, (void**)addr, (void*)(uintptr_t)val
+                     STM_MASK(~0x0));
       }
   };
 
@@ -97,7 +168,7 @@ namespace stm
       static float read(float* addr, TxThread* thread)
       {
           union { float f;  void* v;  } v;
-          v.v = thread->tmread(thread, (void**)addr STM_MASK(~0x0));
+          v.v = read_word(thread, (void**)addr STM_MASK(~0x0));
           return v.f;
       }
 
@@ -106,7 +177,7 @@ namespace stm
       {
           union { float f;  void* v;  } v;
           v.f = val;
-          thread->tmwrite(thread, (void**)addr, v.v STM_MASK(~0x0));
+          write_word(thread, (void**)addr, v.v STM_MASK(~0x0));
       }
   };
 
@@ -118,7 +189,7 @@ namespace stm
       static float read(const float* addr, TxThread* thread)
       {
           union { float f;  void* v;  } v;
-          v.v = thread->tmread(thread, (void**)addr STM_MASK(~0x0));
+          v.v = read_word(thread, (void**)addr STM_MASK(~0x0));
           return v.f;
       }
 
@@ -136,33 +207,26 @@ namespace stm
       TM_INLINE
       static T read(T* addr, TxThread* thread)
       {
-          // get second word's address
-          void** addr2 = (void**)((long)addr + 4);
           union {
               long long l;
-              struct { void* v1; void* v2; } v;
+              void* w[2];
           } v;
-          // read the two words
-          v.v.v1 = thread->tmread(thread, (void**)addr STM_MASK(~0x0));
-          v.v.v2 = thread->tmread(thread, addr2 STM_MASK(~0x0));
+          // read the two words with one range barrier
+          thread->tmread_range(thread, (void**)addr, v.w, 2);
           return (T)v.l;
       }
 
       TM_INLINE
       static void write(T* addr, T val, TxThread* thread)
       {
-          // compute the two addresses
-          void** addr1 = (void**)addr;
-          void** addr2 = (void**)((long)addr + 4);
           // turn the value into two words
           union {
               T t;
-              struct { void* v1; void* v2; } v;
+              void* w[2];
           } v;
           v.t = val;
-          // write the two words
-          thread->tmwrite(thread, addr1, v.v.v1 STM_MASK(~0x0));
-          thread->tmwrite(thread, addr2, v.v.v2 STM_MASK(~0x0));
+          // write the two words with one range barrier
+          thread->tmwrite_range(thread, (void**)addr, v.w, 2);
       }
   };
 
@@ -176,33 +240,26 @@ namespace stm
       TM_INLINE
       static double read(double* addr, TxThread* thread)
       {
-          // get second word's address
-          void** addr2 = (void**)((long)addr + 4);
           union {
               double t;
-              struct { void* v1; void* v2; } v;
+              void* w[2];
           } v;
-          // read the two words
-          v.v.v1 = thread->tmread(thread, (void**)addr STM_MASK(~0x0));
-          v.v.v2 = thread->tmread(thread, addr2 STM_MASK(~0x0));
+          // read the two words with one range barrier
+          thread->tmread_range(thread, (void**)addr, v.w, 2);
           return v.t;
       }
 
       TM_INLINE
       static void write(double* addr, double val, TxThread* thread)
       {
-          // compute the two addresses
-          void** addr1 = (void**) addr;
-          void** addr2 = (void**) ((long)addr + 4);
           // turn the value into two words
           union {
               double t;
-              struct { void* v1; void* v2; } v;
+              void* w[2];
           } v;
           v.t = val;
-          // write the two words
-          thread->tmwrite(thread, addr1, v.v.v1 STM_MASK(~0x0));
-          thread->tmwrite(thread, addr2, v.v.v2 STM_MASK(~0x0));
+          // write the two words with one range barrier
+          thread->tmwrite_range(thread, (void**)addr, v.w, 2);
       }
   };
 
@@ -213,15 +270,12 @@ namespace stm
       TM_INLINE
       static double read(const double* addr, TxThread* thread)
       {
-          // get the second word's address
-          void** addr2 = (void**)((long)addr + 4);
           union {
               double t;
-              struct { void* v1; void* v2; } v;
+              void* w[2];
           } v;
-          // read the two words
-          v.v.v1 = thread->tmread(thread, (void**)addr STM_MASK(~0x0));
-          v.v.v2 = thread->tmread(thread, addr2 STM_MASK(~0x0));
+          // read the two words with one range barrier
+          thread->tmread_range(thread, (void**)addr, v.w, 2);
           return v.t;
       }
 
@@ -252,7 +306,7 @@ namespace stm
           union { char v[4]; void* v2; } v;
           void** a = (void**)(((long)addr) & ~3);
           long offset = ((long)addr) & 3;
-          v.v2 = thread->tmread(thread, a STM_MASK(0xFF << (8 * offset)));
+          v.v2 = read_word(thread, a STM_MASK(0xFF << (8 * offset)));
           return (T)v.v[offset];
       }
 
@@ -265,9 +319,9 @@ namespace stm
           void** a = (void**)(((long)addr) & ~3);
           long offset = ((long)addr) & 3;
           // read the enclosing word
-          v.v2 = thread->tmread(thread, a STM_MASK(0xFF << (8 * offset)));
+          v.v2 = read_word(thread, a STM_MASK(0xFF << (8 * offset)));
           v.v[offset] = val;
-          thread->tmwrite(thread, a, v.v2 STM_MASK(0xFF << (8 * offset)));
+          write_word(thread, a, v.v2 STM_MASK(0xFF << (8 * offset)));
       }
   };
 
@@ -279,15 +333,15 @@ namespace stm
       TM_INLINE
       static T read(T* addr, TxThread* thread)
       {
-          return (T)(uintptr_t)thread->tmread(thread, (void**)addr
-                                              STM_MASK(~0x0));
+          return (T)(uintptr_t)read_word(thread, (void**)addr
+                                         STM_MASK(~0x0));
       }
 
       TM_INLINE
       static void write(T* addr, T val, TxThread* thread)
       {
-          thread->tmwrite(thread, (void**)addr, (void*)(uintptr_t)val
-                          STM_MASK(~0x0));
+          write_word(thread, (void**)addr, (void*)(uintptr_t)val
+                     STM_MASK(~0x0));
       }
   };
 
@@ -299,7 +353,7 @@ namespace stm
       static double read(double* addr, TxThread* thread)
       {
           union { double d;  void*  v; } v;
-          v.v = thread->tmread(thread, (void**)addr STM_MASK(~0x0));
+          v.v = read_word(thread, (void**)addr STM_MASK(~0x0));
           return v.d;
       }
 
@@ -308,7 +362,7 @@ namespace stm
       {
           union { double d;  void*  v; } v;
           v.d = val;
-          thread->tmwrite(thread, (void**)addr, v.v STM_MASK(~0x0));
+          write_word(thread, (void**)addr, v.v STM_MASK(~0x0));
       }
   };
 
@@ -320,7 +374,7 @@ namespace stm
       static double read(const double* addr, TxThread* thread)
       {
           union { double d;  void*  v; } v;
-          v.v = thread->tmread(thread, (void**)addr STM_MASK(~0x0));
+          v.v = read_word(thread, (void**)addr STM_MASK(~0x0));
           return v.d;
       }
 
@@ -338,33 +392,26 @@ namespace stm
       TM_INLINE
       static double read(double* addr, TxThread* thread)
       {
-          // get second word's address
-          void** addr2 = (void**)((long)addr + 4);
           union {
               double t;
-              struct { void* v1; void* v2; } v;
+              void* w[2];
           } v;
-          // read the two words
-          v.v.v1 = thread->tmread(thread, (void**)addr STM_MASK(~0x0));
-          v.v.v2 = thread->tmread(thread, addr2 STM_MASK(~0x0));
+          // read the two words with one range barrier
+          thread->tmread_range(thread, (void**)addr, v.w, 2);
           return v.t;
       }
 
       TM_INLINE
       static void write(double* addr, double val, TxThread* thread)
       {
-          // compute the two addresses
-          void** addr1 = (void**) addr;
-          void** addr2 = (void**) ((long)addr + 4);
           // turn the value into two words
           union {
               double t;
-              struct { void* v1; void* v2; } v;
+              void* w[2];
           } v;
           v.t = val;
-          // write the two words
-          thread->tmwrite(thread, addr1, v.v.v1 STM_MASK(~0x0));
-          thread->tmwrite(thread, addr2, v.v.v2 STM_MASK(~0x0));
+          // write the two words with one range barrier
+          thread->tmwrite_range(thread, (void**)addr, v.w, 2);
       }
   };
 
@@ -393,8 +440,8 @@ namespace stm
           union { int v[2]; void* v2; } v;
           void** a = (void**)(((intptr_t)addr) & ~7ul);
           long offset = (((intptr_t)addr)>>2)&1;
-          v.v2 = thread->tmread(thread, a
-                                STM_MASK(0xffffffff << (32 * offset)));
+          v.v2 = read_word(thread, a
+                           STM_MASK(0xffffffff << (32 * offset)));
           return (T)v.v[offset];
       }
 
@@ -407,11 +454,11 @@ namespace stm
           void** a = (void**)(((intptr_t)addr) & ~7ul);
           int offset = (((intptr_t)addr)>>2) & 1;
           // read the enclosing word
-          v.v2 = thread->tmread(thread, a
-                                STM_MASK(0xffffffff << (32 * offset)));
+          v.v2 = read_word(thread, a
+                           STM_MASK(0xffffffff << (32 * offset)));
           v.v[offset] = val;
-          thread->tmwrite(thread, a, v.v2
-                          STM_MASK(0xffffffff << (32 * offset)));
+          write_word(thread, a, v.v2
+                     STM_MASK(0xffffffff << (32 * offset)));
       }
   };
 
@@ -426,8 +473,8 @@ namespace stm
           union { float v[2]; void* v2; } v;
           void** a = (void**)(((intptr_t)addr)&~7ul);
           long offset = (((intptr_t)addr)>>2)&1;
-          v.v2 = thread->tmread(thread, a
-                                STM_MASK(0xffffffff << (32 * offset)));
+          v.v2 = read_word(thread, a
+                           STM_MASK(0xffffffff << (32 * offset)));
           return v.v[offset];
       }
 
@@ -439,11 +486,11 @@ namespace stm
           void**a = (void**)(((intptr_t)addr) & ~7ul);
           int offset = (((intptr_t)addr)>>2) & 1;
           // read enclosing word
-          v.v2 = thread->tmread(thread, a
-                                STM_MASK(0xffffffff << (32 * offset)));
+          v.v2 = read_word(thread, a
+                           STM_MASK(0xffffffff << (32 * offset)));
           v.v[offset] = val;
-          thread->tmwrite(thread, a, v.v2
-                          STM_MASK(0xffffffff << (32 * offset)));
+          write_word(thread, a, v.v2
+                     STM_MASK(0xffffffff << (32 * offset)));
       }
   };
 
@@ -458,8 +505,8 @@ namespace stm
           union { float v[2]; void* v2; } v;
           void** a = (void**)(((intptr_t)addr)&~7ul);
           long offset = (((intptr_t)addr)>>2)&1;
-          v.v2 = thread->tmread(thread, a
-                                STM_MASK(0xffffffff << (32 * offset)));
+          v.v2 = read_word(thread, a
+                           STM_MASK(0xffffffff << (32 * offset)));
           return v.v[offset];
       }
 
@@ -483,8 +530,8 @@ namespace stm
           union { char v[8]; void* v2; } v;
           void** a = (void**)(((long)addr) & ~7);
           long offset = ((long)addr) & 7;
-          v.v2 = thread->tmread(thread, a
-                                STM_MASK(0xffffffff << (8 * offset)));
+          v.v2 = read_word(thread, a
+                           STM_MASK(0xffffffff << (8 * offset)));
           return (T)v.v[offset];
       }
 
@@ -497,11 +544,11 @@ namespace stm
           void** a = (void**)(((long)addr) & ~7);
           long offset = ((long)addr) & 7;
           // read the enclosing word
-          v.v2 = thread->tmread(thread, a
-                                STM_MASK(0xffffffff << (8 * offset)));
+          v.v2 = read_word(thread, a
+                           STM_MASK(0xffffffff << (8 * offset)));
           v.v[offset] = val;
-          thread->tmwrite(thread, a, v.v2
-                          STM_MASK(0xffffffff << (8 * offset)));
+          write_word(thread, a, v.v2
+                     STM_MASK(0xffffffff << (8 * offset)));
       }
   };
 
@@ -11,7 +11,6 @@
 #ifndef API_STAMP_HPP__
 #define API_STAMP_HPP__
 
-#include <setjmp.h>
 #include <cstdlib>
 #include <cassert>
 #include <api/library.hpp>
@@ -41,21 +40,30 @@
 #define STM_LOCAL_WRITE_P(var, val) ({var = val; var;})
 
 /**
- *  Special alloc for STAMP, used to detect nontransactional mallocs from
- *  within transactions
+ *  Special alloc for STAMP, used for P_MALLOC and SEQ_MALLOC.  Once the
+ *  caller has a descriptor, this comes from its WBMMPolicy's allocator, so
+ *  that every block STAMP frees came from the same allocator (which matters
+ *  when libstm uses its slab allocator).  It is not logged: P_ structures
+ *  are updated in place inside of transactions, and keep pointing at the
+ *  block even if the transaction aborts.
  */
 inline void* tx_safe_non_tx_alloc(size_t size)
 {
+    if (stm::Self)
+        return stm::Self->allocator.privateAlloc(size);
     return malloc(size);
 }
 
 /**
- *  Special free for STAMP, used to detect nontransactional frees from within
- *  transactions
+ *  Special free for STAMP, used for P_FREE and SEQ_FREE.  The block goes
+ *  straight back to the allocator, as with free().
  */
 inline void tx_safe_non_tx_free(void * ptr)
 {
-    free(ptr);
+    if (stm::Self)
+        stm::Self->allocator.privateFree(ptr);
+    else
+        free(ptr);
 }
 
 /**
@@ -63,8 +71,8 @@ inline void tx_safe_non_tx_free(void * ptr)
  */
 #define STM_BEGIN_WR()                                                  \
     {                                                                   \
-    jmp_buf jmpbuf_;                                                    \
-    uint32_t abort_flags = setjmp(jmpbuf_);                             \
+    STM_CHECKPOINT_T jmpbuf_;                                           \
+    uint32_t abort_flags = STM_CHECKPOINT(jmpbuf_);                     \
     begin(static_cast<stm::TxThread*>(STM_SELF), &jmpbuf_, abort_flags);\
     CFENCE;                                                             \
     {
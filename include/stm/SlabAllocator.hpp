@@ -0,0 +1,134 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  A per-thread, size-class slab allocator for WBMMPolicy.  Each thread
+ *  carves 64KB chunks into equal-sized blocks, and keeps one freelist per
+ *  size class, so that allocation and local frees never touch the global
+ *  allocator.  A block freed by a thread other than its owner (usually
+ *  because epoch reclamation happened on another thread) is batched, and
+ *  whole batches are pushed onto the owner's lock-free inbox.  The owner
+ *  drains its inbox when a freelist runs dry.
+ *
+ *  Requests larger than the biggest size class go straight to malloc.  We
+ *  recognize our own blocks by looking up their chunk in a global table,
+ *  so release() may be handed memory that came from malloc, and will free
+ *  it.  The converse is not true: memory from alloc() must not be passed
+ *  to free().
+ */
+
+#ifndef SLABALLOCATOR_HPP__
+#define SLABALLOCATOR_HPP__
+
+#include <stdlib.h>
+#include <stm/config.h>
+#include "stm/metadata.hpp"
+
+namespace stm
+{
+  /*** a free block, linked through its first word */
+  struct slab_block_t
+  {
+      slab_block_t* next;
+  };
+
+  class SlabAllocator
+  {
+    public:
+      /*** sizes 16..64 by 16, then two classes per power of two to 2048 */
+      static const uint32_t CLASSES   = 14;
+      static const size_t   MAX_SIZE  = 2048;
+
+      /*** blocks freed for another thread are sent over in batches */
+      static const uint32_t BATCH     = 32;
+
+      /**
+       *  Ids 0..MAX_THREADS-1 belong to TxThreads.  The reclamation helper
+       *  has a slot of its own, so that its blocks and inbox are never
+       *  mistaken for a real thread's.
+       */
+      static const uint32_t HELPER_ID = MAX_THREADS;
+      static const uint32_t OWNERS    = MAX_THREADS + 1;
+
+      /*** map a request size (1..MAX_SIZE) to its class */
+      static uint32_t class_of(size_t size)
+      {
+          size_t s = size ? size - 1 : 0;
+          if (s < 64)
+              return s >> 4;
+          uint32_t e = 63 - __builtin_clzll(s);
+          return 4 + (e - 6) * 2 + ((s >> (e - 1)) & 1);
+      }
+
+      /*** the block size of a class */
+      static size_t class_size(uint32_t c)
+      {
+          if (c < 4)
+              return 16 * (c + 1);
+          uint32_t e = 6 + (c - 4) / 2;
+          return ((size_t)1 << e) + (((c - 4) & 1) + 1) * ((size_t)1 << (e - 1));
+      }
+
+    private:
+      /*** my thread's index, for chunk ownership and my inbox */
+      uint32_t      owner;
+
+      /*** local freelists */
+      slab_block_t* freelist[CLASSES];
+
+      /*** blocks waiting to be sent to other threads */
+      slab_block_t* pending[OWNERS];
+      uint32_t      pending_count[OWNERS];
+
+      /*** take back remotely freed blocks, or carve a new chunk */
+      NOINLINE void* refill(uint32_t c);
+
+      /*** send a batch to its owner */
+      void flush(uint32_t to);
+
+    public:
+      SlabAllocator() : owner(0)
+      {
+          for (uint32_t i = 0; i < CLASSES; ++i)
+              freelist[i] = NULL;
+          for (uint32_t i = 0; i < OWNERS; ++i) {
+              pending[i] = NULL;
+              pending_count[i] = 0;
+          }
+      }
+
+      void setID(uint32_t id) { owner = id; }
+
+      void* alloc(size_t size)
+      {
+          if (size > MAX_SIZE)
+              return malloc(size);
+          uint32_t c = class_of(size);
+          slab_block_t* b = freelist[c];
+          if (__builtin_expect(b == NULL, false))
+              return refill(c);
+          freelist[c] = b->next;
+          return b;
+      }
+
+      /*** return a block to its owner's freelist (or free() it) */
+      void release(void* ptr);
+
+      /**
+       *  Send every partial batch to its owner.  Called when this thread
+       *  shuts down, or (for the helper) when it has nothing else to do, so
+       *  that blocks don't sit in a batch that may never fill.
+       */
+      void flush_all();
+  };
+
+} // namespace stm
+
+#endif // SLABALLOCATOR_HPP__
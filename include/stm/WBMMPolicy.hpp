@@ -28,6 +28,9 @@
 #include <stm/config.h>
 #include "stm/MiniVector.hpp"
 #include "stm/metadata.hpp"
+#ifdef STM_SLAB_ALLOCATOR_YES
+#include "stm/SlabAllocator.hpp"
+#endif
 
 namespace stm
 {
@@ -37,6 +40,29 @@ namespace stm
   /*** store every thread's counter */
   extern pad_word_t trans_nums[MAX_THREADS];
 
+#ifdef STM_GLOBAL_EPOCH_YES
+  /**
+   *  In global-epoch mode, a thread's counter is (epoch << 1) | 1 while it
+   *  is in a transaction, and even otherwise.  The epoch only advances once
+   *  every active thread has announced the current one, so anything retired
+   *  in epoch e is unreachable by the time the epoch reaches e + 2.
+   */
+  extern pad_word_t global_epoch;
+
+  /*** Node type for a list of void*s retired in the same epoch */
+  struct epoch_bag_t
+  {
+      static const uint32_t POOL_SIZE = 32;
+
+      void*        pool[POOL_SIZE];
+      uint32_t     length;
+      uintptr_t    epoch;   // the epoch in which these were retired
+      epoch_bag_t* older;
+
+      epoch_bag_t() : length(0), epoch(0), older(NULL) { }
+  };
+#endif
+
   /*** Node type for a list of timestamped void*s */
   struct limbo_t
   {
@@ -72,11 +98,25 @@ namespace stm
       /*** location of my timestamp value */
       volatile uintptr_t* my_ts;
 
+#ifdef STM_GLOBAL_EPOCH_YES
+      /**
+       *  Things retired in epoch e go in bags[e % 3], which is labeled e.  A
+       *  bag can be freed once the global epoch reaches its label + 2.
+       */
+      epoch_bag_t* bags[3];
+
+      /*** the epoch this thread last saw, which selects the current bag */
+      uintptr_t epoch;
+
+      /*** the next thread to check before we can advance the epoch */
+      uint32_t scan;
+#else
       /*** As we mark things for deletion, we accumulate them here */
       limbo_t* prelimbo;
 
       /*** sorted list of timestamped reclaimables */
       limbo_t* limbo;
+#endif
 
       /*** List of objects to delete if the current transaction commits */
       AddressList frees;
@@ -84,10 +124,51 @@ namespace stm
       /*** List of objects to delete if the current transaction aborts */
       AddressList allocs;
 
+#ifdef STM_SLAB_ALLOCATOR_YES
+      /*** per-thread size-class allocator that backs txAlloc/txFree */
+      SlabAllocator slab;
+
+      void* raw_alloc(size_t size) { return slab.alloc(size); }
+      void raw_free(void* ptr) { slab.release(ptr); }
+#else
+      void* raw_alloc(size_t size) { return malloc(size); }
+      void raw_free(void* ptr) { free(ptr); }
+#endif
+
       /**
        *  Schedule a pointer for reclamation.  Reclamation will not happen
        *  until enough time has passed.
        */
+#ifdef STM_GLOBAL_EPOCH_YES
+      void schedForReclaim(void* ptr)
+      {
+          if (global_epoch.val != epoch)
+              catch_up();
+          epoch_bag_t* bag = bags[epoch % 3];
+          bag->pool[bag->length++] = ptr;
+          if (bag->length != bag->POOL_SIZE)
+              return;
+          handle_full_bag();
+      }
+
+      /**
+       *  Move to the current global epoch before retiring anything, so
+       *  that nothing is put in a bag labeled with an older epoch than the
+       *  one it was retired in.  Frees the bags that have expired.
+       */
+      NOINLINE void catch_up();
+
+      /**
+       *  When a bag fills, check as many threads as we can without waiting,
+       *  and advance the epoch if they have all caught up.  The scan resumes
+       *  where it stopped, so each thread's counter is read about once per
+       *  epoch rather than once per full bag.
+       */
+      NOINLINE void handle_full_bag();
+
+      /*** free everything in a bag, and keep only its first node */
+      void empty_bag(epoch_bag_t* bag);
+#else
       void schedForReclaim(void* ptr)
       {
           // insert /ptr/ into the prelimbo pool and increment the pool size
@@ -107,6 +188,29 @@ namespace stm
        */
       NOINLINE void handle_full_prelimbo();
 
+      /**
+       *  Give a full batch a timestamp, put it at the head of the limbo
+       *  list, and free every older batch that it strictly dominates.
+       *  Returns the number of batches freed.
+       */
+      uintptr_t retire_batch(limbo_t* batch);
+
+      /*** free the batches after /newest/ that it strictly dominates */
+      uintptr_t reclaim_older(limbo_t* newest);
+
+#ifdef STM_RECLAIM_THREAD_YES
+      /**
+       *  With a reclamation thread, committers push full batches onto a
+       *  lock-free queue, and the helper does the timestamping and the
+       *  frees.  offload() returns false when the helper is too far behind,
+       *  in which case the committer reclaims for itself.
+       */
+      static bool offload(limbo_t* batch);
+      static void start_reclaimer();
+      static void* reclaim_thread(void*);
+#endif
+#endif
+
     public:
 
       /**
@@ -114,21 +218,35 @@ namespace stm
        *  Null out the timestamp for a particular thread.  We only call this
        *  at initialization.
        */
+#ifdef STM_GLOBAL_EPOCH_YES
+      WBMMPolicy() : epoch(0), scan(0), frees(128), allocs(128)
+      {
+          for (int i = 0; i < 3; ++i)
+              bags[i] = new epoch_bag_t();
+      }
+#else
       WBMMPolicy()
           : prelimbo(new limbo_t()), limbo(NULL), frees(128), allocs(128)
       { }
+#endif
 
       /**
        *  Since a TxThread constructs its allocator before it gets its id, we
        *  need the TxThread to inform the allocator of its id from within the
        *  constructor, via this method.
        */
-      void setID(uint32_t id) { my_ts = &trans_nums[id].val; }
+      void setID(uint32_t id)
+      {
+          my_ts = &trans_nums[id].val;
+#ifdef STM_SLAB_ALLOCATOR_YES
+          slab.setID(id);
+#endif
+      }
 
       /*** Wrapper to thread-specific allocator for allocating memory */
       void* txAlloc(size_t const &size)
       {
-          void* ptr = malloc(size);
+          void* ptr = raw_alloc(size);
           if ((*my_ts)&1)
               allocs.insert(ptr);
           return ptr;
@@ -140,18 +258,31 @@ namespace stm
           if ((*my_ts)&1)
               frees.insert(ptr);
           else
-              free(ptr);
+              raw_free(ptr);
       }
 
+      /**
+       *  Allocate and free right away, even inside a transaction, from the
+       *  same allocator as txAlloc/txFree.  This is for memory that only its
+       *  owner can reach, and whose pointers are not rolled back on abort
+       *  (STAMP's P_MALLOC), so the allocation must not be undone either.
+       */
+      void* privateAlloc(size_t size) { return raw_alloc(size); }
+      void privateFree(void* ptr) { raw_free(ptr); }
+
       /*** On begin, move to an odd epoch and start logging */
+#ifdef STM_GLOBAL_EPOCH_YES
+      void onTxBegin() { *my_ts = (global_epoch.val << 1) | 1; }
+#else
       void onTxBegin() { *my_ts = 1 + *my_ts; }
+#endif
 
       /*** On abort, unroll allocs, clear lists, exit epoch */
       void onTxAbort()
       {
           AddressList::iterator i, e;
           for (i = allocs.begin(), e = allocs.end(); i != e; ++i)
-              free(*i);
+              raw_free(*i);
           frees.reset();
           allocs.reset();
           *my_ts = 1+*my_ts;
@@ -167,6 +298,17 @@ namespace stm
           allocs.reset();
           *my_ts = 1+*my_ts;
       }
+
+      /**
+       *  Send blocks we freed on behalf of other threads back to them now,
+       *  rather than waiting for their batches to fill.
+       */
+      void flushRemoteFrees()
+      {
+#ifdef STM_SLAB_ALLOCATOR_YES
+          slab.flush_all();
+#endif
+      }
   }; // class stm::WBMMPolicy
 
 } // namespace stm
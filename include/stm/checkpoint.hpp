@@ -0,0 +1,68 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  The library API saves a checkpoint when a transaction begins, and the
+ *  default abort handler restores it.  Usually the checkpoint is a jmp_buf.
+ *  On x86_64, with libstm_use_asm_checkpoint, it is just the callee-saved
+ *  registers, the stack pointer, and the return address, which is all that
+ *  a checkpoint taken at a call site needs (see checkpoint.S).  That is
+ *  cheaper than setjmp, which also mangles pointers and may deal with the
+ *  signal mask and shadow stack.
+ *
+ *  NB: the semantics are those of setjmp: locals that change after the
+ *      checkpoint and are read after an abort must still be volatile.
+ */
+
+#ifndef STM_CHECKPOINT_HPP__
+#define STM_CHECKPOINT_HPP__
+
+#include <stdint.h>
+#include <stm/config.h>
+
+#if defined(STM_ASM_CHECKPOINT) && defined(__x86_64__)
+
+namespace stm
+{
+  /**
+   *  rbp, rbx, r12-r15, the resume address, and the stack pointer to resume
+   *  with, in that order.  checkpoint.S depends on this layout.
+   */
+  struct checkpoint_t
+  {
+      void* regs[8];
+  };
+}
+
+extern "C"
+{
+  /*** save a checkpoint, return 0 now, and the restore value later */
+  uint32_t _stm_checkpoint(stm::checkpoint_t*) __attribute__((returns_twice));
+
+  /*** resume from a checkpoint, whose frame must still be live */
+  void _stm_checkpoint_restore(stm::checkpoint_t*, uint32_t)
+      __attribute__((noreturn));
+}
+
+#define STM_CHECKPOINT_T                stm::checkpoint_t
+#define STM_CHECKPOINT(c)               _stm_checkpoint(&(c))
+#define STM_CHECKPOINT_RESTORE(c, val)  _stm_checkpoint_restore((c), (val))
+
+#else
+
+#include <setjmp.h>
+
+#define STM_CHECKPOINT_T                jmp_buf
+#define STM_CHECKPOINT(c)               setjmp(c)
+#define STM_CHECKPOINT_RESTORE(c, val)  longjmp(*(c), (val))
+
+#endif
+
+#endif // STM_CHECKPOINT_HPP__
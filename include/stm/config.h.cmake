@@ -38,11 +38,40 @@
 // Histogram generation
 #cmakedefine STM_COUNTCONSEC_YES
 
+// Latency histograms
+#cmakedefine STM_LATENCY_HISTOGRAM_YES
+
+// Event trace
+#cmakedefine STM_EVENT_TRACE_YES
+
+// Conflict attribution
+#cmakedefine STM_CONFLICT_ATTRIBUTION_YES
+
+// Sampled conflict heatmap
+#cmakedefine STM_CONFLICT_HEATMAP_YES
+
+// Allocator behind WBMMPolicy
+#cmakedefine STM_SLAB_ALLOCATOR_YES
+#cmakedefine STM_GLOBAL_EPOCH_YES
+#cmakedefine STM_RECLAIM_THREAD_YES
+
+// Placement of TxThread descriptors
+#cmakedefine STM_NUMA_LOCAL_YES
+
 // ProfileTMtrigger
 #cmakedefine STM_PROFILETMTRIGGER_ALL
 #cmakedefine STM_PROFILETMTRIGGER_PATHOLOGY
 #cmakedefine STM_PROFILETMTRIGGER_NONE
 
+// The algorithm whose barriers the library API inlines, if any
+#cmakedefine STM_SINGLE_ALG "@STM_SINGLE_ALG@"
+#cmakedefine STM_SINGLE_ALG_CGL
+#cmakedefine STM_SINGLE_ALG_TML
+#cmakedefine STM_SINGLE_ALG_NOREC
+
+// Register checkpoint instead of setjmp for the library API (x86_64 only)
+#cmakedefine STM_ASM_CHECKPOINT
+
 // Configured thread-local-storage model
 #cmakedefine STM_TLS_GCC
 #cmakedefine STM_TLS_PTHREAD
@@ -0,0 +1,169 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+#ifndef INLINE_BARRIERS_HPP__
+#define INLINE_BARRIERS_HPP__
+
+/**
+ *  The word barriers of CGL, TML and NOrec, along with the metadata they
+ *  use.  A build with libstm_single_algorithm set inlines one of these into
+ *  the library API (see api/library_inst.hpp), so they must be visible
+ *  outside of libstm.  The rest of each algorithm is in libstm/algs.
+ *
+ *  CGL's barriers are also what every algorithm uses while irrevocable.
+ *  NOrec's barriers do not depend on its contention manager, so every
+ *  NOrec variant shares them.
+ */
+
+#include <stm/config.h>
+#include <stm/txthread.hpp>
+#include <stm/UndoLog.hpp>       // STM_DO_MASKED_WRITE
+#include <stm/RedoRAWUtils.hpp>
+
+namespace stm
+{
+  /**
+   *  The global sequence lock / timestamp.  CGL, TML and NOrec all use it,
+   *  as do most of the other algorithms.
+   */
+  extern pad_word_t timestamp;
+
+  struct CGLBarriers
+  {
+      static TM_FASTCALL void* read(STM_READ_SIG(,addr,))
+      {
+          return *addr;
+      }
+
+      static TM_FASTCALL void write(STM_WRITE_SIG(,addr,val,mask))
+      {
+          STM_DO_MASKED_WRITE(addr, val, mask);
+      }
+  };
+
+  /**
+   *  TML requires this to be called after every read
+   */
+  inline void afterread_TML(TxThread* tx)
+  {
+      CFENCE;
+      if (__builtin_expect(timestamp.val != tx->start_time, false))
+          tx_abort(tx, ABORT_VALIDATION, &timestamp.val);
+  }
+
+  /**
+   *  TML requires this to be called before every write
+   */
+  inline void beforewrite_TML(TxThread* tx) {
+      // acquire the lock, abort on failure
+      if (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
+          tx_abort(tx, ABORT_LOCKED, &timestamp.val);
+      ++tx->start_time;
+      tx->tmlHasLock = true;
+  }
+
+  struct TMLBarriers
+  {
+      /**
+       *  If we have the lock, we're irrevocable so just do a read.
+       *  Otherwise, after doing the read, make sure we are still valid.
+       */
+      static TM_FASTCALL void* read(STM_READ_SIG(tx,addr,))
+      {
+          void* val = *addr;
+          if (tx->tmlHasLock)
+              return val;
+          // NB:  afterread_tml includes a CFENCE
+          afterread_TML(tx);
+          return val;
+      }
+
+      /**
+       *  If we have the lock, do an in-place write and return.  Otherwise,
+       *  we need to become irrevocable first, then do the write.
+       */
+      static TM_FASTCALL void write(STM_WRITE_SIG(tx,addr,val,mask))
+      {
+          if (tx->tmlHasLock) {
+              STM_DO_MASKED_WRITE(addr, val, mask);
+              return;
+          }
+          // NB:  beforewrite_tml includes a fence via CAS
+          beforewrite_TML(tx);
+          STM_DO_MASKED_WRITE(addr, val, mask);
+      }
+  };
+
+  struct NOrecBarriers
+  {
+      static const uintptr_t VALIDATION_FAILED = 1;
+
+      /**
+       *  Wait for an even timestamp, then check the value log.  Returns the
+       *  timestamp at which the log was valid, or VALIDATION_FAILED.
+       */
+      static NOINLINE uintptr_t validate(TxThread* tx);
+
+      /**
+       *  A read is valid iff it occurs during a period where the seqlock
+       *  does not change and is even.  This code also polls for new changes
+       *  that might necessitate a validation.
+       */
+      static TM_FASTCALL void* read_ro(STM_READ_SIG(tx,addr,mask))
+      {
+          // read the location to a temp
+          void* tmp = *addr;
+          CFENCE;
+
+          // if the timestamp has changed since the last read, we must
+          // validate and restart this read
+          while (tx->start_time != timestamp.val) {
+              if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
+                  tx_abort(tx, ABORT_VALIDATION);
+              tmp = *addr;
+              CFENCE;
+          }
+
+          // log the address and value, uses the macro to deal with
+          // STM_PROTECT_STACK
+          STM_LOG_VALUE(tx, addr, tmp, mask);
+          return tmp;
+      }
+
+      static TM_FASTCALL void* read_rw(STM_READ_SIG(tx,addr,mask))
+      {
+          // check the log for a RAW hazard, we expect to miss
+          WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
+          bool found = tx->writes.find(log);
+          REDO_RAW_CHECK(found, log, mask);
+
+          // Use the code from the read-only read barrier. This is
+          // complicated by the fact that, when we are byte logging, we may
+          // have successfully read some bytes from the write log (if we read
+          // them all then we wouldn't make it here). In this case, we need
+          // to log the mask for the rest of the bytes that we "actually"
+          // need, which is computed as bytes in mask but not in log.mask.
+          // This is only correct because we know that a failed find also
+          // reset the log.mask to 0 (that's part of the find interface).
+          void* val = read_ro(tx, addr STM_MASK(mask & ~log.mask));
+          REDO_RAW_CLEANUP(val, found, log, mask);
+          return val;
+      }
+
+      /*** once we are in a writing context, just buffer the write */
+      static TM_FASTCALL void write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+      {
+          tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val,
+                                                              mask)));
+      }
+  };
+} // namespace stm
+
+#endif // INLINE_BARRIERS_HPP__
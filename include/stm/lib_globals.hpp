@@ -30,6 +30,9 @@ namespace stm
   void become_irrevoc();
   void restart();
   const char* get_algname();
+  stats_t get_stats();
+  const char* abort_cause_name(uint32_t cause);
+  void dump_conflict_heatmap(unsigned top = 10);
 
   extern pad_word_t  threadcount;           // threads in system
   extern TxThread*   threads[MAX_THREADS];  // all TxThreads
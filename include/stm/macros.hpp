@@ -73,6 +73,13 @@
 #   define STM_WRITE_SIG(tx, addr, val, mask) TxThread* tx, void** addr, void* val
 #endif
 
+/**
+ *  Range barriers read or write n whole, aligned words, so they never need a
+ *  mask
+ */
+#define STM_READ_RANGE_SIG(tx, addr, to, n)     TxThread* tx, void** addr, void** to, size_t n
+#define STM_WRITE_RANGE_SIG(tx, addr, from, n)  TxThread* tx, void** addr, void* const* from, size_t n
+
 #if defined(STM_ABORT_ON_THROW)
 #   define STM_ROLLBACK_SIG(tx, exception, len)  \
     TxThread* tx, void** exception, size_t len
@@ -185,6 +185,25 @@ namespace stm
   typedef MiniVector<nanorec_t>    NanorecList;  // <orec,val> pairs
   typedef MiniVector<void*>        AddressList;  // for the mmpolicy
 
+  /**
+   *  A function that the library API runs when a transaction commits or
+   *  aborts (see stm::on_commit and stm::on_abort)
+   */
+  struct tx_handler_t
+  {
+      void (*fn)(void*);
+      void*  arg;
+  };
+  typedef MiniVector<tx_handler_t> HandlerList;  // commit/abort handlers
+
+  /*** an increment that is deferred until commit (see stm::tx_add) */
+  struct deferred_add_t
+  {
+      volatile uintptr_t* addr;
+      uintptr_t           delta;
+  };
+  typedef MiniVector<deferred_add_t> AddList;    // deferred increments
+
   /**
    *  These are for counting consecutive aborts in a histogram.  We use them
    *  for measuring toxic transactions.  Note that there is special support
@@ -236,6 +255,235 @@ namespace stm
       void onHGAbort()        { }
   };
 
+  /**
+   *  A log-linear (HDR-style) histogram: values below 2^SUB_BITS get their
+   *  own bucket, and every power of two above that is split into 2^SUB_BITS
+   *  equal buckets, so the relative error of any bucket is at most
+   *  1/2^SUB_BITS.  Recording is a count-leading-zeros and an increment, so
+   *  it is cheap enough to do on every commit.  Histograms from different
+   *  threads merge by adding their buckets.
+   */
+  struct latency_hist_t
+  {
+      static const uint32_t SUB_BITS = 3;
+      static const uint32_t SUB      = 1u << SUB_BITS;
+      static const uint32_t BUCKETS  = (64 - SUB_BITS + 1) * SUB;
+
+      uint64_t count;                   // values recorded
+      uint64_t max;                     // largest value recorded
+      uint64_t buckets[BUCKETS];
+
+      latency_hist_t() { clear(); }
+
+      void clear()
+      {
+          count = max = 0;
+          for (uint32_t i = 0; i < BUCKETS; ++i)
+              buckets[i] = 0;
+      }
+
+      /*** map a value to its bucket */
+      static uint32_t index(uint64_t v)
+      {
+          if (v < SUB)
+              return (uint32_t)v;
+          uint32_t e = 63 - __builtin_clzll(v);
+          return (e - SUB_BITS + 1) * SUB + ((v >> (e - SUB_BITS)) & (SUB - 1));
+      }
+
+      /*** smallest value that maps to bucket i */
+      static uint64_t lowest(uint32_t i)
+      {
+          if (i < SUB)
+              return i;
+          uint32_t e = i / SUB + SUB_BITS - 1;
+          return (uint64_t)(SUB + i % SUB) << (e - SUB_BITS);
+      }
+
+      void record(uint64_t v)
+      {
+          ++buckets[index(v)];
+          ++count;
+          if (v > max)
+              max = v;
+      }
+
+      void merge(const latency_hist_t& h)
+      {
+          for (uint32_t i = 0; i < BUCKETS; ++i)
+              buckets[i] += h.buckets[i];
+          count += h.count;
+          if (h.max > max)
+              max = h.max;
+      }
+
+      /*** value at percentile p (0..100), as the low end of its bucket */
+      uint64_t percentile(double p) const
+      {
+          if (!count)
+              return 0;
+          uint64_t rank = (uint64_t)(p * count / 100.0);
+          if (rank >= count)
+              return max;
+          uint64_t seen = 0;
+          for (uint32_t i = 0; i < BUCKETS; ++i) {
+              seen += buckets[i];
+              if (seen > rank)
+                  return lowest(i);
+          }
+          return max;
+      }
+
+      /*** print count and the usual percentiles, labeled with name */
+      void dump(const char* name) const;
+  };
+
+  /**
+   *  Histogram of mode switch latencies, in ticks.  Bucket i counts switches
+   *  that took [2^i, 2^(i+1)) ticks.
+   */
+  struct switch_histogram_t
+  {
+      static const uint32_t BUCKETS = 48;
+
+      uint32_t count;            // number of switches
+      uint64_t total;            // sum of all latencies
+      uint64_t max;              // slowest switch
+      uint32_t buckets[BUCKETS]; // log2 histogram
+
+      /*** add one switch (only called by the thread doing the switch) */
+      void record(uint64_t ticks);
+
+      /*** simple printout */
+      void dump(const char* name) const;
+  };
+
+  /**
+   *  Why did a transaction abort?  The code that decides to abort sets
+   *  TxThread::abort_cause before calling tmabort, and PreRollback counts
+   *  the abort under that cause.
+   */
+  enum abort_cause_t {
+      ABORT_CONFLICT = 0,   // any other conflict (e.g., the CM said so)
+      ABORT_VALIDATION,     // a value or orec in the read set changed
+      ABORT_LOCKED,         // a location was locked by another transaction
+      ABORT_TOO_NEW,        // a location's timestamp is newer than our start
+      ABORT_RING,           // ring/filter overflow or intersection
+      ABORT_KILLED,         // another transaction aborted us remotely
+      ABORT_SWITCH,         // a mode switch or irrevocable tx is starting
+      ABORT_RESTART,        // the program called restart()
+      ABORT_IRREVOC,        // restarting in order to become irrevocable
+      ABORT_CAUSES
+  };
+
+  /**
+   *  Per-thread statistics counters.  Only the owning thread writes these,
+   *  but the stats aggregator reads them from other threads, so they are
+   *  padded onto their own cache lines instead of sharing lines with the
+   *  hot fields of the TxThread.
+   */
+  struct tx_stats_t
+  {
+      char     pad_before[CACHELINE_BYTES];
+      uint64_t commits;                 // read-write commits
+      uint64_t ro_commits;              // read-only commits
+      uint64_t restarts;                // calls to restart()
+      uint64_t aborts[ABORT_CAUSES];    // aborts, by cause
+      uint64_t tx_time;                 // ticks in transactions
+      uint64_t nontx_time;              // ticks between transactions
+#ifdef STM_LATENCY_HISTOGRAM_YES
+      latency_hist_t latency;           // ticks from first begin to commit
+      latency_hist_t attempts;          // attempts (1 + aborts) per commit
+#endif
+#ifdef STM_CONFLICT_ATTRIBUTION_YES
+      static const uint32_t CONFLICT_LOG = 16;
+      uint64_t conflicts_with[MAX_THREADS+1];   // aborts by owner id (0=?)
+      const volatile void* recent[CONFLICT_LOG];// latest conflict locations
+      uint32_t recent_cause[CONFLICT_LOG];      // ... and their causes
+      uint32_t recent_next;                     // next slot in recent[]
+#endif
+      char     pad_after[CACHELINE_BYTES];
+
+      tx_stats_t()
+          : commits(0), ro_commits(0), restarts(0), tx_time(0), nontx_time(0)
+      {
+          for (int i = 0; i < ABORT_CAUSES; ++i)
+              aborts[i] = 0;
+#ifdef STM_CONFLICT_ATTRIBUTION_YES
+          for (uint32_t i = 0; i <= MAX_THREADS; ++i)
+              conflicts_with[i] = 0;
+          for (uint32_t i = 0; i < CONFLICT_LOG; ++i) {
+              recent[i] = NULL;
+              recent_cause[i] = 0;
+          }
+          recent_next = 0;
+#endif
+      }
+
+      /**
+       *  On an outermost commit, record how long the transaction took,
+       *  including aborted attempts, and how many attempts it needed
+       */
+      void onCommit(uint64_t ticks, uint32_t tries)
+      {
+#ifdef STM_LATENCY_HISTOGRAM_YES
+          latency.record(ticks);
+          attempts.record(tries);
+#else
+          (void)ticks;
+          (void)tries;
+#endif
+      }
+
+      /*** total aborts, for any reason */
+      uint64_t total_aborts() const
+      {
+          uint64_t ans = 0;
+          for (int i = 0; i < ABORT_CAUSES; ++i)
+              ans += aborts[i];
+          return ans;
+      }
+  };
+
+  /**
+   *  A system-wide snapshot of the per-thread statistics, as returned by
+   *  stm::get_stats()
+   */
+  struct stats_t
+  {
+      uint64_t when;                    // tick() when the snapshot was taken
+      uint32_t threads;                 // number of threads summed
+      uint64_t commits;                 // read-write commits
+      uint64_t ro_commits;              // read-only commits
+      uint64_t restarts;                // calls to restart()
+      uint64_t aborts;                  // total aborts
+      uint64_t aborts_by_cause[ABORT_CAUSES];
+      uint64_t tx_time;                 // ticks in transactions
+      uint64_t nontx_time;              // ticks between transactions
+      latency_hist_t latency;           // merged per-thread latencies
+      latency_hist_t attempts;          // merged attempts per commit
+      switch_histogram_t blocking_switches; // stop-the-world switches
+      switch_histogram_t draining_switches; // switches that drained
+  };
+
+  /**
+   *  What ProfileApp measured, in the units of a CBR qtable row (see
+   *  load_qtable): per-transaction averages (ProfileAppAvg) or maxima, the
+   *  percentage of time spent in transactions, and the percentage of
+   *  read-only commits.
+   */
+  struct app_profile_t
+  {
+      uint64_t read_ro;
+      uint64_t read_rw_nonraw;
+      uint64_t read_rw_raw;
+      uint64_t write_nonwaw;
+      uint64_t write_waw;
+      uint64_t txn_time;
+      uint64_t pct_txtime;
+      uint64_t roratio;
+  };
+
 #ifdef STM_COUNTCONSEC_YES
   typedef toxic_histogram_t toxic_t;
 #else
@@ -0,0 +1,129 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  Per-thread event tracing.  When libstm is configured with
+ *  libstm_enable_event_trace, each TxThread keeps a ring of compact,
+ *  tick()-stamped events (begin, commit, abort, irrevocability, algorithm
+ *  switches, and time spent blocked in begin_blocker).  Only the owning
+ *  thread writes its ring, so recording an event is a tick() and a few
+ *  stores.  The rings are written to a file at shutdown, or when the
+ *  process receives SIGUSR2, and the stmtrace tool turns that file back
+ *  into timelines.
+ *
+ *  This file describes the on-disk format as well, so that stmtrace can
+ *  include it without pulling in the rest of libstm.
+ */
+
+#ifndef TRACE_HPP__
+#define TRACE_HPP__
+
+#include <stdint.h>
+#include "common/platform.hpp"
+
+namespace stm
+{
+  /*** the kinds of events we record */
+  enum trace_event_type_t {
+      EV_BEGIN = 1,     // outermost begin (first attempt only)
+      EV_COMMIT,        // outermost commit; arg = attempts
+      EV_ABORT,         // abort; code = abort_cause_t, arg = owner (0 = ?)
+      EV_IRREVOC,       // became irrevocable
+      EV_SWITCH,        // installed an algorithm; code = 1 if draining,
+                        //   arg = new algorithm id
+      EV_BLOCKED        // left begin_blocker; arg = ticks spent waiting
+  };
+
+  /*** one event: 16 bytes, so that four share a cache line */
+  struct trace_event_t
+  {
+      uint64_t when;    // tick()
+      uint8_t  type;    // trace_event_type_t
+      uint8_t  code;    // type-specific
+      uint16_t unused;
+      uint32_t arg;     // type-specific
+  };
+
+  /**
+   *  The file starts with a header, followed by the names of the
+   *  algorithms (so that EV_SWITCH can be decoded), followed by one
+   *  trace_thread_t per thread, each immediately followed by its events in
+   *  the order they happened.
+   */
+  static const char     TRACE_MAGIC[8]  = {'R','S','T','M','T','R','C','1'};
+  static const uint32_t TRACE_NAME_LEN  = 32;
+
+  struct trace_header_t
+  {
+      char     magic[8];
+      uint32_t threads;     // number of trace_thread_t records
+      uint32_t algs;        // number of TRACE_NAME_LEN-byte names
+  };
+
+  struct trace_thread_t
+  {
+      uint32_t id;          // TxThread id (starting at 1)
+      uint32_t unused;
+      uint64_t events;      // number of events that follow
+      uint64_t dropped;     // older events overwritten in the ring
+  };
+
+  /**
+   *  The ring itself.  'next' only grows, so the ring holds the last
+   *  (mask + 1) events.
+   */
+  struct trace_ring_t
+  {
+      trace_event_t* events;
+      uint64_t       next;
+      uint64_t       mask;
+
+      trace_ring_t() : events(0), next(0), mask(0) { }
+
+      void record(uint8_t type, uint8_t code, uint32_t arg)
+      {
+          trace_event_t& e = events[next & mask];
+          e.when = tick();
+          e.type = type;
+          e.code = code;
+          e.arg  = arg;
+          // make sure the event is complete before a dump can see it
+          CFENCE;
+          ++next;
+      }
+  };
+
+  struct TxThread;
+
+  /*** read STM_TRACE_EVENTS and STM_TRACE_FILE, and install the handler */
+  void trace_configure();
+
+  /*** give a new thread its ring */
+  void trace_init(TxThread* tx);
+
+  /**
+   *  Write all threads' rings to a file (by default, STM_TRACE_FILE).  The
+   *  SIGUSR2 handler calls this too, so it only uses write(2).
+   */
+  void trace_dump(const char* filename = 0);
+
+} // namespace stm
+
+/**
+ *  The instrumentation points use this macro, so that they vanish entirely
+ *  when tracing is compiled out.
+ */
+#ifdef STM_EVENT_TRACE_YES
+#define STM_TRACE(tx, type, code, arg) (tx)->trace.record(type, code, arg)
+#else
+#define STM_TRACE(tx, type, code, arg) ((void)0)
+#endif
+
+#endif // TRACE_HPP__
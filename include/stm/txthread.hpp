@@ -24,10 +24,36 @@
 #include "stm/WriteSet.hpp"
 #include "stm/UndoLog.hpp"
 #include "stm/ValueList.hpp"
+#include "stm/trace.hpp"
 #include "WBMMPolicy.hpp"
 
 namespace stm
 {
+  struct TxThread;
+
+  /*** the types of the per-thread barrier pointers */
+  typedef TM_FASTCALL void* (*ReadBarrier)(STM_READ_SIG(,,));
+  typedef TM_FASTCALL void (*WriteBarrier)(STM_WRITE_SIG(,,,));
+  typedef TM_FASTCALL void (*CommitBarrier)(TxThread*);
+  typedef TM_FASTCALL void (*ReadRangeBarrier)(STM_READ_RANGE_SIG(,,,));
+  typedef TM_FASTCALL void (*WriteRangeBarrier)(STM_WRITE_RANGE_SIG(,,,));
+
+  /**
+   *  Optional barriers for accesses whose history the caller knows, as the
+   *  ITM ABI's read-after-read, read-after-write, read-for-write,
+   *  write-after-read and write-after-write entry points do.  Each applies
+   *  to a single aligned word, and must work in every mode of the
+   *  algorithm.  A NULL entry means "use tmread/tmwrite".
+   */
+  struct barrier_hints_t
+  {
+      TM_FASTCALL void*(*read_after_read)(STM_READ_SIG(,,));
+      TM_FASTCALL void*(*read_after_write)(STM_READ_SIG(,,));
+      TM_FASTCALL void*(*read_for_write)(STM_READ_SIG(,,));
+      TM_FASTCALL void(*write_after_read)(STM_WRITE_SIG(,,,));
+      TM_FASTCALL void(*write_after_write)(STM_WRITE_SIG(,,,));
+  };
+
   /**
    *  The TxThread struct holds all of the metadata that a thread needs in
    *  order to use any of the STM algorithms we support.  In the past, this
@@ -48,10 +74,14 @@ namespace stm
       uint32_t       id;            // per thread id
       uint32_t       nesting_depth; // nesting; 0 == not in transaction
       WBMMPolicy     allocator;     // buffer malloc/free
-      uint32_t       num_commits;   // stats counter: commits
-      uint32_t       num_aborts;    // stats counter: aborts
-      uint32_t       num_restarts;  // stats counter: restart()s
-      uint32_t       num_ro;        // stats counter: read-only commits
+      uint32_t       abort_cause;   // why the current abort is happening
+#ifdef STM_CONFLICT_ATTRIBUTION_YES
+      const volatile void* conflict_addr;  // orec/lock/address of abort
+      uint32_t       conflict_owner;// thread that caused it (0 if unknown)
+#endif
+#ifdef STM_CONFLICT_HEATMAP_YES
+      uint32_t       heat_countdown;// orec aborts until the next sample
+#endif
       scope_t* volatile scope;      // used to roll back; also flag for isTxnl
 #ifdef STM_PROTECT_STACK
       void**         stack_high;    // the stack pointer at begin_tx time
@@ -89,10 +119,18 @@ namespace stm
       uint32_t       begin_wait;    // how long did last tx block at begin
       bool           strong_HG;     // for strong hourglass
       bool           irrevocable;   // tells begin_blocker that I'm THE ONE
+      uint32_t       alg;           // algorithm my read/write/commit are for
+      HandlerList    commit_handlers; // run after commit, in order
+      HandlerList    abort_handlers;  // run after rollback, in reverse
+      AddList        adds;          // increments to apply at commit
 
       /*** PER-THREAD FIELDS FOR ENABLING ADAPTIVITY POLICIES */
+      uint64_t      begin_txn_time;    // start of transactional work
       uint64_t      end_txn_time;      // end of non-transactional work
-      uint64_t      total_nontxn_time; // time on non-transactional work
+      tx_stats_t    stats;             // counters, read by the aggregator
+#ifdef STM_EVENT_TRACE_YES
+      trace_ring_t  trace;             // recent events, for stmtrace
+#endif
 
       /*** POINTERS TO INSTRUMENTATION */
 
@@ -121,6 +159,18 @@ namespace stm
       TM_FASTCALL void*(*tmread)(STM_READ_SIG(,,));
       TM_FASTCALL void(*tmwrite)(STM_WRITE_SIG(,,,));
 
+      /**
+       *  Per-thread range barriers, for memcpy-like accesses of several
+       *  whole words.  These belong to the algorithm rather than to its
+       *  current mode, so they are only changed when tmread/tmwrite are
+       *  replaced from outside the algorithm.
+       */
+      TM_FASTCALL void(*tmread_range)(STM_READ_RANGE_SIG(,,,));
+      TM_FASTCALL void(*tmwrite_range)(STM_WRITE_RANGE_SIG(,,,));
+
+      /*** Per-thread access hints; like the range barriers, per algorithm */
+      const barrier_hints_t* hints;
+
       /**
        * Some APIs, in particular the itm API at the moment, want to be able
        * to rollback the top level of nesting without actually unwinding the
@@ -144,9 +194,10 @@ namespace stm
       static bool(*tmirrevoc)(TxThread*);
 
       /**
-       * for shutting down threads.  Currently a no-op.
+       * for shutting down threads.  Hands back memory this thread freed on
+       * behalf of others; the TxThread itself is never destroyed.
        */
-      static void thread_shutdown() { }
+      static void thread_shutdown();
 
       /**
        * the init factory.  Construction of TxThread objects is only possible
@@ -156,11 +207,38 @@ namespace stm
     protected:
       TxThread();
       ~TxThread() { }
+
+#ifdef STM_NUMA_LOCAL_YES
+      /*** descriptors get their own pages, on their thread's node */
+      static void* operator new(size_t size);
+      static void operator delete(void* ptr, size_t size);
+#endif
   }; // class TxThread
 
   /*** GLOBAL VARIABLES RELATED TO THREAD MANAGEMENT */
   extern __thread TxThread* Self; // this thread's TxThread
 
+  /**
+   *  Abort the current transaction, recording why.  With conflict
+   *  attribution enabled, we also remember where the conflict was (an orec,
+   *  a lock, or an address, depending on the algorithm) and which thread
+   *  caused it, if we know.  Thread ids start at 1; 0 means unknown.
+   */
+  NORETURN
+  inline void tx_abort(TxThread* tx, abort_cause_t cause,
+                       const volatile void* where = NULL, uint32_t owner = 0)
+  {
+      tx->abort_cause = cause;
+#ifdef STM_CONFLICT_ATTRIBUTION_YES
+      tx->conflict_addr = where;
+      tx->conflict_owner = owner;
+#else
+      (void)where;
+      (void)owner;
+#endif
+      tx->tmabort(tx);
+  }
+
 } // namespace stm
 
 #endif // TXTHREAD_HPP__
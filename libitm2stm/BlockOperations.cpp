@@ -15,6 +15,9 @@ using stm::TxThread;
 using namespace itm2stm;
 
 namespace {
+// block_set writes from a buffer of copies of the fill word, this long
+const size_t SET_BUFFER_WORDS = 32;
+
 inline size_t
 read_subword(TxThread& tx, void** base, uint8_t* to, size_t i, size_t j) {
     assert(i < j && j <= sizeof(void*) && "range incorrect");
@@ -114,17 +117,16 @@ itm2stm::block_read(TxThread& tx, void* target, const void* source,
 
     // read as many word-sized chunks as we can from the remaining bytes
     const size_t words = (length - read) / sizeof(void*);
-    const uintptr_t mask = make_mask(0, sizeof(void*));
 
     // use the target pointers as a pointer to a word---this might not be
     // aligned, but that's ok because the write to "target" is nontransactional
     void** to = reinterpret_cast<void**>(target);
 
-    for (size_t i = 0; i < words; ++i, read += sizeof(void*))
-        to[i] = tx.tmread(&tx, base + i, mask);
+    // the algorithm's range barrier reads all of the words at once
+    tx.tmread_range(&tx, base, to, words);
 
     // return the number of bytes we've read
-    return read;
+    return read + words * sizeof(void*);
 }
 
 // -----------------------------------------------------------------------------
@@ -179,18 +181,17 @@ itm2stm::block_write(TxThread& tx, void* target, const void* source,
 
     // write as many word-sized chunks as we can from the remaining bytes
     const size_t words = (length - written) / sizeof(void*);
-    const uintptr_t mask = make_mask(0, sizeof(void*));
 
     // use the source address as a pointer to a word---this might not be
     // aligned, but that is ok because the read from the "source" is
     // nontransactional
     void* const * const from = reinterpret_cast<void* const *>(source);
 
-    for (size_t i = 0; i < words; ++i, written += sizeof(void*))
-        tx.tmwrite(&tx, base + i, from[i], mask);
+    // the algorithm's range barrier writes all of the words at once
+    tx.tmwrite_range(&tx, base, from, words);
 
     // return the number of bytes we've written
-    return written;
+    return written + words * sizeof(void*);
 }
 
 void
@@ -222,12 +223,20 @@ itm2stm::block_set(TxThread& tx, void* target, uint8_t c, size_t length) {
         ++base; // update target address
     }
 
-    // write as many word-sized chunks as we can from the remaining bytes
+    // write as many word-sized chunks as we can from the remaining bytes,
+    // handing them to the range barrier a buffer at a time
     const size_t words = length / sizeof(void*);
-    const uintptr_t mask = make_mask(0, sizeof(void*));
-
-    for (size_t i = 0; i < words; ++i, length -= sizeof(void*))
-        tx.tmwrite(&tx, base + i, from.word, mask);
+    void* buffer[SET_BUFFER_WORDS];
+    for (size_t i = 0; i < SET_BUFFER_WORDS && i < words; ++i)
+        buffer[i] = from.word;
+
+    for (size_t i = 0; i < words; i += SET_BUFFER_WORDS) {
+        size_t n = words - i;
+        if (n > SET_BUFFER_WORDS)
+            n = SET_BUFFER_WORDS;
+        tx.tmwrite_range(&tx, base + i, buffer, n);
+    }
+    length -= words * sizeof(void*);
 
     // deal with any postfix bytes
     if (length)
@@ -11,8 +11,10 @@
 #ifndef STM_ITM2STM_BLOCK_OPERATIONS_H
 #define STM_ITM2STM_BLOCK_OPERATIONS_H
 
+#include <cassert>
 #include <cstddef>
 #include <stdint.h>
+#include "Utilities.h"
 
 // -----------------------------------------------------------------------------
 // These block operations are used in the implementations of all of the memcpy,
@@ -81,6 +83,104 @@ struct BlockWriter {
         return block_write(tx_, to, from, length);
     }
 };
+
+// -----------------------------------------------------------------------------
+// The block_copy template is parameterized by the actual algorithms that we
+// want to use on the read side and the write set. Essentially, this just manages a
+// buffer, copying chunks from the read-side into it, and copying it out into
+// the write-side.
+//
+// The buffer isn't a circular buffer due to the difficulty of dealing with
+// wrapping transactional accesses, so after each iteration there may be a
+// residual number of bytes left in the buffer (due to mis-alignment) that we
+// need to copy to the front of the buffer. This amount is bounded by
+// sizeof(void*) though, so its just a constant operation.
+// -----------------------------------------------------------------------------
+template <typename R, typename W>
+inline void
+block_copy(void* to, const void* from, size_t len, R reader, W writer) {
+    // Allocate our buffer.
+    const size_t capacity = 8 * sizeof(void*);
+    uint8_t buffer[capacity];
+    size_t size = 0;
+
+    // main loop copies chunks through the buffer
+    while (len) {
+        // get the minimum that we can read
+        const size_t to_read = (capacity - size < len) ? capacity - size : len;
+
+        // might not read requested amount due to alignement
+        const size_t read = reader(buffer + size, from, to_read);
+        size += read; // update our buffer size
+        len -= read;  // the remaining bytes to read
+        add_bytes(from, read); // and the from cursor
+
+        // might not write requested amount due to alignment
+        const size_t wrote = writer(to, buffer, size);
+        size -= wrote; // update our buffer size
+        add_bytes(to, wrote); // and the to cursor
+
+        // copy the unwritten bytes into the beginning of the buffer
+        for (size_t i = 0; i < size; ++i)
+            buffer[i] = buffer[wrote + i];
+    }
+
+    // force the writer to write out the rest of the buffer (it could have
+    // refused if there was an alignment issue in the loop)
+    if (size) {
+        assert(offset_of(to) == 0 && "unexpected unaligned \"to\" cursor");
+        assert(size < sizeof(void*) && "unexpected length remaining");
+        size -= writer(to, buffer, size);
+        assert(size == 0 && "draining write not performed");
+    }
+}
+
+// ----------------------------------------------------------------------------
+// The basic block_move loop. A real memmove only needs two branches and simply
+// selects between memcpy from source with ++ or memcpy from source + len with
+// --. We don't have that functionality yet.
+// ----------------------------------------------------------------------------
+template <typename R, typename W>
+inline void
+block_move(void* to, const void* from, size_t len, R reader, W writer)
+{
+    uint8_t* target = static_cast<uint8_t*>(to);
+    const uint8_t* source = static_cast<const uint8_t*>(from);
+
+    // target, target + len, source, source + len
+    // target, source, target + len, source + len
+    //
+    // if the target is less than the source address, then we always read the
+    // source bytes before we overwrite them and we can use our basic memcpy
+    if (target < source)
+        block_copy(to, from, len, reader, writer);
+
+    // source, source + len, target, target + len
+    //
+    // if the target doesn't overlap the source then we won't ever write on top
+    // of the source and we're ok
+    else if (source + len <= target)
+        block_copy(to, from, len, reader, writer);
+
+    // source, target, source + len, target + len
+    //
+    // here we have to writer from source + len to target + len backwards, but
+    // our memcpy can't yet handle that.
+    else
+        assert(false && "memmove not yet implemented for overlapping regions.");
+}
+
+// ----------------------------------------------------------------------------
+// Our block_copy loop needs a slightly different interface than the libc
+// memcpy provides. It needs the function to return the number of bytes
+// actually read (because our transactional versions might refuse to write some
+// bytes due to alignment issues).
+// ----------------------------------------------------------------------------
+inline size_t
+builtin_memcpy_wrapper(void* to, const void* from, size_t n) {
+    __builtin_memcpy(to, from, n);
+    return n;
+}
 }
 
 #endif // STM_ITM2STM_BLOCK_OPERATIONS_H
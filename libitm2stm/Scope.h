@@ -12,7 +12,7 @@
 #define STM_ITM2STM_SCOPE_H
 
 #include <utility>            // std::pair
-#include "libitm.h"           // _ITM_ stuff
+#include "libitm-types.h"     // _ITM_ stuff
 #include "Checkpoint.h"       // class Checkpoint
 #include "stm/MiniVector.hpp"
 
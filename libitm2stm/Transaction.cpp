@@ -8,12 +8,15 @@
  *          Please see the file LICENSE.RSTM for licensing information
  */
 
-#include "libitm.h"
+#include <cassert>
+#include "libitm-types.h"
 #include "Transaction.h"
 #include "Scope.h"
 #include "CheckOffsets.h"
+#include "stm/txthread.hpp"
 using namespace stm;
 using namespace itm2stm;
+using std::pair;
 
 _ITM_transaction::Node::~Node() {
 #if defined(NODE_NEXT_)
@@ -43,3 +46,243 @@ _ITM_transaction::~_ITM_transaction() {
     delete scopes_;
     delete free_scopes_;
 }
+
+/// When we're reentering a scope, the node has been pushed onto the free list,
+/// we need to take the node off that list, and then call enter using its
+/// existing flags. This happens during explicit abort and cancel and for
+/// conflict aborts via tmabort (libitm-5.1,5.cpp)---which call restart.
+uint32_t
+_ITM_transaction::reenter(Node* const scope) {
+    assert(free_scopes_ == scope && "Invariant violation");
+    free_scopes_ = free_scopes_->next_;
+    return enter(scope, scope->getFlags());
+}
+
+/// Rollback requires that we do everything required to eliminate the effects of
+/// the inner scope. After rollback we will need to leave the scope for it to be
+/// removed from the scopes stack.
+void
+_ITM_transaction::rollback() {
+    // Our scope's rollback tells us the exception object range, so that the
+    // rstm library can either a) avoid undo-ing to that region, or b) actually
+    // redo to that region.
+    pair<void**, size_t>& thrown = inner()->rollback();
+
+    // NB: In the current version of libstm We have a mismatch between the
+    //     fact that the shim is using closed nesting, and the library is
+    //     using subsumption. In addition to this meaning that things like
+    //     nested cancels will fail, it means that we have to be careful about
+    //     what we ask the library to do.
+    //
+    //     One thing that we *can't* do is call rollback on the RSTM
+    //     descriptor unless it is an outermost scope rollback (outermost from
+    //     the perspective of the shim's closed nesting), because there is
+    //     hard-coded logic behind the call that expects it to be rolling back
+    //     completely.
+    //
+    //     This means that intermediate rollbacks as a part of a nested
+    //     restart or cancel will fail... no problem since we don't support
+    //     them in nested context. Rollback is also called repeatedly by the
+    //     shim to get to the outermost scope. If that's what's going on, we
+    //     want it to succeed.
+    if (--thread_handle_.nesting_depth == 0) {
+        // This call *will* pop and return the scope that the library has as
+        // it's scope field. It also *will* reset the nesting depth to 0, which
+        // is why we can only call it once we know the depth is supposed to be
+        // 0. It's not relevant that we've already set the depth to 0; that
+        // behavior is to support RSTM's "library" API.
+        thread_handle_.tmrollback(&thread_handle_, thrown.first,
+                                  thrown.second);
+        thread_handle_.stack_high = 0x0;
+        thread_handle_.stack_low = (void**)~0x0;
+    }
+}
+
+/// Cancel is used to rollback the innermost transaction and continue execution
+/// after the transaction block. It is only used to implement an explicit,
+/// user-level cancel operation.
+void
+_ITM_transaction::cancel() {
+    rollback();
+    Node* scope = leave();
+    scope->restore(a_abortTransaction | a_restoreLiveVariables);
+}
+
+/// Restart will rollback the inner scope, and restart execution using the
+/// "reenter" call. This is used to both support explicit, user-level retry, and
+/// as a response to a conflict (via tmabort in libstm-5.1,5.cpp).
+void
+_ITM_transaction::restart() {
+    rollback();
+    Node* scope = leave();
+    uint32_t mode = reenter(scope);
+    scope->restore(mode | a_restoreLiveVariables);
+}
+
+/// This handles explicit user-level cancel and retry calls. There is some
+/// complicated logic specified in the ITM ABI spec that we need to implement
+/// here, primarily to figure out where we need to restart execution.
+void
+_ITM_transaction::abort(_ITM_abortReason why) {
+    // CASE 4: If the reason is exceptionBlockAbort, then we are supposed to act
+    //         like the previous, non-exceptionBlockAbort reason, if there is
+    //         one, or TMConflict if there isn't one.
+    //
+    //         If the reason is something else, we remember this reason in
+    //          prev_abort_reason_. This sets prev_abort_ = true as a side
+    //          effect (see the union declaration an Transaction.h).
+    if (why & exceptionBlockAbort)
+        why = (prev_abort_) ? prev_abort_reason_ : TMConflict;
+    else
+        prev_abort_reason_ = why;
+
+    // CASE 1: cancel the scope if this is a simple user abort, or if the
+    //         current transaction is an exception block transaction---a
+    //         condition that I don't truly understand but which is easy enough
+    //         to implement.
+    if (inner()->isExceptionBlock() || why & userAbort)
+        cancel(); // noreturn
+
+    assert(why & (userRetry | TMConflict) && "Should be one of these cases.");
+
+    // find the innermost transaction that isn't an exception block
+    Node* scope = inner();
+    while (scope != outer_scope_) {
+        if (scope->isExceptionBlock()) {
+            // CASE 2: if we found an exception block, then we'll jump to it and
+            //         signal abort like CASE 1, except we set the outermost
+            //         scope as aborted---per spec.
+            outer_scope_->setAborted(true);
+            cancel(); // noreturn
+        }
+        // incrementally rollback and leave the scope
+        rollback();
+        leave();
+        scope = inner(); // updates loop variable
+    }
+
+    // CASE 3: we're restarting the top scope
+    restart(); // noreturn
+}
+
+/// Pops the inner scope onto the free list. The commit and abort paths both
+/// use this.
+_ITM_transaction::Node*
+_ITM_transaction::leave() {
+    Node* scope = inner();
+    scopes_ = scope->next_;
+    scope->next_ = free_scopes_;
+    free_scopes_ = scope;
+    outer_scope_ = (scopes_) ? outer_scope_ : NULL;
+    return scope;
+}
+
+/// Handles the _ITM_commitTransaction call. Simply asks the library to
+/// commit. If the library commit call actually returns, then there weren't any
+/// conflicts. If it didn't return then everything was handled by tmabort.
+void
+_ITM_transaction::commit() {
+    // This code was pilfered from <stm/api/library.hpp>.
+
+    // Don't commit anything if we're nested... just exit this scope, this
+    // hopefully respects libstm's lack of closed nesting for the moment.
+    //
+    // Don't pre-decerement the nesting depth, because the tmcommit call can
+    // fail due to a conflict. This calls tmabort, and tmabort will fail if the
+    // nesting depth is 0.
+    if (thread_handle_.nesting_depth == 1)
+    {
+        // the commit hooks reset consec_aborts, so read it first
+        uint32_t attempts = thread_handle_.consec_aborts + 1;
+
+        // dispatch to the appropriate end function
+        thread_handle_.tmcommit(&thread_handle_);
+
+        // // zero scope (to indicate "not in tx")
+        CFENCE;
+        thread_handle_.scope = NULL;
+
+        // clear the high/low stack marks.
+        thread_handle_.stack_high = 0x0;
+        thread_handle_.stack_low = (void**)~0x0;
+
+        // record end of transactional time and start of nontransactional
+        // time, this misses the itm2stm commit and leave time for the
+        // outermost scope, but I think we're ok.
+        uint64_t now = tick();
+        if (thread_handle_.begin_txn_time) {
+            uint64_t latency = now - thread_handle_.begin_txn_time;
+            thread_handle_.stats.tx_time += latency;
+            thread_handle_.stats.onCommit(latency, attempts);
+        }
+        STM_TRACE(&thread_handle_, EV_COMMIT, 0, attempts);
+        thread_handle_.begin_txn_time = 0;
+        thread_handle_.end_txn_time = now;
+    }
+
+    // Decrement the nesting depth unconditionally here. It's needed on a nested
+    // commit, as well as after the tmcommit succeeds for the outermost scope.
+    --thread_handle_.nesting_depth;
+
+    inner()->commit();
+    leave(); // don't care about the returned node during a commit
+}
+
+/// Supports the ITM tryCommit operation. There isn't currently an analog to
+/// this in the rstm library, so we'll fail for now.
+bool
+_ITM_transaction::tryCommit() {
+    assert(false && "tryCommit not yet implemented.");
+    // if (rstm_try_commit)
+    inner()->commit();
+    leave();
+    return true;
+}
+
+/// This is supposed to clear the scopes up to the specified ID, without
+/// checking for conflicts. This can't be implemented by RSTM yet.
+void
+_ITM_transaction::commitToId(_ITM_transactionId_t id) {
+    assert(false && "commitToId not yet implemented.");
+    for (Node* scope = inner(); scope->getId() > id; scope = inner()) {
+        // rstm_merge_scopes_without_aborting
+        scope->commit();
+        leave();
+    }
+}
+
+void
+_ITM_transaction::registerOnAbort(_ITM_userUndoFunction f, void* arg) {
+    inner()->registerOnAbort(f, arg);
+}
+
+void
+_ITM_transaction::registerOnCommit(_ITM_userCommitFunction f,
+                                  _ITM_transactionId_t tid, void* arg)
+{
+    Node* scope = inner();
+    while (scope->getId() > tid)
+        scope = scope->next_;
+
+    assert(scope->getId() == tid && "asked for a scope that doesn't exist");
+    scope->registerOnCommit(f, arg);
+}
+
+/// This is what the stm library will call when it detects a conflict and needs
+/// to abort. We always retry in this case, and if we have a registered thrown
+/// object we ignore it (the thrown object only pertains to explicit
+/// cancel-and-throw calls, which must happen in a consistent context).
+///
+/// Don't need any of the funky user-visible abort handling because the abort is
+/// invisible. Just treat it like a restart of the current scope. Both ABIs pass
+/// this to sys_init.
+void
+itm2stm::conflict_abort(TxThread* tx) {
+    // Clear the exception object if there is one. This is because we are
+    // called due to conflict aborts, and the exception isn't going to reach the
+    // boundary. If we leave it in the scope, the rollback will filter out
+    // rollback behavior for it, which we don't want.
+    Scope* scope = static_cast<Scope*>(tx->scope);
+    scope->clearThrownObject();
+    scope->getOwner().restart();
+}
@@ -11,7 +11,7 @@
 #ifndef STM_ITM2STM_TRANSACTION_H
 #define STM_ITM2STM_TRANSACTION_H
 
-#include "libitm.h"
+#include "libitm-types.h"
 #include "Scope.h"
 
 namespace stm {
@@ -24,11 +24,11 @@ struct TxThread;
 /// private, even though we can't use a private modifier because of the way
 /// _ITM_transaction is declared.
 ///
-/// The implementation of these functions is distributed throughout the
-/// Transaction.cpp and libitm-*.cpp files, so that we don't have to have all of
-/// the inline implementations in this header---most of them are only used in
-/// the single libitm file that is relevent to them. Anything that we need
-/// inlined in more than one source file is defined here.
+/// The implementation of these functions is in Transaction.cpp and
+/// libitm-5.7.cpp, rather than in the libitm-*.cpp files that use them, because
+/// both the Intel ABI entry points and the gcc ABI entry points in gcc/ are
+/// implemented in terms of them. Anything that we need inlined in more than one
+/// source file is defined here.
 ///
 /// We use gcc's "fastcall" calling convention for those things that we don't
 /// inline here but are used across multiple source files (there aren't that
@@ -162,10 +162,6 @@ struct _ITM_transaction {
     /// call. Leave reclaims the scope (though it is still safe to use... it's
     /// just on the free list for the next call to getScope).
     ///
-    /// This needs to be fast for the commit code, and it's also used in the
-    /// abort path, so we implement it in libitm-5.9.cpp so it can get inlined
-    /// there (we're not super-concerned about the abort performance).
-    ///
     /// We use the GCC fastcall calling convention so that it's as efficient as
     /// possible in the abort path for x86.
     GCC_FASTCALL Node* leave() __attribute__((used));
@@ -178,7 +174,7 @@ struct _ITM_transaction {
     /// rolling back and leaving (popping) the scope, and then re-executing the
     /// enter functionality, which puts the scope back on the scopes stack.
     ///
-    /// Inlined in libitm-5.8, and marked as used for tmabort in libitm-5.1,5.
+    /// Marked as used for the conflict abort handler in libitm-5.1,5.
     void restart() NORETURN
         __attribute__((used));
 
@@ -191,11 +187,16 @@ struct _ITM_transaction {
     /// 5.4 and 5.7, but implemented in 5.7 because we'd like to inine it there.
     GCC_FASTCALL bool libraryIsInevitable() const;
 
-    /// These basically just forward to the correct scopes. Defined in
-    /// itm2stm-5.17.cpp, where they are used.
+    /// These basically just forward to the correct scopes.
     void registerOnAbort(_ITM_userUndoFunction, void* arg);
     void registerOnCommit(_ITM_userCommitFunction, _ITM_transactionId_t, void*
                           arg);
 };
 
+namespace itm2stm {
+/// The conflict abort handler that we give to stm::sys_init. It restarts the
+/// inner scope. Defined in Transaction.cpp.
+void conflict_abort(stm::TxThread*) NORETURN;
+}
+
 #endif // STM_ITM2STM_TRANSACTION_H
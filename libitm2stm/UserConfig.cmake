@@ -10,4 +10,12 @@
 option(
   itm2stm_enable_assert_on_irrevocable
   "ON causes calls to _ITM_changeTransactionMode to fail (useful for debuggin)"
-  OFF)
\ No newline at end of file
+  OFF)
+
+include (CMakeDependentOption)
+
+cmake_dependent_option(
+  itm2stm_enable_gcc_abi
+  "ON builds gccitm2stm, which implements gcc's -fgnu-tm ABI, and gcc TM benchmarks"
+  OFF
+  "CMAKE_COMPILER_IS_GNUCXX" OFF)
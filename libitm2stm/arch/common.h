@@ -11,6 +11,15 @@
 #ifndef STM_ITM2STM_ARCH_COMMON_H
 #define STM_ITM2STM_ARCH_COMMON_H
 
+/// The gcc ABI library keeps our Intel-style _ITM_beginTransaction, under a
+/// private name, and exports its own _ITM_beginTransaction that finds the
+/// thread's descriptor and then tail-calls it (see gcc_beginTransaction.S).
+#ifdef ITM2STM_GCC_ABI
+#define ITM2STM_BEGIN_TRANSACTION _stm_itm2stm_begin_transaction
+#else
+#define ITM2STM_BEGIN_TRANSACTION _ITM_beginTransaction
+#endif
+
 #define ITM_SAVE_LIVE_VARIABLES 0x04
 #define ITM_ABORT_FLAGS 0x18
 
@@ -0,0 +1,108 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+// Transactional allocation for the gcc ABI. gcc turns malloc, calloc and free
+// inside of a transaction into _ITM_malloc, _ITM_calloc, and _ITM_free, and
+// new and delete into calls to their transactional clones, which it expects
+// the TM library to provide under their mangled _ZGTt names. All of them go to
+// the libstm allocator, so that allocations are undone on abort and frees are
+// deferred until commit.
+//
+// NB: like stm::tx_alloc, memory that comes from here must be freed with
+//     _ITM_free (or tx_free), not free, when libstm uses its slab allocator.
+
+#include <cstring>
+#include "gcc/libitm.h"
+#include "stm/txthread.hpp"
+using stm::Self;
+
+void*
+_ITM_malloc(size_t size) {
+    return Self->allocator.txAlloc(size);
+}
+
+void*
+_ITM_calloc(size_t n, size_t size) {
+    // like calloc, fail if n * size overflows
+    if (size && n > static_cast<size_t>(-1) / size)
+        return NULL;
+    void* p = Self->allocator.txAlloc(n * size);
+    if (p)
+        memset(p, 0, n * size);
+    return p;
+}
+
+void
+_ITM_free(void* p) {
+    if (p)
+        Self->allocator.txFree(p);
+}
+
+// The clones get asm labels because they are C++ names, mangled with the
+// size_t mangling, which differs between 32 and 64 bits.
+#if defined(__LP64__)
+#define SIZE_T_MANGLING "m"
+#else
+#define SIZE_T_MANGLING "j"
+#endif
+
+void* tx_new(size_t) asm("_ZGTtnw" SIZE_T_MANGLING);
+void* tx_new_array(size_t) asm("_ZGTtna" SIZE_T_MANGLING);
+void* tx_new_nothrow(size_t, const void*)
+    asm("_ZGTtnw" SIZE_T_MANGLING "RKSt9nothrow_t");
+void* tx_new_array_nothrow(size_t, const void*)
+    asm("_ZGTtna" SIZE_T_MANGLING "RKSt9nothrow_t");
+void tx_delete(void*) asm("_ZGTtdlPv");
+void tx_delete_array(void*) asm("_ZGTtdaPv");
+void tx_delete_nothrow(void*, const void*) asm("_ZGTtdlPvRKSt9nothrow_t");
+void tx_delete_array_nothrow(void*, const void*)
+    asm("_ZGTtdaPvRKSt9nothrow_t");
+void tx_delete_sized(void*, size_t) asm("_ZGTtdlPv" SIZE_T_MANGLING);
+void tx_delete_array_sized(void*, size_t) asm("_ZGTtdaPv" SIZE_T_MANGLING);
+
+void* tx_new(size_t size) {
+    return _ITM_malloc(size);
+}
+
+void* tx_new_array(size_t size) {
+    return _ITM_malloc(size);
+}
+
+void* tx_new_nothrow(size_t size, const void*) {
+    return _ITM_malloc(size);
+}
+
+void* tx_new_array_nothrow(size_t size, const void*) {
+    return _ITM_malloc(size);
+}
+
+void tx_delete(void* p) {
+    _ITM_free(p);
+}
+
+void tx_delete_array(void* p) {
+    _ITM_free(p);
+}
+
+void tx_delete_nothrow(void* p, const void*) {
+    _ITM_free(p);
+}
+
+void tx_delete_array_nothrow(void* p, const void*) {
+    _ITM_free(p);
+}
+
+void tx_delete_sized(void* p, size_t) {
+    _ITM_free(p);
+}
+
+void tx_delete_array_sized(void* p, size_t) {
+    _ITM_free(p);
+}
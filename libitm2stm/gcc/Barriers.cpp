@@ -0,0 +1,198 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+// The gcc ABI read, write, log, memcpy, memmove and memset barriers. These are
+// the same as the Intel barriers in libitm-5.12.cpp through libitm-5.16.cpp,
+// except that they find the transaction descriptor through libstm's
+// thread-local TxThread, and the _ITM_transaction through the scope it is
+// running.
+
+#include "gcc/libitm.h"
+#include "Transaction.h"
+#include "Scope.h"
+#include "Instrumentation.h"
+#include "BlockOperations.h"
+#include "stm/txthread.hpp"
+using stm::TxThread;
+using namespace itm2stm;
+
+namespace {
+/// The _ITM_transaction is the owner of the libstm descriptor's current
+/// scope. We only need it for stack filtering and logging, so the common read
+/// barriers never touch it.
+inline _ITM_transaction*
+current(const TxThread& tx) {
+    return &static_cast<Scope*>(tx.scope)->getOwner();
+}
+}
+
+#define BARRIERS(TYPE, EXT)                                             \
+    TYPE                                                                \
+    _ITM_R##EXT(const TYPE* address) {                                  \
+        return INST<TYPE>::Read(*stm::Self, address);                   \
+    }                                                                   \
+                                                                        \
+    TYPE                                                                \
+    _ITM_RaR##EXT(const TYPE* address) {                                \
+        TxThread& tx = *stm::Self;                                      \
+        return hinted_read(tx, address, tx.hints->read_after_read);     \
+    }                                                                   \
+                                                                        \
+    TYPE                                                                \
+    _ITM_RaW##EXT(const TYPE* address) {                                \
+        TxThread& tx = *stm::Self;                                      \
+        return hinted_read(tx, address, tx.hints->read_after_write);    \
+    }                                                                   \
+                                                                        \
+    TYPE                                                                \
+    _ITM_RfW##EXT(const TYPE* address) {                                \
+        TxThread& tx = *stm::Self;                                      \
+        return hinted_read(tx, address, tx.hints->read_for_write);      \
+    }                                                                   \
+                                                                        \
+    void                                                                \
+    _ITM_W##EXT(TYPE* address, const TYPE value) {                      \
+        TxThread& tx = *stm::Self;                                      \
+        if (is_stack_write(current(tx), address))                       \
+            *address = value;                                           \
+        else                                                            \
+            INST<TYPE>::Write(tx, address, value);                      \
+    }                                                                   \
+                                                                        \
+    void                                                                \
+    _ITM_WaR##EXT(TYPE* address, const TYPE value) {                    \
+        TxThread& tx = *stm::Self;                                      \
+        if (is_stack_write(current(tx), address)) {                     \
+            *address = value;                                           \
+            return;                                                     \
+        }                                                               \
+        hinted_write(tx, address, value, tx.hints->write_after_read);   \
+    }                                                                   \
+                                                                        \
+    void                                                                \
+    _ITM_WaW##EXT(TYPE* address, const TYPE value) {                    \
+        TxThread& tx = *stm::Self;                                      \
+        if (is_stack_write(current(tx), address)) {                     \
+            *address = value;                                           \
+            return;                                                     \
+        }                                                               \
+        hinted_write(tx, address, value, tx.hints->write_after_write);  \
+    }                                                                   \
+                                                                        \
+    void                                                                \
+    _ITM_L##EXT(const TYPE* address) {                                  \
+        current(*stm::Self)->inner()->log(address);                     \
+    }
+
+BARRIERS(uint8_t, U1)
+BARRIERS(uint16_t, U2)
+BARRIERS(uint32_t, U4)
+BARRIERS(uint64_t, U8)
+BARRIERS(float, F)
+BARRIERS(double, D)
+BARRIERS(long double, E)
+// INST<__m64> and friends drop the vector types' may_alias attribute, which
+// gcc warns about. That's harmless here, since we build with
+// -fno-strict-aliasing.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+BARRIERS(__m64, M64)
+BARRIERS(__m128, M128)
+#ifdef __AVX__
+BARRIERS(__m256, M256)
+#endif
+#pragma GCC diagnostic pop
+BARRIERS(_Complex float, CF)
+BARRIERS(_Complex double, CD)
+BARRIERS(_Complex long double, CE)
+
+/// Same as the Intel _ITM_LB in libitm-5.16.cpp.
+void
+_ITM_LB(const void* addr, size_t bytes) {
+    void**  address = reinterpret_cast<void**>(const_cast<void*>(addr));
+    Scope* scope = current(*stm::Self)->inner();
+
+    for (size_t i = 0, e = bytes / sizeof(void*); i < e; ++i)
+        scope->log(address + i, address[i], sizeof(void*));
+
+    if (size_t e = bytes % sizeof(void*)) {
+        const uint8_t* address8 = reinterpret_cast<const uint8_t*>(addr);
+        address8 += bytes - e;
+
+        union {
+            uint8_t bytes[sizeof(void*)];
+            void* word;
+        } buffer = {{0}};
+
+        for (size_t i = 0; i < e; ++i)
+            buffer.bytes[i] = address8[i];
+
+        scope->log(reinterpret_cast<void**>(const_cast<uint8_t*>(address8)),
+                   buffer.word, e);
+    }
+}
+
+/// The memcpy and memmove barriers, named by what they do to each side: Rn
+/// and Wn are nontransactional, Rt and Wt are transactional, and the aR/aW
+/// variants (after read, after write) are treated as Rt/Wt.
+#define COPY_NT(NAME, OP)                                               \
+    void                                                                \
+    _ITM_##NAME(void* to, const void* from, size_t n) {                 \
+        BlockWriter writer(*stm::Self);                                 \
+        OP(to, from, n, builtin_memcpy_wrapper, writer);                \
+    }
+#define COPY_TN(NAME, OP)                                               \
+    void                                                                \
+    _ITM_##NAME(void* to, const void* from, size_t n) {                 \
+        BlockReader reader(*stm::Self);                                 \
+        OP(to, from, n, reader, builtin_memcpy_wrapper);                \
+    }
+#define COPY_TT(NAME, OP)                                               \
+    void                                                                \
+    _ITM_##NAME(void* to, const void* from, size_t n) {                 \
+        BlockReader reader(*stm::Self);                                 \
+        BlockWriter writer(*stm::Self);                                 \
+        OP(to, from, n, reader, writer);                                \
+    }
+
+#define BLOCK_OPERATIONS(OP, NAME)                      \
+    COPY_NT(NAME##RnWt, OP)                             \
+    COPY_NT(NAME##RnWtaR, OP)                           \
+    COPY_NT(NAME##RnWtaW, OP)                           \
+    COPY_TN(NAME##RtWn, OP)                             \
+    COPY_TT(NAME##RtWt, OP)                             \
+    COPY_TT(NAME##RtWtaR, OP)                           \
+    COPY_TT(NAME##RtWtaW, OP)                           \
+    COPY_TN(NAME##RtaRWn, OP)                           \
+    COPY_TT(NAME##RtaRWt, OP)                           \
+    COPY_TT(NAME##RtaRWtaR, OP)                         \
+    COPY_TT(NAME##RtaRWtaW, OP)                         \
+    COPY_TN(NAME##RtaWWn, OP)                           \
+    COPY_TT(NAME##RtaWWt, OP)                           \
+    COPY_TT(NAME##RtaWWtaR, OP)                         \
+    COPY_TT(NAME##RtaWWtaW, OP)
+
+BLOCK_OPERATIONS(block_copy, memcpy)
+BLOCK_OPERATIONS(block_move, memmove)
+
+void
+_ITM_memsetW(void* target, int c, size_t n) {
+    block_set(*stm::Self, target, static_cast<uint8_t>(c), n);
+}
+
+void
+_ITM_memsetWaR(void* target, int c, size_t n) {
+    block_set(*stm::Self, target, static_cast<uint8_t>(c), n);
+}
+
+void
+_ITM_memsetWaW(void* target, int c, size_t n) {
+    block_set(*stm::Self, target, static_cast<uint8_t>(c), n);
+}
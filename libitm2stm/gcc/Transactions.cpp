@@ -0,0 +1,282 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+// The gcc ABI transaction entry points, and the thread-local descriptor that
+// they use. Everything forwards to the same _ITM_transaction members as the
+// Intel ABI entry points in libitm-5.*.cpp.
+//
+// This object is always linked (gcc_beginTransaction.S needs
+// _stm_itm2stm_gcc_transaction), which matters for the clone table functions:
+// crtbegin only has weak references to them.
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include "gcc/libitm.h"
+#include "Transaction.h"
+#include "Scope.h"
+#include "stm/txthread.hpp"
+#include "stm/lib_globals.hpp"
+#include "itm/itm.h"
+using namespace stm;
+using namespace itm2stm;
+
+namespace {
+/// Our thread local transaction descriptor.
+__thread _ITM_transaction* td = NULL;
+
+/// gcc programs don't call _ITM_initializeProcess or _ITM_initializeThread, so
+/// the first transaction in the process initializes libstm, and the first
+/// transaction in each thread initializes the thread.
+pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+void
+shutdown() {
+    sys_shutdown();
+}
+
+void
+init() {
+    sys_init(conflict_abort);
+    atexit(shutdown);
+}
+
+/// The (function, clone) pairs that crtbegin hands us, one table per object
+/// file. We keep a short list of tables, since lookups only happen for
+/// indirect calls inside of transactions. Tables are registered before main
+/// (or by dlopen), so we only lock to change the list, not to search it.
+struct CloneTable {
+    void**      pairs;
+    size_t      size;
+    CloneTable* next;
+};
+
+CloneTable* clone_tables = NULL;
+pthread_mutex_t clone_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void*
+find_clone(void* f) {
+    for (CloneTable* t = clone_tables; t; t = t->next)
+        for (size_t i = 0; i < t->size; ++i)
+            if (t->pairs[2 * i] == f)
+                return t->pairs[2 * i + 1];
+    return NULL;
+}
+}
+
+/// Called from gcc_beginTransaction.S to find the descriptor to pass to the
+/// Intel-style _ITM_beginTransaction. This has an asm label for the same
+/// reason as _ITM_transaction::enter.
+_ITM_transaction*
+gcc_transaction() asm("_stm_itm2stm_gcc_transaction");
+
+_ITM_transaction*
+gcc_transaction() {
+    if (__builtin_expect(td == NULL, false)) {
+        pthread_once(&init_once, init);
+        TxThread::thread_init();
+        td = new _ITM_transaction(*stm::Self);
+    }
+    return td;
+}
+
+// Programs that use the rstm cxxtm api call these explicitly, and we honor
+// them, but they aren't required.
+int
+_ITM_initializeProcess(void) {
+    return _ITM_initializeThread();
+}
+
+int
+_ITM_initializeThread(void) {
+    return gcc_transaction() != NULL;
+}
+
+void
+_ITM_finalizeThread(void) {
+}
+
+void
+_ITM_finalizeProcess(void) {
+}
+
+void
+_ITM_commitTransaction(void) {
+    td->commit();
+}
+
+/// When an exception escapes an atomic transaction the transaction commits. We
+/// don't need the exception pointer because the exception object was allocated
+/// nontransactionally.
+void
+_ITM_commitTransactionEH(void*) {
+    td->commit();
+}
+
+/// Abort reasons work the same way as they do in the Intel ABI, except for
+/// __transaction_cancel [[outer]], which cancels the outermost transaction
+/// rather than the innermost one.
+void
+_ITM_abortTransaction(_ITM_abortReason why) {
+    if (why & outerAbort) {
+        while (td->inner() != td->outer()) {
+            td->rollback();
+            td->leave();
+        }
+        td->cancel();
+    }
+    td->abort(why);
+}
+
+/// The only mode change is to serial irrevocable, which the compiler asks for
+/// before calling something that isn't transaction safe.
+void
+_ITM_changeTransactionMode(_ITM_transactionState state) {
+    assert(state == modeSerialIrrevocable && "Unexpected state change request");
+#ifdef ITM2STM_ASSERT_ON_IRREVOCABLE
+    assert(false);
+#endif
+    stm::become_irrevoc();
+}
+
+_ITM_howExecuting
+_ITM_inTransaction(void) {
+    if (!td || !td->inner())
+        return outsideTransaction;
+    if (td->libraryIsInevitable())
+        return inIrrevocableTransaction;
+    return inRetryableTransaction;
+}
+
+/// Our ids start at _ITM_NoTransactionId + 1, which is gcc's
+/// _ITM_noTransactionId, so we shift them up by one.
+_ITM_gccTransactionId_t
+_ITM_getTransactionId(void) {
+    if (!td || !td->inner())
+        return _ITM_noTransactionId;
+    return td->inner()->getId() + 1;
+}
+
+/// gcc uses _ITM_noTransactionId to mean "when the whole transaction commits",
+/// which is the outer scope.
+void
+_ITM_addUserCommitAction(_ITM_userCommitFunction f,
+                         _ITM_gccTransactionId_t tid, void* arg) {
+    if (tid == _ITM_noTransactionId)
+        td->outer()->registerOnCommit(f, arg);
+    else
+        td->registerOnCommit(f, static_cast<_ITM_transactionId_t>(tid - 1), arg);
+}
+
+void
+_ITM_addUserUndoAction(_ITM_userUndoFunction f, void* arg) {
+    td->registerOnAbort(f, arg);
+}
+
+void
+_ITM_dropReferences(void*, size_t) {
+}
+
+int
+_ITM_versionCompatible(int i) {
+    return (i <= _ITM_VERSION_NO);
+}
+
+const char*
+_ITM_libraryVersion(void) {
+    return _ITM_VERSION;
+}
+
+void
+_ITM_error(const _ITM_srcLocation* src, int errorCode) {
+    fprintf(stderr, "_ITM_ encountered error code: %i with source location %s\n",
+            errorCode, (src) ? src->psource : "unknown");
+    exit(1);
+}
+
+void
+_ITM_registerTMCloneTable(void* table, size_t size) {
+    CloneTable* t = new CloneTable();
+    t->pairs = static_cast<void**>(table);
+    t->size = size;
+    pthread_mutex_lock(&clone_lock);
+    t->next = clone_tables;
+    clone_tables = t;
+    pthread_mutex_unlock(&clone_lock);
+}
+
+void
+_ITM_deregisterTMCloneTable(void* table) {
+    pthread_mutex_lock(&clone_lock);
+    for (CloneTable** t = &clone_tables; *t; t = &(*t)->next) {
+        if ((*t)->pairs == table) {
+            CloneTable* dead = *t;
+            *t = dead->next;
+            delete dead;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&clone_lock);
+}
+
+/// An indirect call to something without a transactional clone has to run
+/// irrevocably, and then it can call the original.
+void*
+_ITM_getTMCloneOrIrrevocable(void* f) {
+    if (void* clone = find_clone(f))
+        return clone;
+    stm::become_irrevoc();
+    return f;
+}
+
+void*
+_ITM_getTMCloneSafe(void* f) {
+    void* clone = find_clone(f);
+    if (!clone)
+        _ITM_error(NULL, 0);
+    return clone;
+}
+
+// The C++ exception ABI. Exceptions are allocated and thrown
+// nontransactionally, and either commit the transaction they escape from
+// (_ITM_commitTransactionEH) or are caught inside of it.
+extern "C" {
+void* __cxa_allocate_exception(size_t);
+void __cxa_free_exception(void*);
+void __cxa_throw(void*, void*, void (*)(void*)) _ITM_NORETURN;
+void* __cxa_begin_catch(void*);
+void __cxa_end_catch(void);
+}
+
+void*
+_ITM_cxa_allocate_exception(size_t size) {
+    return __cxa_allocate_exception(size);
+}
+
+void
+_ITM_cxa_free_exception(void* obj) {
+    __cxa_free_exception(obj);
+}
+
+void
+_ITM_cxa_throw(void* obj, void* tinfo, void (*dest)(void*)) {
+    __cxa_throw(obj, tinfo, dest);
+}
+
+void*
+_ITM_cxa_begin_catch(void* exc) {
+    return __cxa_begin_catch(exc);
+}
+
+void
+_ITM_cxa_end_catch(void) {
+    __cxa_end_catch();
+}
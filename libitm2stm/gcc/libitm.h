@@ -0,0 +1,155 @@
+/** -*- C++ -*-
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+// -----------------------------------------------------------------------------
+// The gcc (-fgnu-tm) dialect of the TM ABI. It is the Intel ABI in
+// libitm2stm/libitm.h with a few differences.
+//
+//  1) No call gets passed an _ITM_transaction*, and no call gets passed an
+//     _ITM_srcLocation*. We find the descriptor through TLS.
+//  2) On x86 everything uses regparm(2), except _ITM_beginTransaction, which
+//     is variadic.
+//  3) Transaction ids are 64 bits, and the "no transaction" id is 1.
+//  4) There is an outerAbort reason, clone tables for transactional versions
+//     of functions, transactional allocation, and wrappers for the C++
+//     exception ABI.
+//
+// Everything in section 4 (the enums and callback types) is shared with the
+// Intel ABI, through libitm-types.h.
+// -----------------------------------------------------------------------------
+#ifndef STM_ITM2STM_GCC_LIBITM_H
+#define STM_ITM2STM_GCC_LIBITM_H
+
+#include "libitm-types.h"
+
+#if defined(__LP64__)
+#define ITM_REGPARM
+#else
+#define ITM_REGPARM REGPARM(2)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define _ITM_noTransactionId 1
+
+/// gcc's extra abort reason, for __transaction_cancel [[outer]].
+enum { outerAbort = 16 };
+
+typedef uint64_t _ITM_gccTransactionId_t;
+
+uint32_t _ITM_beginTransaction(uint32_t, ...);
+void _ITM_commitTransaction(void) ITM_REGPARM;
+void _ITM_commitTransactionEH(void*) ITM_REGPARM;
+void _ITM_abortTransaction(_ITM_abortReason) ITM_REGPARM _ITM_NORETURN;
+void _ITM_changeTransactionMode(_ITM_transactionState) ITM_REGPARM;
+_ITM_howExecuting _ITM_inTransaction(void) ITM_REGPARM;
+_ITM_gccTransactionId_t _ITM_getTransactionId(void) ITM_REGPARM;
+void _ITM_addUserCommitAction(_ITM_userCommitFunction, _ITM_gccTransactionId_t,
+                              void*) ITM_REGPARM;
+void _ITM_addUserUndoAction(_ITM_userUndoFunction, void*) ITM_REGPARM;
+void _ITM_dropReferences(void*, size_t) ITM_REGPARM;
+int _ITM_versionCompatible(int) ITM_REGPARM;
+const char* _ITM_libraryVersion(void) ITM_REGPARM;
+void _ITM_error(const _ITM_srcLocation*, int) ITM_REGPARM _ITM_NORETURN;
+
+/// The compiler registers a table of (function, transactional clone) pairs for
+/// each object file from crtbegin, and looks clones up for indirect calls.
+void _ITM_registerTMCloneTable(void*, size_t);
+void _ITM_deregisterTMCloneTable(void*);
+void* _ITM_getTMCloneOrIrrevocable(void*) ITM_REGPARM;
+void* _ITM_getTMCloneSafe(void*) ITM_REGPARM;
+
+void* _ITM_malloc(size_t);
+void* _ITM_calloc(size_t, size_t);
+void _ITM_free(void*);
+
+void* _ITM_cxa_allocate_exception(size_t);
+void _ITM_cxa_free_exception(void*);
+void _ITM_cxa_throw(void*, void*, void (*)(void*)) _ITM_NORETURN;
+void* _ITM_cxa_begin_catch(void*);
+void _ITM_cxa_end_catch(void);
+
+#define DECLARE_BARRIERS(TYPE, EXT)                                     \
+    TYPE _ITM_R##EXT(const TYPE*) ITM_REGPARM;                          \
+    TYPE _ITM_RaR##EXT(const TYPE*) ITM_REGPARM;                        \
+    TYPE _ITM_RaW##EXT(const TYPE*) ITM_REGPARM;                        \
+    TYPE _ITM_RfW##EXT(const TYPE*) ITM_REGPARM;                        \
+    void _ITM_W##EXT(TYPE*, TYPE) ITM_REGPARM;                          \
+    void _ITM_WaR##EXT(TYPE*, TYPE) ITM_REGPARM;                        \
+    void _ITM_WaW##EXT(TYPE*, TYPE) ITM_REGPARM;                        \
+    void _ITM_L##EXT(const TYPE*) ITM_REGPARM;
+
+DECLARE_BARRIERS(uint8_t, U1)
+DECLARE_BARRIERS(uint16_t, U2)
+DECLARE_BARRIERS(uint32_t, U4)
+DECLARE_BARRIERS(uint64_t, U8)
+DECLARE_BARRIERS(float, F)
+DECLARE_BARRIERS(double, D)
+DECLARE_BARRIERS(long double, E)
+DECLARE_BARRIERS(__m64, M64)
+DECLARE_BARRIERS(__m128, M128)
+#ifdef __AVX__
+DECLARE_BARRIERS(__m256, M256)
+#endif
+DECLARE_BARRIERS(_Complex float, CF)
+DECLARE_BARRIERS(_Complex double, CD)
+DECLARE_BARRIERS(_Complex long double, CE)
+
+#undef DECLARE_BARRIERS
+
+void _ITM_LB(const void*, size_t) ITM_REGPARM;
+
+#define DECLARE_BLOCK_OPERATION(NAME)                                   \
+    void _ITM_##NAME(void*, const void*, size_t) ITM_REGPARM;
+
+DECLARE_BLOCK_OPERATION(memcpyRnWt)
+DECLARE_BLOCK_OPERATION(memcpyRnWtaR)
+DECLARE_BLOCK_OPERATION(memcpyRnWtaW)
+DECLARE_BLOCK_OPERATION(memcpyRtWn)
+DECLARE_BLOCK_OPERATION(memcpyRtWt)
+DECLARE_BLOCK_OPERATION(memcpyRtWtaR)
+DECLARE_BLOCK_OPERATION(memcpyRtWtaW)
+DECLARE_BLOCK_OPERATION(memcpyRtaRWn)
+DECLARE_BLOCK_OPERATION(memcpyRtaRWt)
+DECLARE_BLOCK_OPERATION(memcpyRtaRWtaR)
+DECLARE_BLOCK_OPERATION(memcpyRtaRWtaW)
+DECLARE_BLOCK_OPERATION(memcpyRtaWWn)
+DECLARE_BLOCK_OPERATION(memcpyRtaWWt)
+DECLARE_BLOCK_OPERATION(memcpyRtaWWtaR)
+DECLARE_BLOCK_OPERATION(memcpyRtaWWtaW)
+DECLARE_BLOCK_OPERATION(memmoveRnWt)
+DECLARE_BLOCK_OPERATION(memmoveRnWtaR)
+DECLARE_BLOCK_OPERATION(memmoveRnWtaW)
+DECLARE_BLOCK_OPERATION(memmoveRtWn)
+DECLARE_BLOCK_OPERATION(memmoveRtWt)
+DECLARE_BLOCK_OPERATION(memmoveRtWtaR)
+DECLARE_BLOCK_OPERATION(memmoveRtWtaW)
+DECLARE_BLOCK_OPERATION(memmoveRtaRWn)
+DECLARE_BLOCK_OPERATION(memmoveRtaRWt)
+DECLARE_BLOCK_OPERATION(memmoveRtaRWtaR)
+DECLARE_BLOCK_OPERATION(memmoveRtaRWtaW)
+DECLARE_BLOCK_OPERATION(memmoveRtaWWn)
+DECLARE_BLOCK_OPERATION(memmoveRtaWWt)
+DECLARE_BLOCK_OPERATION(memmoveRtaWWtaR)
+DECLARE_BLOCK_OPERATION(memmoveRtaWWtaW)
+
+#undef DECLARE_BLOCK_OPERATION
+
+void _ITM_memsetW(void*, int, size_t) ITM_REGPARM;
+void _ITM_memsetWaR(void*, int, size_t) ITM_REGPARM;
+void _ITM_memsetWaW(void*, int, size_t) ITM_REGPARM;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif // STM_ITM2STM_GCC_LIBITM_H
@@ -25,25 +25,6 @@ using namespace itm2stm;
 namespace {
 /// Our thread local transaction descriptor.
 static __thread _ITM_transaction* td = NULL;
-
-/// This is what the stm library will call when it detects a conflict and needs
-/// to abort. We always retry in this case, and if we have a registered thrown
-/// object we ignore it (the thrown object only pertains to explicit
-/// cancel-and-throw calls, which must happen in a consistent context).
-///
-/// Don't need any of the funky user-visible abort handling because the abort is
-/// invisible. Just treat it like a restart of the current scope. This is passed
-/// to sys_init.
-void
-tmabort(stm::TxThread* tx) {
-    // Clear the exception object if there is one. This is because tmabort is
-    // called due to conflict aborts, and the exception isn't going to reach the
-    // boundary. If we leave it in the scope, the rollback will filter out
-    // rollback behavior for it, which we don't want.
-    Scope* scope = static_cast<Scope*>(tx->scope);
-    scope->clearThrownObject();
-    scope->getOwner().restart();
-}
 }
 
 // 5.1  Initialization and finalization functions
@@ -51,7 +32,7 @@ tmabort(stm::TxThread* tx) {
 int
 _ITM_initializeProcess(void) {
     if (td == NULL)
-        sys_init(tmabort);
+        sys_init(conflict_abort);
     return _ITM_initializeThread();
 }
 
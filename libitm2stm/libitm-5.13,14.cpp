@@ -8,117 +8,14 @@
  *          Please see the file LICENSE.RSTM for licensing information
  */
 
-#include <cassert>
 #include "libitm.h"
 #include "Transaction.h"
 #include "BlockOperations.h"
-#include "Utilities.h"
-using stm::TxThread;
 using itm2stm::BlockReader;
 using itm2stm::BlockWriter;
-using itm2stm::add_bytes;
-using itm2stm::offset_of;
-
-namespace {
-// -----------------------------------------------------------------------------
-// The memcpy template is parameterized by the actual algorithms that we want to
-// use on the read side and the write set. Essentially, this just manages a
-// buffer, copying chunks from the read-side into it, and copying it out into
-// the write-side.
-//
-// The buffer isn't a circular buffer due to the difficulty of dealing with
-// wrapping transactional accesses, so after each iteration there may be a
-// residual number of bytes left in the buffer (due to mis-alignment) that we
-// need to copy to the front of the buffer. This amount is bounded by
-// sizeof(void*) though, so its just a constant operation.
-// -----------------------------------------------------------------------------
-template <typename R, typename W>
-inline void
-memcpy(void* to, const void* from, size_t len, R reader, W writer) {
-    // Allocate our buffer.
-    const size_t capacity = 8 * sizeof(void*);
-    uint8_t buffer[capacity];
-    size_t size = 0;
-
-    // main loop copies chunks through the buffer
-    while (len) {
-        // get the minimum that we can read
-        const size_t to_read = (capacity - size < len) ? capacity - size : len;
-
-        // might not read requested amount due to alignement
-        const size_t read = reader(buffer + size, from, to_read);
-        size += read; // update our buffer size
-        len -= read;  // the remaining bytes to read
-        add_bytes(from, read); // and the from cursor
-
-        // might not write requested amount due to alignment
-        const size_t wrote = writer(to, buffer, size);
-        size -= wrote; // update our buffer size
-        add_bytes(to, wrote); // and the to cursor
-
-        // copy the unwritten bytes into the beginning of the buffer
-        for (size_t i = 0; i < size; ++i)
-            buffer[i] = buffer[wrote + i];
-    }
-
-    // force the writer to write out the rest of the buffer (it could have
-    // refused if there was an alignment issue in the loop)
-    if (size) {
-        assert(offset_of(to) == 0 && "unexpected unaligned \"to\" cursor");
-        assert(size < sizeof(void*) && "unexpected length remaining");
-        size -= writer(to, buffer, size);
-        assert(size == 0 && "draining write not performed");
-    }
-}
-
-// ----------------------------------------------------------------------------
-// The basic memmove loop. A real memmove only needs two branches and simply
-// selects between memcpy from source with ++ or memcpy from source + len with
-// --. We don't have that functionality yet.
-// ----------------------------------------------------------------------------
-template <typename R, typename W>
-inline void
-memmove(void* to, const void* from, size_t len, R reader, W writer)
-{
-    uint8_t* target = static_cast<uint8_t*>(to);
-    const uint8_t* source = static_cast<const uint8_t*>(from);
-
-    // target, target + len, source, source + len
-    // target, source, target + len, source + len
-    //
-    // if the target is less than the source address, then we always read the
-    // source bytes before we overwrite them and we can use our basic memcpy
-    if (target < source)
-        memcpy(to, from, len, reader, writer);
-
-    // source, source + len, target, target + len
-    //
-    // if the target doesn't overlap the source then we won't ever write on top
-    // of the source and we're ok
-    else if (source + len <= target)
-        memcpy(to, from, len, reader, writer);
-
-    // source, target, source + len, target + len
-    //
-    // here we have to writer from source + len to target + len backwards, but
-    // our memcpy can't yet handle that.
-    else
-        assert(false && "memmove not yet implemented for overlapping regions.");
-}
-
-
-// ----------------------------------------------------------------------------
-// Our memcpy loop needs a slightly different interface than the libc memcpy
-// provides. It needs the function to return the number of bytes actually read
-// (because our transactional versions might refuse to write some bytes due to
-// alignment issues).
-// ----------------------------------------------------------------------------
-inline size_t
-builtin_memcpy_wrapper(void* to, const void* from, size_t n) {
-    __builtin_memcpy(to, from, n);
-    return n;
-}
-}
+using itm2stm::block_copy;
+using itm2stm::block_move;
+using itm2stm::builtin_memcpy_wrapper;
 
 // ----------------------------------------------------------------------------
 // 5.13  Transactional memory copies ------------------------------------------
@@ -127,28 +24,28 @@ void
 _ITM_memcpyRnWt(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, builtin_memcpy_wrapper, writer);
+    block_copy(to, from, n, builtin_memcpy_wrapper, writer);
 }
 
 void
 _ITM_memcpyRnWtaR(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, builtin_memcpy_wrapper, writer);
+    block_copy(to, from, n, builtin_memcpy_wrapper, writer);
 }
 
 void
 _ITM_memcpyRnWtaW(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, builtin_memcpy_wrapper, writer);
+    block_copy(to, from, n, builtin_memcpy_wrapper, writer);
 }
 
 void
 _ITM_memcpyRtWn(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
-    memcpy(to, from, n, reader, builtin_memcpy_wrapper);
+    block_copy(to, from, n, reader, builtin_memcpy_wrapper);
 }
 
 void
@@ -156,7 +53,7 @@ _ITM_memcpyRtWt(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 void
@@ -164,7 +61,7 @@ _ITM_memcpyRtWtaR(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 void
@@ -172,14 +69,14 @@ _ITM_memcpyRtWtaW(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 void
 _ITM_memcpyRtaRWn(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
-    memcpy(to, from, n, reader, builtin_memcpy_wrapper);
+    block_copy(to, from, n, reader, builtin_memcpy_wrapper);
 }
 
 void
@@ -187,7 +84,7 @@ _ITM_memcpyRtaRWt(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 void
@@ -195,7 +92,7 @@ _ITM_memcpyRtaRWtaR(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 void
@@ -203,14 +100,14 @@ _ITM_memcpyRtaRWtaW(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 void
 _ITM_memcpyRtaWWn(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
-    memcpy(to, from, n, reader, builtin_memcpy_wrapper);
+    block_copy(to, from, n, reader, builtin_memcpy_wrapper);
 }
 
 void
@@ -218,7 +115,7 @@ _ITM_memcpyRtaWWt(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 void
@@ -226,7 +123,7 @@ _ITM_memcpyRtaWWtaR(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 void
@@ -234,7 +131,7 @@ _ITM_memcpyRtaWWtaW(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memcpy(to, from, n, reader, writer);
+    block_copy(to, from, n, reader, writer);
 }
 
 // ----------------------------------------------------------------------------
@@ -244,21 +141,21 @@ void
 _ITM_memmoveRnWt(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockWriter writer(td->handle());
-    memmove(to, from, n, builtin_memcpy_wrapper, writer);
+    block_move(to, from, n, builtin_memcpy_wrapper, writer);
 }
 
 void
 _ITM_memmoveRnWtaR(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockWriter writer(td->handle());
-    memmove(to, from, n, builtin_memcpy_wrapper, writer);
+    block_move(to, from, n, builtin_memcpy_wrapper, writer);
 }
 
 void
 _ITM_memmoveRnWtaW(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockWriter writer(td->handle());
-    memmove(to, from, n, builtin_memcpy_wrapper, writer);
+    block_move(to, from, n, builtin_memcpy_wrapper, writer);
 }
 
 
@@ -266,7 +163,7 @@ void
 _ITM_memmoveRtWn(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
-    memmove(to, from, n, reader, builtin_memcpy_wrapper);
+    block_move(to, from, n, reader, builtin_memcpy_wrapper);
 }
 
 void
@@ -274,7 +171,7 @@ _ITM_memmoveRtWt(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
 
 void
@@ -282,7 +179,7 @@ _ITM_memmoveRtWtaR(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
 
 void
@@ -290,14 +187,14 @@ _ITM_memmoveRtWtaW(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
 
 void
 _ITM_memmoveRtaRWn(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
-    memmove(to, from, n, reader, builtin_memcpy_wrapper);
+    block_move(to, from, n, reader, builtin_memcpy_wrapper);
 }
 
 void
@@ -305,7 +202,7 @@ _ITM_memmoveRtaRWt(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
 
 void
@@ -313,7 +210,7 @@ _ITM_memmoveRtaRWtaR(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
 
 void
@@ -321,14 +218,14 @@ _ITM_memmoveRtaRWtaW(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
 
 void
 _ITM_memmoveRtaWWn(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
-    memmove(to, from, n, reader, builtin_memcpy_wrapper);
+    block_move(to, from, n, reader, builtin_memcpy_wrapper);
 }
 
 void
@@ -336,7 +233,7 @@ _ITM_memmoveRtaWWt(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
 
 void
@@ -344,7 +241,7 @@ _ITM_memmoveRtaWWtaR(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
 
 void
@@ -352,5 +249,5 @@ _ITM_memmoveRtaWWtaW(_ITM_transaction* td, void* to, const void* from, size_t n)
 {
     BlockReader reader(td->handle());
     BlockWriter writer(td->handle());
-    memmove(to, from, n, reader, writer);
+    block_move(to, from, n, reader, writer);
 }
@@ -63,12 +63,16 @@ _ITM_transaction::enter(Node* const scope, const uint32_t flags) {
 #endif
 
         // Some adaptivity mechanisms need to know nontransactional and
-        // transactional time.  This code suffices, because it gets the time
-        // between transactions.  If we need the time for a single transaction,
-        // we need to use ProfileTM.
-        if (thread_handle_.end_txn_time)
-            thread_handle_.total_nontxn_time += (tick() -
-                                                 thread_handle_.end_txn_time);
+        // transactional time.  We only sample the clock on the first attempt,
+        // so that time spent in aborted attempts counts as transactional.
+        if (!thread_handle_.begin_txn_time) {
+            uint64_t now = tick();
+            if (thread_handle_.end_txn_time)
+                thread_handle_.stats.nontx_time +=
+                    (now - thread_handle_.end_txn_time);
+            thread_handle_.begin_txn_time = now;
+            STM_TRACE(&thread_handle_, EV_BEGIN, 0, 0);
+        }
 
         // Now call the per-algorithm begin function.
         irrevocable = TxThread::tmbegin(&thread_handle_);
@@ -77,6 +81,16 @@ _ITM_transaction::enter(Node* const scope, const uint32_t flags) {
         irrevocable = libraryIsInevitable();
     }
 
+    // The gcc ABI begins a transaction that must run irrevocably (e.g., one
+    // that calls an unsafe function before doing anything else) without an
+    // instrumented code path, so we need to get irrevocable before we return.
+    // If this has to abort to get there, we'll come back through here as
+    // irrevocable.
+    if (!irrevocable && !(flags & pr_instrumentedCode)) {
+        stm::become_irrevoc();
+        irrevocable = true;
+    }
+
     // We need to tell the caller what mode we'd like to run in. If the STM
     // library has become inevitable, and there's an uninstrumented code path
     // available, we'll choose that. Otherwise run the normally instrumented
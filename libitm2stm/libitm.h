@@ -17,85 +17,12 @@
 #define STM_ITM2STM_LIBITM_H
 
 #include <itm/itm.h>    // The public header for client use (like 5.1)
+#include "libitm-types.h" // section 4
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#include <stdint.h>     // uint32_t
-#include <stdbool.h>    // bool for tryCommitTransaction
-#include <immintrin.h>  // sse-specific type __m256, __m128, __m64
-
-// -----------------------------------------------------------------------------
-// 4  Types and macro list -----------------------------------------------------
-// -----------------------------------------------------------------------------
-#define _ITM_VERSION            "0.9 (October 1, 2008)"
-#define _ITM_VERSION_NO         90
-#define _ITM_NoTransactionId    0
-
-#define _ITM_NORETURN NORETURN
-
-/* Values used as arguments to abort. */
-typedef enum {
-    userAbort           = 1,
-    userRetry           = 2,
-    TMConflict          = 4,
-    exceptionBlockAbort = 8
-} _ITM_abortReason;
-
-/* Arguments to changeTransactionMode */
-typedef enum {
-    modeSerialIrrevocable
-} _ITM_transactionState;
-
-/* Results from inTransaction */
-typedef enum {
-    outsideTransaction = 0,    /* So "if (inTransaction(td))" works */
-    inRetryableTransaction,
-    inIrrevocableTransaction
-} _ITM_howExecuting;
-
-/* Values to describe properties of code, passed in to startTransaction */
-typedef enum {
-    pr_instrumentedCode     = 0x0001,
-    pr_uninstrumentedCode   = 0x0002,
-    pr_multiwayCode         = pr_instrumentedCode | pr_uninstrumentedCode,
-    pr_hasNoXMMUpdate       = 0x0004,
-    pr_hasNoAbort           = 0x0008,
-    pr_hasNoRetry           = 0x0010,
-    pr_hasNoIrrevocable     = 0x0020,
-    pr_doesGoIrrevocable    = 0x0040,
-    pr_hasNoSimpleReads     = 0x0080,
-    pr_aWBarriersOmitted    = 0x0100,
-    pr_RaRBarriersOmitted   = 0x0200,
-    pr_undoLogCode          = 0x0400,
-    pr_preferUninstrumented = 0x0800,
-    pr_exceptionBlock       = 0x1000,
-    pr_hasElse              = 0x2000
-} _ITM_codeProperties;
-
-/* Result from startTransaction that describes what actions to take.  */
-typedef enum {
-    a_runInstrumentedCode       = 0x01,
-    a_runUninstrumentedCode     = 0x02,
-    a_saveLiveVariables         = 0x04,
-    a_restoreLiveVariables      = 0x08,
-    a_abortTransaction          = 0x10
-} _ITM_actions;
-
-typedef struct {
-    uint32_t reserved_1;
-    uint32_t flags;
-    uint32_t reserved_2;
-    uint32_t reserved_3;
-    const char* psource;
-} _ITM_srcLocation;
-
-typedef struct _ITM_transaction _ITM_transaction;
-typedef uint32_t _ITM_transactionId_t;
-typedef void (*_ITM_userUndoFunction)(void*);
-typedef void (*_ITM_userCommitFunction)(void*);
-
 // -----------------------------------------------------------------------------
 // 5.2  Version checking -------------------------------------------------------
 // -----------------------------------------------------------------------------
@@ -0,0 +1,172 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  The slow paths of the slab allocator: carving chunks, recognizing our
+ *  own blocks, and moving blocks between threads.
+ */
+
+#include <stm/config.h>
+
+#ifdef STM_SLAB_ALLOCATOR_YES
+
+#include <stm/SlabAllocator.hpp>
+#include "common/platform.hpp"
+
+using namespace stm;
+
+namespace
+{
+  /*** chunks are CHUNK_BYTES long, and aligned to CHUNK_BYTES */
+  const uintptr_t CHUNK_BITS  = 16;
+  const uintptr_t CHUNK_BYTES = 1 << CHUNK_BITS;
+
+  /*** the first cache line of every chunk describes it */
+  struct slab_chunk_t
+  {
+      uint32_t owner;   // thread whose freelists the blocks belong to
+      uint32_t sclass;  // size class of every block in the chunk
+  };
+
+  /**
+   *  Every chunk we've ever made, as (address >> CHUNK_BITS) + 1, in an
+   *  insert-only open-addressed table.  Chunks are never returned to the
+   *  system, so entries never go away.  When the table fills up (256K
+   *  chunks, or 16GB) we stop making chunks and use malloc instead.
+   */
+  const uint32_t     TABLE_SIZE = 1 << 18;
+  volatile uintptr_t chunk_table[TABLE_SIZE];
+
+  inline uint32_t hash(uintptr_t key)
+  {
+      return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 40) % TABLE_SIZE;
+  }
+
+  bool register_chunk(void* chunk)
+  {
+      uintptr_t key = ((uintptr_t)chunk >> CHUNK_BITS) + 1;
+      for (uint32_t i = hash(key), n = 0; n < TABLE_SIZE;
+           i = (i + 1) % TABLE_SIZE, ++n)
+      {
+          if (!chunk_table[i] && bcasptr(&chunk_table[i], 0ul, key))
+              return true;
+      }
+      return false;
+  }
+
+  /*** the chunk holding ptr, or NULL if ptr isn't one of our blocks */
+  slab_chunk_t* find_chunk(void* ptr)
+  {
+      uintptr_t key = ((uintptr_t)ptr >> CHUNK_BITS) + 1;
+      for (uint32_t i = hash(key), n = 0; n < TABLE_SIZE;
+           i = (i + 1) % TABLE_SIZE, ++n)
+      {
+          uintptr_t k = chunk_table[i];
+          if (k == key)
+              return (slab_chunk_t*)((key - 1) << CHUNK_BITS);
+          if (!k)
+              return NULL;
+      }
+      return NULL;
+  }
+
+  /*** each thread's inbox of blocks freed by other threads */
+  pad_word_t inbox[SlabAllocator::OWNERS] = {{0}};
+} // (anonymous namespace)
+
+namespace stm
+{
+  void* SlabAllocator::refill(uint32_t c)
+  {
+      // first, take back anything that other threads have freed for us
+      slab_block_t* b = (slab_block_t*)inbox[owner].val;
+      while (b && !bcasptr(&inbox[owner].val, (uintptr_t)b, 0ul))
+          b = (slab_block_t*)inbox[owner].val;
+      while (b) {
+          slab_block_t* next = b->next;
+          uint32_t bc = find_chunk(b)->sclass;
+          b->next = freelist[bc];
+          freelist[bc] = b;
+          b = next;
+      }
+      if ((b = freelist[c])) {
+          freelist[c] = b->next;
+          return b;
+      }
+
+      // otherwise carve a new chunk into blocks of this class
+      void* chunk;
+      if (posix_memalign(&chunk, CHUNK_BYTES, CHUNK_BYTES))
+          return malloc(class_size(c));
+      if (!register_chunk(chunk)) {
+          free(chunk);
+          return malloc(class_size(c));
+      }
+      slab_chunk_t* header = (slab_chunk_t*)chunk;
+      header->owner  = owner;
+      header->sclass = c;
+      size_t size = class_size(c);
+      char*  first = (char*)chunk + CACHELINE_BYTES;
+      char*  end   = (char*)chunk + CHUNK_BYTES;
+      // hand out the first block, and put the rest on the freelist
+      for (char* p = end - size - (end - first) % size; p > first; p -= size) {
+          ((slab_block_t*)p)->next = freelist[c];
+          freelist[c] = (slab_block_t*)p;
+      }
+      return first;
+  }
+
+  void SlabAllocator::flush(uint32_t to)
+  {
+      slab_block_t* head = pending[to];
+      slab_block_t* tail = head;
+      while (tail->next)
+          tail = tail->next;
+      while (true) {
+          uintptr_t old = inbox[to].val;
+          tail->next = (slab_block_t*)old;
+          if (bcasptr(&inbox[to].val, old, (uintptr_t)head))
+              break;
+      }
+      pending[to] = NULL;
+      pending_count[to] = 0;
+  }
+
+  void SlabAllocator::release(void* ptr)
+  {
+      if (!ptr)
+          return;
+      slab_chunk_t* chunk = find_chunk(ptr);
+      if (!chunk) {
+          free(ptr);
+          return;
+      }
+      slab_block_t* b = (slab_block_t*)ptr;
+      uint32_t to = chunk->owner;
+      if (to == owner) {
+          b->next = freelist[chunk->sclass];
+          freelist[chunk->sclass] = b;
+          return;
+      }
+      b->next = pending[to];
+      pending[to] = b;
+      if (++pending_count[to] == BATCH)
+          flush(to);
+  }
+
+  void SlabAllocator::flush_all()
+  {
+      for (uint32_t i = 0; i < OWNERS; ++i)
+          if (pending[i])
+              flush(i);
+  }
+} // namespace stm
+
+#endif // STM_SLAB_ALLOCATOR_YES
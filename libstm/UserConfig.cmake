@@ -89,6 +89,28 @@ libstm_enum(
   "The instrumentation points that attempt to adapt automatically"
   all;none;begin-abort)
 
+## Overhead: build for one algorithm.  The library API then calls that
+##           algorithm's read and write barriers directly, so that they can
+##           be inlined, instead of through the per-thread function pointers.
+##           The library still contains every algorithm, and switches to
+##           others (for irrevocability, or with STM_CONFIG) still work
+##           through the function pointers, but STM_CONFIG defaults to the
+##           chosen algorithm.
+libstm_enum(
+  libstm_single_algorithm none
+  "The algorithm whose barriers the library API inlines"
+  none;CGL;TML;NOrec)
+
+## Overhead: on x86_64 Linux, the library API checkpoints a transaction by
+##           saving the callee-saved registers with a few instructions of
+##           assembly, instead of with setjmp, and aborts by restoring them
+##           instead of with longjmp.  OFF uses setjmp/longjmp everywhere.
+cmake_dependent_option(
+  libstm_use_asm_checkpoint
+  "ON uses a register checkpoint instead of setjmp in the library API" ON
+  "CMAKE_SYSTEM_PROCESSOR MATCHES x86_64 AND CMAKE_SYSTEM_NAME MATCHES Linux" OFF)
+mark_as_advanced(libstm_use_asm_checkpoint)
+
 ## Experimental: when implementing a new algorithm or CM policy, it is useful
 ##               to have an abort histogram that shows how many 'toxic'
 ##               transactions occur
@@ -97,6 +119,72 @@ option(
   "ON enables a histogram of consecutive aborts" OFF)
 #mark_as_advanced(libstm_enable_abort_histogram)
 
+## Overhead: keep a log-linear histogram of transaction latency (first begin
+##           to final commit, including retries) and of attempts per commit,
+##           in every thread.  This costs a few instructions per commit.
+option(
+  libstm_enable_latency_histogram
+  "ON records per-thread latency and attempts histograms" ON)
+
+## Experimental: keep a per-thread ring of timestamped events (begin,
+##               commit, abort, irrevocability, switches, blocking), and
+##               write it to STM_TRACE_FILE at shutdown or on SIGUSR2.  The
+##               stmtrace tool analyzes the result.
+option(
+  libstm_enable_event_trace
+  "ON records a per-thread binary event trace" OFF)
+
+## Experimental: record the location (orec, lock, or address) and owning
+##               thread behind each abort, so that conflicts can be
+##               attributed to data structures and to threads
+option(
+  libstm_enable_conflict_attribution
+  "ON records the conflicting location and thread of each abort" OFF)
+
+## Experimental: sample the orecs involved in aborts, and print the most
+##               contended stripes (with symbol names, when dladdr can find
+##               them) at shutdown.  STM_HEATPERIOD sets the sampling rate.
+option(
+  libstm_enable_conflict_heatmap
+  "ON samples orec conflicts and reports the hottest addresses at shutdown" OFF)
+
+## Experimental: serve TM_ALLOC/TM_FREE from per-thread size-class slabs
+##               instead of malloc.  Blocks allocated by aborted transactions
+##               and blocks reclaimed by the epoch scheme go back to their
+##               owner's freelist.  NB: memory from TM_ALLOC must then only be
+##               released with TM_FREE, never with free().
+option(
+  libstm_enable_slab_allocator
+  "ON backs TM_ALLOC/TM_FREE with a per-thread slab allocator" OFF)
+
+## Experimental: reclaim memory with a single global epoch (in the style of
+##               DEBRA/QSBR) instead of snapshotting every thread's counter
+##               for every 32 frees.  Retired blocks go into per-thread bags
+##               keyed by epoch number, and a thread only reads the other
+##               threads' counters while trying to advance the epoch.
+option(
+  libstm_enable_global_epoch
+  "ON uses global-epoch memory reclamation" OFF)
+
+## Experimental: hand full batches of freed blocks to a helper thread, which
+##               timestamps them and frees them off the commit path.  When
+##               more than STM_RECLAIM_LIMIT batches (of 32 blocks) are
+##               outstanding, committers reclaim for themselves again.  Not
+##               used with libstm_enable_global_epoch.
+option(
+  libstm_enable_reclaim_thread
+  "ON frees retired memory from a background thread" OFF)
+
+## Experimental: give each thread's descriptor pages of its own, bound to the
+##               NUMA node of the thread that creates it (which is the thread
+##               that uses it), whatever the process's memory policy is.  This
+##               only helps if threads are pinned before TM_THREAD_INIT, as
+##               the benchmarks do with -P or -T.  Linux only.
+cmake_dependent_option(
+  libstm_enable_numa_local
+  "ON allocates each TxThread on its own thread's NUMA node" OFF
+  "CMAKE_SYSTEM_NAME MATCHES Linux" OFF)
+
 ## Overhead: The C++ TM Draft Standard requires byte-level granularity of
 ##           instrumentation since tx/nontx accesses to adjacent bytes are
 ##           allowed.  This is forced on when building the shim, and usually
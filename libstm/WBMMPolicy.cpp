@@ -9,8 +9,72 @@
  */
 
 #include <stm/WBMMPolicy.hpp>
+#ifdef STM_RECLAIM_THREAD_YES
+#include <pthread.h>
+#include "common/platform.hpp"
+#endif
 using namespace stm;
 
+pad_word_t stm::trans_nums[MAX_THREADS] = {{0}};
+
+#ifdef STM_GLOBAL_EPOCH_YES
+
+pad_word_t stm::global_epoch = {0};
+
+void WBMMPolicy::empty_bag(epoch_bag_t* bag)
+{
+    for (epoch_bag_t* b = bag; b != NULL; ) {
+        for (uint32_t i = 0; i < b->length; ++i)
+            raw_free(b->pool[i]);
+        epoch_bag_t* older = b->older;
+        if (b != bag)
+            delete b;
+        b = older;
+    }
+    bag->length = 0;
+    bag->older = NULL;
+}
+
+void WBMMPolicy::catch_up()
+{
+    // NB: a non-empty bags[now % 3] is labeled now - 3 or older, so it is
+    //     always freed before we relabel it
+    uintptr_t now = global_epoch.val;
+    for (int i = 0; i < 3; ++i)
+        if (bags[i]->epoch + 2 <= now)
+            empty_bag(bags[i]);
+    bags[now % 3]->epoch = now;
+    epoch = now;
+    scan = 0;
+}
+
+void WBMMPolicy::handle_full_bag()
+{
+    // make room in the current bag
+    epoch_bag_t*& bag = bags[epoch % 3];
+    if (bag->length == bag->POOL_SIZE) {
+        epoch_bag_t* b = new epoch_bag_t();
+        b->epoch = bag->epoch;
+        b->older = bag;
+        bag = b;
+    }
+
+    // check threads until one is still in an older epoch.  We skip
+    // ourselves: our counter is still odd, but we are committing.
+    uint32_t count = threadcount.val;
+    while (scan < count) {
+        uintptr_t ts = trans_nums[scan].val;
+        if ((ts & 1) && ((ts >> 1) != epoch) &&
+            (&trans_nums[scan].val != my_ts))
+            return;
+        ++scan;
+    }
+    bcasptr(&global_epoch.val, epoch, epoch + 1);
+    scan = 0;
+}
+
+#else
+
 namespace
 {
   /*** figure out if one timestamp is strictly dominated by another */
@@ -22,38 +86,69 @@ namespace
               return false;
       return true;
   }
-}
 
-pad_word_t stm::trans_nums[MAX_THREADS] = {{0}};
+  /*** snapshot every thread's counter into a batch */
+  inline void stamp(limbo_t* batch)
+  {
+      batch->length = threadcount.val;
+      for (uint32_t i = 0, e = batch->length; i < e; ++i)
+          batch->ts[i] = trans_nums[i].val;
+  }
+
+#ifdef STM_RECLAIM_THREAD_YES
+  /*** full batches waiting for the helper, linked through 'older' */
+  limbo_t* volatile reclaim_queue = NULL;
+
+  /*** batches handed to the helper and not yet freed, and the bound */
+  pad_word_t reclaim_outstanding = {0};
+  uintptr_t  reclaim_limit = 4096;
+
+  pthread_once_t reclaim_once = PTHREAD_ONCE_INIT;
+#endif
+}
 
 // [mfs] the caller has an odd timestamp at the time of the call.  Does that
 //       mean it will not reclaim some things as early as it might otherwise?
 void WBMMPolicy::handle_full_prelimbo()
+{
+#ifdef STM_RECLAIM_THREAD_YES
+    if (!offload(prelimbo))
+        retire_batch(prelimbo);
+#else
+    retire_batch(prelimbo);
+#endif
+    prelimbo = new limbo_t();
+}
+
+uintptr_t WBMMPolicy::retire_batch(limbo_t* batch)
 {
     // get the current timestamp from the epoch
-    prelimbo->length = threadcount.val;
-    for (uint32_t i = 0, e = prelimbo->length; i < e; ++i)
-        prelimbo->ts[i] = trans_nums[i].val;
+    stamp(batch);
 
-    // push prelimbo onto the front of the limbo list:
-    prelimbo->older = limbo;
-    limbo = prelimbo;
+    // push the batch onto the front of the limbo list:
+    batch->older = limbo;
+    limbo = batch;
+    return reclaim_older(batch);
+}
 
-    //  check if anything after limbo->head is dominated by ts.  Exit the loop
+uintptr_t WBMMPolicy::reclaim_older(limbo_t* newest)
+{
+    //  check if anything after newest is dominated by its ts.  Exit the loop
     //  when the list is empty, or when we find something that is strictly
     //  dominated.
     //
     //  NB: the list is in sorted order by timestamp.
-    limbo_t* current = limbo->older;
-    limbo_t* prev = limbo;
+    limbo_t* current = newest->older;
+    limbo_t* prev = newest;
     while (current != NULL) {
-        if (is_strictly_older(limbo->ts, current->ts, current->length))
+        if (is_strictly_older(newest->ts, current->ts, current->length))
             break;
         prev = current;
         current = current->older;
     }
 
     // If current != NULL, it is the head of a list of reclaimables
+    uintptr_t freed = 0;
     if (current) {
         // detach /current/ from the list
         prev->older = NULL;
@@ -62,13 +157,95 @@ void WBMMPolicy::handle_full_prelimbo()
         while (current != NULL) {
             // free blocks in current's pool
             for (unsigned long i = 0; i < current->POOL_SIZE; i++)
-                free(current->pool[i]);
+                raw_free(current->pool[i]);
 
             // free the node and move on
             limbo_t* old = current;
             current = current->older;
             free(old);
+            ++freed;
         }
     }
-    prelimbo = new limbo_t();
+    return freed;
 }
+
+#ifdef STM_RECLAIM_THREAD_YES
+
+bool WBMMPolicy::offload(limbo_t* batch)
+{
+    pthread_once(&reclaim_once, start_reclaimer);
+    if (reclaim_outstanding.val >= reclaim_limit)
+        return false;
+    faiptr(&reclaim_outstanding.val);
+    while (true) {
+        limbo_t* head = reclaim_queue;
+        batch->older = head;
+        if (bcasptr(&reclaim_queue, head, batch))
+            return true;
+    }
+}
+
+void WBMMPolicy::start_reclaimer()
+{
+    if (const char* s = getenv("STM_RECLAIM_LIMIT"))
+        reclaim_limit = strtoul(s, 0, 10);
+    pthread_t helper;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&helper, &attr, reclaim_thread, NULL))
+        reclaim_limit = 0; // no helper: every committer reclaims for itself
+    pthread_attr_destroy(&attr);
+}
+
+/**
+ *  The helper keeps its own limbo list.  It timestamps batches when it
+ *  receives them rather than when they were retired, which is later, and
+ *  hence safe.  When no batches arrive, it takes a fresh snapshot now and
+ *  then, so that what it holds still gets freed.
+ */
+void* WBMMPolicy::reclaim_thread(void*)
+{
+    WBMMPolicy* self = new WBMMPolicy();
+#ifdef STM_SLAB_ALLOCATOR_YES
+    self->slab.setID(SlabAllocator::HELPER_ID);
+#endif
+    limbo_t* probe = new limbo_t();
+    while (true) {
+        limbo_t* batch = atomicswapptr(&reclaim_queue, (limbo_t*)NULL);
+        uintptr_t freed = 0;
+        if (batch) {
+            // the queue is LIFO, so reverse it to keep the limbo list sorted
+            limbo_t* fifo = NULL;
+            while (batch) {
+                limbo_t* next = batch->older;
+                batch->older = fifo;
+                fifo = batch;
+                batch = next;
+            }
+            while (fifo) {
+                limbo_t* next = fifo->older;
+                freed += self->retire_batch(fifo);
+                fifo = next;
+            }
+        }
+        else {
+            if (self->limbo) {
+                stamp(probe);
+                probe->older = self->limbo;
+                freed = self->reclaim_older(probe);
+                self->limbo = probe->older;
+            }
+            // nothing new arrived, so don't hold on to partial batches
+            self->flushRemoteFrees();
+            sleep_ms(1);
+        }
+        if (freed)
+            faaptr(&reclaim_outstanding.val, -freed);
+    }
+    return NULL;
+}
+
+#endif // STM_RECLAIM_THREAD_YES
+
+#endif // STM_GLOBAL_EPOCH_YES
@@ -77,6 +77,20 @@ namespace stm
   uint32_t   profile_txns = 1;          // number of txns per profile
   dynprof_t* profiles     = NULL;       // where to store profiles
 
+  void read_range_words(STM_READ_RANGE_SIG(tx, addr, to, n))
+  {
+      for (size_t i = 0; i < n; ++i)
+          to[i] = tx->tmread(tx, addr + i STM_MASK(~0x0));
+  }
+
+  void write_range_words(STM_WRITE_RANGE_SIG(tx, addr, from, n))
+  {
+      for (size_t i = 0; i < n; ++i)
+          tx->tmwrite(tx, addr + i, from[i] STM_MASK(~0x0));
+  }
+
+  const barrier_hints_t no_hints = { NULL, NULL, NULL, NULL, NULL };
+
   /*** Use the stms array to map a string name to an algorithm ID */
   int stm_name_map(const char* phasename)
   {
@@ -25,6 +25,7 @@
 
 #include "stm/metadata.hpp"
 #include "stm/txthread.hpp"
+#include "stm/inline_barriers.hpp" // timestamp, CGL/TML/NOrec barriers
 #include "../profiling.hpp" // Trigger::
 
 namespace stm
@@ -70,7 +71,6 @@ namespace stm
    *  These global fields are used for concurrency control and conflict
    *  detection in our STM systems
    */
-  extern pad_word_t    timestamp;
   extern orec_t        orecs[NUM_STRIPES];             // set of orecs
   extern pad_word_t    last_init;                      // last logical commit
   extern pad_word_t    last_complete;                  // last physical commit
@@ -92,6 +92,16 @@ namespace stm
   extern dynprof_t*    profiles;          // a list of ProfileTM measurements
   extern uint32_t      profile_txns;      // how many txns per profile
 
+  /**
+   *  The default range barriers: one call to tx->tmread or tx->tmwrite per
+   *  word.  Algorithms that can do better set their own in alg_t.
+   */
+  TM_FASTCALL void read_range_words(STM_READ_RANGE_SIG(,,,));
+  TM_FASTCALL void write_range_words(STM_WRITE_RANGE_SIG(,,,));
+
+  /*** hints that are all NULL, for algorithms that don't specialize them */
+  extern const barrier_hints_t no_hints;
+
   /**
    *  To describe an STM algorithm, we provide a name, a set of function
    *  pointers, and some other information
@@ -110,6 +120,16 @@ namespace stm
       void* (*TM_FASTCALL read)  (STM_READ_SIG(,,));
       void  (*TM_FASTCALL write) (STM_WRITE_SIG(,,,));
 
+      /**
+       * optional multi-word read and write barriers; these must work in
+       * every mode of the algorithm (e.g., before and after the first write)
+       */
+      void  (*TM_FASTCALL read_range) (STM_READ_RANGE_SIG(,,,));
+      void  (*TM_FASTCALL write_range)(STM_WRITE_RANGE_SIG(,,,));
+
+      /*** optional specialized barriers for the ITM access variants */
+      barrier_hints_t hints;
+
       /**
        * rolls the transaction back without unwinding, returns the scope (which
        * is set to null during rollback)
@@ -131,7 +151,10 @@ namespace stm
       bool privatization_safe;
 
       /*** simple ctor, because a NULL name is a bad thing */
-      alg_t() : name("") { }
+      alg_t()
+          : name(""), read_range(read_range_words),
+            write_range(write_range_words), hints(no_hints)
+      { }
   };
 
   /**
@@ -234,9 +257,50 @@ namespace stm
   // This is used as a default in txthread.cpp... just forwards to CGL::begin.
   TM_FASTCALL bool begin_CGL(TxThread*);
 
-  typedef TM_FASTCALL void* (*ReadBarrier)(STM_READ_SIG(,,));
-  typedef TM_FASTCALL void (*WriteBarrier)(STM_WRITE_SIG(,,,));
-  typedef TM_FASTCALL void (*CommitBarrier)(TxThread*);
+#ifdef STM_CONFLICT_HEATMAP_YES
+  /**
+   *  Sampled conflict heatmap (see heatmap.cpp).  addr is the program
+   *  address that led us to the orec, if the caller knows it.
+   */
+  extern uint32_t heat_period;
+  NOINLINE void heatmap_record(TxThread* tx, const volatile void* o,
+                               void* addr);
+#endif
+
+  /**
+   *  Abort because of an orec whose value we read as ivt.  If the orec is
+   *  locked, its id field names the owner.  If the caller knows which
+   *  address mapped to the orec, passing it lets the heatmap name it.
+   */
+  NORETURN
+  inline void tx_abort_orec(TxThread* tx, abort_cause_t cause,
+                            const volatile void* o, uintptr_t ivt,
+                            void* addr = NULL)
+  {
+#ifdef STM_CONFLICT_HEATMAP_YES
+      if (--tx->heat_countdown == 0)
+          heatmap_record(tx, o, addr);
+#else
+      (void)addr;
+#endif
+      id_version_t v;
+      v.all = ivt;
+      tx_abort(tx, cause, o, v.fields.lock ? (uint32_t)v.fields.id : 0);
+  }
+
+  /**
+   *  Abort because an orec we want is either locked by someone else, or
+   *  has a timestamp newer than our start time
+   */
+  NORETURN
+  inline void tx_abort_orec(TxThread* tx, const volatile void* o,
+                            uintptr_t ivt, void* addr = NULL)
+  {
+      id_version_t v;
+      v.all = ivt;
+      tx_abort_orec(tx, v.fields.lock ? ABORT_LOCKED : ABORT_TOO_NEW, o, ivt,
+                    addr);
+  }
 
   inline void OnReadWriteCommit(TxThread* tx, ReadBarrier read_ro,
                                 WriteBarrier write_ro, CommitBarrier commit_ro)
@@ -244,11 +308,12 @@ namespace stm
       tx->allocator.onTxCommit();
       tx->abort_hist.onCommit(tx->consec_aborts);
       tx->consec_aborts = 0;
-      ++tx->num_commits;
+      ++tx->stats.commits;
       tx->tmread = read_ro;
       tx->tmwrite = write_ro;
       tx->tmcommit = commit_ro;
       Trigger::onCommitSTM(tx);
+      Sampler::onCommit(tx);
   }
 
   inline void OnReadWriteCommit(TxThread* tx)
@@ -256,8 +321,9 @@ namespace stm
       tx->allocator.onTxCommit();
       tx->abort_hist.onCommit(tx->consec_aborts);
       tx->consec_aborts = 0;
-      ++tx->num_commits;
+      ++tx->stats.commits;
       Trigger::onCommitSTM(tx);
+      Sampler::onCommit(tx);
   }
 
   inline void OnReadOnlyCommit(TxThread* tx)
@@ -265,22 +331,25 @@ namespace stm
       tx->allocator.onTxCommit();
       tx->abort_hist.onCommit(tx->consec_aborts);
       tx->consec_aborts = 0;
-      ++tx->num_ro;
+      ++tx->stats.ro_commits;
       Trigger::onCommitSTM(tx);
+      Sampler::onCommit(tx);
   }
 
   inline void OnCGLCommit(TxThread* tx)
   {
       tx->allocator.onTxCommit();
-      ++tx->num_commits;
+      ++tx->stats.commits;
       Trigger::onCommitLock(tx);
+      Sampler::onCommit(tx);
   }
 
   inline void OnReadOnlyCGLCommit(TxThread* tx)
   {
       tx->allocator.onTxCommit();
-      ++tx->num_ro;
+      ++tx->stats.ro_commits;
       Trigger::onCommitLock(tx);
+      Sampler::onCommit(tx);
   }
 
   inline void OnFirstWrite(TxThread* tx, ReadBarrier read_rw,
@@ -293,7 +362,22 @@ namespace stm
 
   inline void PreRollback(TxThread* tx)
   {
-      ++tx->num_aborts;
+      ++tx->stats.aborts[tx->abort_cause];
+#ifdef STM_CONFLICT_ATTRIBUTION_YES
+      STM_TRACE(tx, EV_ABORT, tx->abort_cause, tx->conflict_owner);
+      uint32_t owner = tx->conflict_owner;
+      ++tx->stats.conflicts_with[(owner <= MAX_THREADS) ? owner : 0];
+      if (tx->conflict_addr) {
+          uint32_t slot = tx->stats.recent_next++ % tx_stats_t::CONFLICT_LOG;
+          tx->stats.recent[slot] = tx->conflict_addr;
+          tx->stats.recent_cause[slot] = tx->abort_cause;
+      }
+      tx->conflict_addr = NULL;
+      tx->conflict_owner = 0;
+#else
+      STM_TRACE(tx, EV_ABORT, tx->abort_cause, 0);
+#endif
+      tx->abort_cause = ABORT_CONFLICT;
       ++tx->consec_aborts;
   }
 
@@ -306,6 +390,7 @@ namespace stm
       tx->tmwrite = write_ro;
       tx->tmcommit = commit_ro;
       Trigger::onAbort(tx);
+      Sampler::onAbort(tx);
       scope_t* scope = tx->scope;
       tx->scope = NULL;
       return scope;
@@ -316,6 +401,7 @@ namespace stm
       tx->allocator.onTxAbort();
       tx->nesting_depth = 0;
       Trigger::onAbort(tx);
+      Sampler::onAbort(tx);
       scope_t* scope = tx->scope;
       tx->scope = NULL;
       return scope;
@@ -26,6 +26,9 @@ using stm::bitlock_t;
 using stm::get_bitlock;
 using stm::rrec_t;
 using stm::UndoLogEntry;
+using stm::tx_abort;
+using stm::ABORT_CONFLICT;
+using stm::ABORT_LOCKED;
 
 
 /**
@@ -136,7 +139,7 @@ namespace {
           lock->readers.unsetbit(tx->id-1);
           while (lock->owner != 0)
               if (++tries > READ_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
       }
   }
 
@@ -176,7 +179,7 @@ namespace {
           lock->readers.unsetbit(tx->id-1);
           while (lock->owner != 0)
               if (++tries > READ_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
       }
   }
 
@@ -195,7 +198,7 @@ namespace {
       // get the write lock, with timeout
       while (!bcasptr(&(lock->owner), 0u, tx->id))
           if (++tries > ACQUIRE_TIMEOUT)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
 
       // log the lock, drop any read locks I have
       tx->w_bitlocks.insert(lock);
@@ -207,7 +210,7 @@ namespace {
           tries = 0;
           while (lock->readers.bits[b])
               if (++tries > DRAIN_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock);
       }
 
       // add to undo log, do in-place write
@@ -238,7 +241,7 @@ namespace {
       // get the write lock, with timeout
       while (!bcasptr(&(lock->owner), 0u, tx->id))
           if (++tries > ACQUIRE_TIMEOUT)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
 
       // log the lock, drop any read locks I have
       tx->w_bitlocks.insert(lock);
@@ -253,7 +256,7 @@ namespace {
           tries = 0;
           while (lock->readers.bits[b])
               if (++tries > DRAIN_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock);
       }
 
       // add to undo log, do in-place write
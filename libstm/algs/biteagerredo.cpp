@@ -17,7 +17,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -26,6 +26,9 @@ using stm::bitlock_t;
 using stm::get_bitlock;
 using stm::WriteSetEntry;
 using stm::rrec_t;
+using stm::tx_abort;
+using stm::ABORT_CONFLICT;
+using stm::ABORT_LOCKED;
 
 
 /**
@@ -139,7 +142,7 @@ namespace {
           lock->readers.unsetbit(tx->id-1);
           while (lock->owner != 0) {
               if (++tries > READ_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
           }
       }
   }
@@ -187,7 +190,7 @@ namespace {
           lock->readers.unsetbit(tx->id-1);
           while (lock->owner != 0) {
               if (++tries > READ_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
           }
       }
   }
@@ -206,7 +209,7 @@ namespace {
       // get the write lock, with timeout
       while (!bcasptr(&(lock->owner), 0u, tx->id))
           if (++tries > ACQUIRE_TIMEOUT)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
 
       // log the lock, drop any read locks I have
       tx->w_bitlocks.insert(lock);
@@ -218,7 +221,7 @@ namespace {
           tries = 0;
           while (lock->readers.bits[b])
               if (++tries > DRAIN_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock);
       }
 
       // record in redo log
@@ -247,7 +250,7 @@ namespace {
       // get the write lock, with timeout
       while (!bcasptr(&(lock->owner), 0u, tx->id))
           if (++tries > ACQUIRE_TIMEOUT)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
 
       // log the lock, drop any read locks I have
       tx->w_bitlocks.insert(lock);
@@ -259,7 +262,7 @@ namespace {
           tries = 0;
           while (lock->readers.bits[b])
               if (++tries > DRAIN_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock);
       }
 
       // record in redo log
@@ -30,7 +30,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::BitLockList;
@@ -41,6 +41,9 @@ using stm::bitlock_t;
 using stm::get_bitlock;
 using stm::threads;
 using stm::WriteSetEntry;
+using stm::tx_abort;
+using stm::ABORT_KILLED;
+using stm::ABORT_LOCKED;
 
 
 /**
@@ -82,7 +85,7 @@ namespace {
   {
       // were there remote aborts?
       if (!tx->alive)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       CFENCE;
 
       // release read locks
@@ -114,14 +117,14 @@ namespace {
           // abort if cannot acquire and haven't locked yet
           if (bl->owner == 0) {
               if (!bcasptr(&bl->owner, (uintptr_t)0, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, bl);
               // log lock
               tx->w_bitlocks.insert(bl);
               // get readers
               accumulator |= bl->readers;
           }
           else if (bl->owner != tx->my_lock.all) {
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, bl);
           }
       }
 
@@ -149,7 +152,7 @@ namespace {
       // were there remote aborts?
       CFENCE;
       if (!tx->alive)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       CFENCE;
 
       // we committed... replay redo log
@@ -184,12 +187,12 @@ namespace {
           tx->r_bitlocks.insert(bl);
       // if there's a writer, it can't be me since I'm in-flight
       if (bl->owner)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, bl);
       // order the read before checking for remote aborts
       void* val = *addr;
       CFENCE;
       if (!tx->alive)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       return val;
   }
 
@@ -217,12 +220,12 @@ namespace {
           REDO_RAW_CHECK(found, log, mask);
       }
       if (bl->owner)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, bl);
       void* val = *addr;
       REDO_RAW_CLEANUP(val, found, log, mask);
       CFENCE;
       if (!tx->alive)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       return val;
   }
 
@@ -242,7 +245,7 @@ namespace {
       if (bl->readers.setif(tx->id-1))
           tx->r_bitlocks.insert(bl);
       if (bl->owner)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, bl);
       OnFirstWrite(tx, read_rw, write_rw, commit_rw);
   }
 
@@ -260,7 +263,7 @@ namespace {
       if (bl->readers.setif(tx->id-1))
           tx->r_bitlocks.insert(bl);
       if (bl->owner)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, bl);
   }
 
   /**
@@ -17,7 +17,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -26,6 +26,10 @@ using stm::bytelock_t;
 using stm::get_bytelock;
 using stm::WriteSetEntry;
 using stm::threads;
+using stm::tx_abort;
+using stm::ABORT_CONFLICT;
+using stm::ABORT_KILLED;
+using stm::ABORT_LOCKED;
 
 
 /**
@@ -89,7 +93,7 @@ namespace {
   {
       // atomically mark self committed
       if (!bcas32(&tx->alive, TX_ACTIVE, TX_COMMITTED))
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
 
       // we committed... replay redo log
       tx->writes.writeback();
@@ -128,11 +132,11 @@ namespace {
           switch (threads[owner-1]->alive) {
             case TX_COMMITTED:
               // abort myself if the owner is writing back
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, owner);
             case TX_ACTIVE:
               // abort the owner(it's active)
               if (!bcas32(&threads[owner-1]->alive, TX_ACTIVE, TX_ABORTED))
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock, owner);
               break;
             case TX_ABORTED:
               // if the owner is unwinding, go through and read
@@ -147,7 +151,7 @@ namespace {
 
       // check for remote abort
       if (tx->alive == TX_ABORTED)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       return result;
   }
 
@@ -184,11 +188,11 @@ namespace {
           switch (threads[owner-1]->alive) {
             case TX_COMMITTED:
               // abort myself if the owner is writing back
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, owner);
             case TX_ACTIVE:
               // abort the owner(it's active)
               if (!bcas32(&threads[owner-1]->alive, TX_ACTIVE, TX_ABORTED))
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock, owner);
               break;
             case TX_ABORTED:
               // if the owner is unwinding, go through and read
@@ -203,7 +207,7 @@ namespace {
 
       // check for remote abort
       if (tx->alive == TX_ABORTED)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
 
       return result;
   }
@@ -226,7 +230,7 @@ namespace {
               break;
           // liveness check
           if (tx->alive == TX_ABORTED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
       }
 
       // log the lock, drop any read locks I have
@@ -242,7 +246,7 @@ namespace {
       for (int i = 0; i < 60; ++i)
           if (lock->reader[i] != 0 && threads[i]->alive == TX_ACTIVE)
               if (!bcas32(&threads[i]->alive, TX_ACTIVE, TX_ABORTED))
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock, i + 1);
 
       // add to redo log
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
@@ -274,7 +278,7 @@ namespace {
               break;
           // liveness check
           if (tx->alive == TX_ABORTED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
       }
 
       // log the lock, drop any read locks I have
@@ -285,7 +289,7 @@ namespace {
       for (int i = 0; i < 60; ++i)
           if (lock->reader[i] != 0 && threads[i]->alive == TX_ACTIVE)
               if (!bcas32(&threads[i]->alive, TX_ACTIVE, TX_ABORTED))
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock, i + 1);
 
       // add to redo log
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
@@ -39,6 +39,10 @@ using stm::bytelock_t;
 using stm::get_bytelock;
 using stm::threads;
 using stm::UndoLogEntry;
+using stm::tx_abort;
+using stm::ABORT_CONFLICT;
+using stm::ABORT_KILLED;
+using stm::ABORT_LOCKED;
 
 
 /**
@@ -176,11 +180,11 @@ namespace {
           if (CM::mayKill(tx, owner - 1))
               threads[owner-1]->alive = TX_ABORTED;
           else
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, owner);
           // NB: must have liveness check in the spin, since we may have read
           //     locks
           if (tx->alive == TX_ABORTED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
       }
 
       // do the read
@@ -190,7 +194,7 @@ namespace {
 
       // check for remote abort
       if (tx->alive == TX_ABORTED)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       return result;
   }
 
@@ -218,10 +222,10 @@ namespace {
               if (CM::mayKill(tx, owner - 1))
                   threads[owner-1]->alive = TX_ABORTED;
               else
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, owner);
               // NB: again, need liveness check
               if (tx->alive == TX_ABORTED)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_KILLED);
           }
       }
 
@@ -232,7 +236,7 @@ namespace {
 
       // check for remote abort
       if (tx->alive == TX_ABORTED)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       return result;
   }
 
@@ -253,13 +257,13 @@ namespace {
               if (CM::mayKill(tx, owner - 1))
                   threads[owner-1]->alive = TX_ABORTED;
               else
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, owner);
           // try to get ownership
           else if (bcas32(&(lock->owner), 0u, tx->id))
               break;
           // liveness check
           if (tx->alive == TX_ABORTED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
       }
 
       // log the lock, drop any read locks I have
@@ -273,7 +277,7 @@ namespace {
               if (CM::mayKill(tx, i))
                   threads[i]->alive = TX_ABORTED;
               else
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock, i + 1);
           }
 
       // add to undo log, do in-place write
@@ -282,7 +286,7 @@ namespace {
 
       // check for remote abort
       if (tx->alive == TX_ABORTED)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
 
       OnFirstWrite(tx, read_rw, write_rw, commit_rw);
   }
@@ -306,13 +310,13 @@ namespace {
                   if (CM::mayKill(tx, owner-1))
                       threads[owner-1]->alive = TX_ABORTED;
                   else
-                      tx->tmabort(tx);
+                      tx_abort(tx, ABORT_LOCKED, lock, owner);
               // try to get ownership
               else if (bcas32(&(lock->owner), 0u, tx->id))
                   break;
               // liveness check
               if (tx->alive == TX_ABORTED)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_KILLED);
           }
           // log the lock, drop any read locks I have
           tx->w_bytelocks.insert(lock);
@@ -325,7 +329,7 @@ namespace {
                   if (CM::mayKill(tx, i))
                       threads[i]->alive = TX_ABORTED;
                   else
-                      tx->tmabort(tx);
+                      tx_abort(tx, ABORT_CONFLICT, lock, i + 1);
               }
       }
 
@@ -335,7 +339,7 @@ namespace {
 
       // check for remote abort
       if (tx->alive == TX_ABORTED)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
   }
 
   /**
@@ -25,6 +25,9 @@ using stm::ByteLockList;
 using stm::bytelock_t;
 using stm::get_bytelock;
 using stm::UndoLogEntry;
+using stm::tx_abort;
+using stm::ABORT_CONFLICT;
+using stm::ABORT_LOCKED;
 
 
 /**
@@ -132,7 +135,7 @@ namespace {
           lock->reader[tx->id-1] = 0;
           while (lock->owner != 0) {
               if (++tries > READ_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
           }
       }
   }
@@ -169,7 +172,7 @@ namespace {
           lock->reader[tx->id-1] = 0;
           while (lock->owner != 0)
               if (++tries > READ_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
       }
   }
 
@@ -185,7 +188,7 @@ namespace {
       // get the write lock, with timeout
       while (!bcas32(&(lock->owner), 0u, tx->id))
           if (++tries > ACQUIRE_TIMEOUT)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
 
       // log the lock, drop any read locks I have
       tx->w_bytelocks.insert(lock);
@@ -198,7 +201,7 @@ namespace {
           tries = 0;
           while (lock_alias[i] != 0)
               if (++tries > DRAIN_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock);
       }
 
       // add to undo log, do in-place write
@@ -227,7 +230,7 @@ namespace {
       // get the write lock, with timeout
       while (!bcas32(&(lock->owner), 0u, tx->id))
           if (++tries > ACQUIRE_TIMEOUT)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
 
       // log the lock, drop any read locks I have
       tx->w_bytelocks.insert(lock);
@@ -240,7 +243,7 @@ namespace {
           tries = 0;
           while (lock_alias[i] != 0)
               if (++tries > DRAIN_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock);
       }
 
       // add to undo log, do in-place write
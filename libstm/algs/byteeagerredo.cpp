@@ -17,7 +17,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -25,6 +25,9 @@ using stm::ByteLockList;
 using stm::bytelock_t;
 using stm::get_bytelock;
 using stm::WriteSetEntry;
+using stm::tx_abort;
+using stm::ABORT_CONFLICT;
+using stm::ABORT_LOCKED;
 
 
 /**
@@ -135,7 +138,7 @@ namespace {
           lock->reader[tx->id-1] = 0;
           while (lock->owner != 0) {
               if (++tries > READ_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
           }
       }
   }
@@ -180,7 +183,7 @@ namespace {
           lock->reader[tx->id-1] = 0;
           while (lock->owner != 0) {
               if (++tries > READ_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
           }
       }
   }
@@ -197,7 +200,7 @@ namespace {
       // get the write lock, with timeout
       while (!bcas32(&(lock->owner), 0u, tx->id))
           if (++tries > ACQUIRE_TIMEOUT)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
 
       // log the lock, drop any read locks I have
       tx->w_bytelocks.insert(lock);
@@ -210,7 +213,7 @@ namespace {
           tries = 0;
           while (lock_alias[i] != 0)
               if (++tries > DRAIN_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock);
       }
 
       // record in redo log
@@ -237,7 +240,7 @@ namespace {
       // get the write lock, with timeout
       while (!bcas32(&(lock->owner), 0u, tx->id))
           if (++tries > ACQUIRE_TIMEOUT)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, lock, lock->owner);
 
       // log the lock, drop any read locks I have
       tx->w_bytelocks.insert(lock);
@@ -250,7 +253,7 @@ namespace {
           tries = 0;
           while (lock_alias[i] != 0)
               if (++tries > DRAIN_TIMEOUT)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_CONFLICT, lock);
       }
 
       // record in redo log
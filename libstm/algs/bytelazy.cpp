@@ -17,7 +17,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -27,6 +27,9 @@ using stm::bytelock_t;
 using stm::get_bytelock;
 using stm::WriteSetEntry;
 using stm::threads;
+using stm::tx_abort;
+using stm::ABORT_KILLED;
+using stm::ABORT_LOCKED;
 
 
 /**
@@ -69,7 +72,7 @@ namespace {
   {
       // were there remote aborts?
       if (!tx->alive)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       CFENCE;
 
       // release read locks
@@ -103,7 +106,7 @@ namespace {
           // abort if cannot acquire and haven't locked yet
           if (bl->owner == 0) {
               if (!bcas32(&bl->owner, (uintptr_t)0, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_LOCKED, bl);
 
               // log lock
               tx->w_bytelocks.insert(bl);
@@ -116,7 +119,7 @@ namespace {
                   p1[j] |= p2[j];
           }
           else if (bl->owner != tx->my_lock.all) {
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_LOCKED, bl);
           }
       }
 
@@ -131,7 +134,7 @@ namespace {
       // were there remote aborts?
       CFENCE;
       if (!tx->alive)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       CFENCE;
 
       // we committed... replay redo log
@@ -169,14 +172,14 @@ namespace {
 
       // if there's a writer, it can't be me since I'm in-flight
       if (bl->owner != 0)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, bl);
 
       // order the read before checking for remote aborts
       void* val = *addr;
       CFENCE;
 
       if (!tx->alive)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
 
       return val;
   }
@@ -210,7 +213,7 @@ namespace {
 
       // if there's a writer, it can't be me since I'm in-flight
       if (bl->owner != 0)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, bl);
 
       // order the read before checking for remote aborts
       void* val = *addr;
@@ -218,7 +221,7 @@ namespace {
       CFENCE;
 
       if (!tx->alive)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
 
       return val;
   }
@@ -244,7 +247,7 @@ namespace {
       }
 
       if (bl->owner)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, bl);
 
       OnFirstWrite(tx, read_rw, write_rw, commit_rw);
   }
@@ -267,7 +270,7 @@ namespace {
       }
 
       if (bl->owner)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, bl);
   }
 
   /**
@@ -20,12 +20,12 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include <stm/UndoLog.hpp> // STM_DO_MASKED_WRITE
 
 using stm::TxThread;
 using stm::timestamp;
 using stm::timestamp_max;
 using stm::UNRECOVERABLE;
+using stm::CGLBarriers;
 
 
 /**
@@ -36,9 +36,7 @@ namespace
 {
   struct CGL
   {
-      // begin_CGL is external
-      static TM_FASTCALL void* read(STM_READ_SIG(,,));
-      static TM_FASTCALL void write(STM_WRITE_SIG(,,,));
+      // begin_CGL is external, and read/write are in stm/inline_barriers.hpp
       static TM_FASTCALL void commit(TxThread*);
 
       static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
@@ -57,24 +55,6 @@ namespace
       OnCGLCommit(tx);
   }
 
-  /**
-   *  CGL read
-   */
-  void*
-  CGL::read(STM_READ_SIG(,addr,))
-  {
-      return *addr;
-  }
-
-  /**
-   *  CGL write
-   */
-  void
-  CGL::write(STM_WRITE_SIG(,addr,val,mask))
-  {
-      STM_DO_MASKED_WRITE(addr, val, mask);
-  }
-
   /**
    *  CGL unwinder:
    *
@@ -151,8 +131,8 @@ namespace stm {
       //     CGL::begin.  In the long term, hopefully we can do better.
       stms[CGL].begin     = begin_CGL;
       stms[CGL].commit    = ::CGL::commit;
-      stms[CGL].read      = ::CGL::read;
-      stms[CGL].write     = ::CGL::write;
+      stms[CGL].read      = CGLBarriers::read;
+      stms[CGL].write     = CGLBarriers::write;
       stms[CGL].rollback  = ::CGL::rollback;
       stms[CGL].irrevoc   = ::CGL::irrevoc;
       stms[CGL].switcher  = ::CGL::onSwitchTo;
@@ -20,7 +20,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::threads;
@@ -34,6 +34,10 @@ using stm::UNRECOVERABLE;
 using stm::WriteSetEntry;
 using stm::orec_t;
 using stm::get_orec;
+using stm::tx_abort;
+using stm::ABORT_SWITCH;
+using stm::ABORT_TOO_NEW;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -91,7 +95,7 @@ namespace {
       // writeback
       while (last_complete.val != (uintptr_t)(tx->order - 1)) {
           if (TxThread::tmbegin != begin)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_SWITCH);
       }
 
       // since we have the token, we can validate before getting locks
@@ -144,7 +148,7 @@ namespace {
       // NB: this is a pretty serious tradeoff... it admits false aborts for
       //     the sake of preventing a 'check if locked' test
       if (ivt > tx->ts_cache)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_TOO_NEW, o);
 
       // log orec
       tx->r_orecs.insert(o);
@@ -241,7 +245,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if it has a timestamp of ts_cache or greater, abort
           if (ivt > tx->ts_cache)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION, *i);
       }
       // now update the finish_cache to remember that at this time, we were
       // still valid
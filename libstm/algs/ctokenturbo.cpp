@@ -18,7 +18,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 #include <stm/UndoLog.hpp> // STM_DO_MASKED_WRITE
 
 using stm::TxThread;
@@ -33,6 +33,10 @@ using stm::UNRECOVERABLE;
 using stm::orec_t;
 using stm::get_orec;
 using stm::WriteSetEntry;
+using stm::tx_abort;
+using stm::ABORT_SWITCH;
+using stm::ABORT_TOO_NEW;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -100,7 +104,7 @@ namespace {
       // we need to transition to fast here, but not till our turn
       while (last_complete.val != ((uintptr_t)tx->order - 1)) {
           if (TxThread::tmbegin != begin)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_SWITCH);
       }
       // validate
       foreach (OrecList, i, tx->r_orecs) {
@@ -108,7 +112,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if it has a timestamp of ts_cache or greater, abort
           if (ivt > tx->ts_cache)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION, *i);
       }
       // writeback
       if (tx->writes.size() != 0) {
@@ -165,7 +169,7 @@ namespace {
       uintptr_t ivt = o->v.all;
       // abort if this changed since the last time I saw someone finish
       if (ivt > tx->ts_cache)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_TOO_NEW, o);
 
       // log orec
       tx->r_orecs.insert(o);
@@ -178,7 +182,7 @@ namespace {
               uintptr_t ivt_inner = (*i)->v.all;
               // if it has a timestamp of ts_cache or greater, abort
               if (ivt_inner > tx->ts_cache)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_VALIDATION, *i);
           }
           // now update the ts_cache to remember that at this time, we were
           // still valid
@@ -207,7 +211,7 @@ namespace {
       uintptr_t ivt = o->v.all;
       // abort if this changed since the last time I saw someone finish
       if (ivt > tx->ts_cache)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_TOO_NEW, o);
 
       // log orec
       tx->r_orecs.insert(o);
@@ -319,7 +323,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if it has a timestamp of ts_cache or greater, abort
           if (ivt > tx->ts_cache)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION, *i);
       }
       // now update the finish_cache to remember that at this time, we were
       // still valid
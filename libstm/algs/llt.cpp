@@ -21,7 +21,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::timestamp;
@@ -32,6 +32,9 @@ using stm::UNRECOVERABLE;
 using stm::WriteSetEntry;
 using stm::orec_t;
 using stm::get_orec;
+using stm::tx_abort_orec;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -97,14 +100,14 @@ namespace {
           if (ivt <= tx->start_time) {
               // abort if cannot acquire
               if (!bcasptr(&o->v.all, ivt, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all, i->addr);
               // save old version to o->p, remember that we hold the lock
               o->p = ivt;
               tx->locks.insert(o);
           }
           // else if we don't hold the lock abort
           else if (ivt != tx->my_lock.all) {
-              tx->tmabort(tx);
+              tx_abort_orec(tx, o, ivt, i->addr);
           }
       }
 
@@ -154,7 +157,7 @@ namespace {
           return tmp;
       }
       // unreachable
-      tx->tmabort(tx);
+      tx_abort_orec(tx, o, ivt, addr);
       return NULL;
   }
 
@@ -187,7 +190,7 @@ namespace {
           tx->r_orecs.insert(o);
           return tmp;
       }
-      tx->tmabort(tx);
+      tx_abort_orec(tx, o, ivt, addr);
       // unreachable
       return NULL;
   }
@@ -257,7 +260,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if unlocked and newer than start time, abort
           if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
       }
   }
 
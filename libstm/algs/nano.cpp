@@ -23,7 +23,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -35,6 +35,9 @@ using stm::NanorecList;
 using stm::nanorec_t;
 using stm::get_nanorec;
 using stm::id_version_t;
+using stm::tx_abort_orec;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -98,13 +101,13 @@ namespace {
           if (ivt.all != tx->my_lock.all) {
               if (!ivt.fields.lock) {
                   if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all))
-                      tx->tmabort(tx);
+                      tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all);
                   // save old version to o->p, remember that we hold the lock
                   o->p = ivt.all;
                   tx->locks.insert(o);
               }
               else {
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
               }
           }
       }
@@ -115,7 +118,7 @@ namespace {
           // if orec does not match val, then it must be locked by me, with its
           // old val equalling my expected val
           if ((ivt != i->v) && ((ivt != tx->my_lock.all) || (i->v != i->o->p)))
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, i->o, ivt);
       }
 
       // run the redo log
@@ -161,7 +164,7 @@ namespace {
               // validate the whole read set, then return the value we just read
               foreach (NanorecList, i, tx->nanorecs)
                   if (i->o->v.all != i->v)
-                      tx->tmabort(tx);
+                      tx_abort_orec(tx, ABORT_VALIDATION, i->o, i->o->v.all);
               return tmp;
           }
 
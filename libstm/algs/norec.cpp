@@ -19,7 +19,6 @@
 
 #include "../cm.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
 
 // Don't just import everything from stm. This helps us find bugs.
 using stm::TxThread;
@@ -27,12 +26,14 @@ using stm::timestamp;
 using stm::WriteSetEntry;
 using stm::ValueList;
 using stm::ValueListEntry;
+using stm::tx_abort;
+using stm::ABORT_VALIDATION;
+using stm::NOrecBarriers;
 
 
 namespace {
 
-  const uintptr_t VALIDATION_FAILED = 1;
-  NOINLINE uintptr_t validate(TxThread*);
+  const uintptr_t VALIDATION_FAILED = NOrecBarriers::VALIDATION_FAILED;
   bool irrevoc(TxThread*);
   void onSwitchTo();
 
@@ -43,46 +44,20 @@ namespace {
       static TM_FASTCALL void commit(TxThread*);
       static TM_FASTCALL void commit_ro(TxThread*);
       static TM_FASTCALL void commit_rw(TxThread*);
-      static TM_FASTCALL void* read_ro(STM_READ_SIG(,,));
-      static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
       static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
-      static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void read_range(STM_READ_RANGE_SIG(,,,));
+      static TM_FASTCALL void write_range(STM_WRITE_RANGE_SIG(,,,));
+      static TM_FASTCALL void* read_after_read(STM_READ_SIG(,,));
       static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
       static void initialize(int id, const char* name);
   };
 
-  uintptr_t
-  validate(TxThread* tx)
-  {
-      while (true) {
-          // read the lock until it is even
-          uintptr_t s = timestamp.val;
-          if ((s & 1) == 1)
-              continue;
-
-          // check the read set
-          CFENCE;
-          // don't branch in the loop---consider it backoff if we fail
-          // validation early
-          bool valid = true;
-          foreach (ValueList, i, tx->vlist)
-              valid &= STM_LOG_VALUE_IS_VALID(i, tx);
-
-          if (!valid)
-              return VALIDATION_FAILED;
-
-          // restart if timestamp changed during read set iteration
-          CFENCE;
-          if (timestamp.val == s)
-              return s;
-      }
-  }
-
   bool
   irrevoc(TxThread* tx)
   {
       while (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
-          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
+          if ((tx->start_time = NOrecBarriers::validate(tx)) ==
+              VALIDATION_FAILED)
               return false;
 
       // redo writes
@@ -116,8 +91,12 @@ namespace {
       // set the pointers
       stm::stms[id].begin     = NOrec_Generic<CM>::begin;
       stm::stms[id].commit    = NOrec_Generic<CM>::commit_ro;
-      stm::stms[id].read      = NOrec_Generic<CM>::read_ro;
+      stm::stms[id].read      = NOrecBarriers::read_ro;
       stm::stms[id].write     = NOrec_Generic<CM>::write_ro;
+      stm::stms[id].read_range  = NOrec_Generic<CM>::read_range;
+      stm::stms[id].write_range = NOrec_Generic<CM>::write_range;
+      stm::stms[id].hints.read_after_read  = NOrec_Generic<CM>::read_after_read;
+      stm::stms[id].hints.read_after_write = NOrecBarriers::read_rw;
       stm::stms[id].irrevoc   = irrevoc;
       stm::stms[id].switcher  = onSwitchTo;
       stm::stms[id].privatization_safe = true;
@@ -161,8 +140,9 @@ namespace {
 
       // get the lock and validate (use RingSTM obstruction-free technique)
       while (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
-          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
-              tx->tmabort(tx);
+          if ((tx->start_time = NOrecBarriers::validate(tx)) ==
+              VALIDATION_FAILED)
+              tx_abort(tx, ABORT_VALIDATION);
 
       tx->writes.writeback();
 
@@ -195,8 +175,9 @@ namespace {
 
       // get the lock and validate (use RingSTM obstruction-free technique)
       while (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
-          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
-              tx->tmabort(tx);
+          if ((tx->start_time = NOrecBarriers::validate(tx)) ==
+              VALIDATION_FAILED)
+              tx_abort(tx, ABORT_VALIDATION);
 
       tx->writes.writeback();
 
@@ -211,72 +192,86 @@ namespace {
       tx->writes.reset();
 
       // This switches the thread back to RO mode.
-      OnReadWriteCommit(tx, read_ro, write_ro, commit_ro);
+      OnReadWriteCommit(tx, NOrecBarriers::read_ro, write_ro, commit_ro);
   }
 
   template <class CM>
-  void*
-  NOrec_Generic<CM>::read_ro(STM_READ_SIG(tx,addr,mask))
+  void
+  NOrec_Generic<CM>::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
   {
-      // A read is valid iff it occurs during a period where the seqlock does
-      // not change and is even.  This code also polls for new changes that
-      // might necessitate a validation.
+      // buffer the write, and switch to a writing context
+      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      OnFirstWrite(tx, NOrecBarriers::read_rw, NOrecBarriers::write_rw,
+                   commit_rw);
+  }
 
-      // read the location to a temp
-      void* tmp = *addr;
-      CFENCE;
+  /**
+   *  NOrec range read: copy the whole range, and then check the sequence lock
+   *  once, instead of once per word.  A writer must check each word against
+   *  its write set, so it uses the word barrier instead.
+   */
+  template <class CM>
+  void
+  NOrec_Generic<CM>::read_range(STM_READ_RANGE_SIG(tx,addr,to,n))
+  {
+      if (tx->writes.size()) {
+          for (size_t i = 0; i < n; ++i)
+              to[i] = NOrecBarriers::read_rw(tx, addr + i STM_MASK(~0x0));
+          return;
+      }
 
-      // if the timestamp has changed since the last read, we must validate and
-      // restart this read
-      while (tx->start_time != timestamp.val) {
-          if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
-              tx->tmabort(tx);
-          tmp = *addr;
+      while (true) {
+          for (size_t i = 0; i < n; ++i)
+              to[i] = addr[i];
           CFENCE;
+          if (tx->start_time == timestamp.val)
+              break;
+          if ((tx->start_time = NOrecBarriers::validate(tx)) ==
+              VALIDATION_FAILED)
+              tx_abort(tx, ABORT_VALIDATION);
       }
 
-      // log the address and value, uses the macro to deal with
-      // STM_PROTECT_STACK
-      STM_LOG_VALUE(tx, addr, tmp, mask);
-      return tmp;
-  }
-
-  template <class CM>
-  void*
-  NOrec_Generic<CM>::read_rw(STM_READ_SIG(tx,addr,mask))
-  {
-      // check the log for a RAW hazard, we expect to miss
-      WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
-      bool found = tx->writes.find(log);
-      REDO_RAW_CHECK(found, log, mask);
-
-      // Use the code from the read-only read barrier. This is complicated by
-      // the fact that, when we are byte logging, we may have successfully read
-      // some bytes from the write log (if we read them all then we wouldn't
-      // make it here). In this case, we need to log the mask for the rest of the
-      // bytes that we "actually" need, which is computed as bytes in mask but
-      // not in log.mask. This is only correct because we know that a failed
-      // find also reset the log.mask to 0 (that's part of the find interface).
-      void* val = read_ro(tx, addr STM_MASK(mask & ~log.mask));
-      REDO_RAW_CLEANUP(val, found, log, mask);
-      return val;
+      for (size_t i = 0; i < n; ++i)
+          STM_LOG_VALUE(tx, addr + i, to[i], ~0x0);
   }
 
+  /*** NOrec range write: buffer every word, then switch contexts once */
   template <class CM>
   void
-  NOrec_Generic<CM>::write_ro(STM_WRITE_SIG(tx,addr,val,mask))
+  NOrec_Generic<CM>::write_range(STM_WRITE_RANGE_SIG(tx,addr,from,n))
   {
-      // buffer the write, and switch to a writing context
-      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
-      OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+      for (size_t i = 0; i < n; ++i)
+          tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr + i, from[i],
+                                                               ~0x0)));
+      if (n)
+          OnFirstWrite(tx, NOrecBarriers::read_rw, NOrecBarriers::write_rw,
+                       commit_rw);
   }
 
+  /**
+   *  NOrec read-after-read:
+   *
+   *    The first read logged this address, and validation will check that
+   *    entry, so a read-only transaction just needs a consistent value.  A
+   *    writer must still look in its write set.
+   */
   template <class CM>
-  void
-  NOrec_Generic<CM>::write_rw(STM_WRITE_SIG(tx,addr,val,mask))
+  void*
+  NOrec_Generic<CM>::read_after_read(STM_READ_SIG(tx,addr,mask))
   {
-      // just buffer the write
-      tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      if (tx->writes.size())
+          return NOrecBarriers::read_rw(tx, addr STM_MASK(mask));
+
+      void* tmp = *addr;
+      CFENCE;
+      while (tx->start_time != timestamp.val) {
+          if ((tx->start_time = NOrecBarriers::validate(tx)) ==
+              VALIDATION_FAILED)
+              tx_abort(tx, ABORT_VALIDATION);
+          tmp = *addr;
+          CFENCE;
+      }
+      return tmp;
   }
 
   template <class CM>
@@ -295,7 +290,7 @@ namespace {
 
       tx->vlist.reset();
       tx->writes.reset();
-      return stm::PostRollback(tx, read_ro, write_ro, commit_ro);
+      return stm::PostRollback(tx, NOrecBarriers::read_ro, write_ro, commit_ro);
   }
 } // (anonymous namespace)
 
@@ -314,6 +309,33 @@ namespace {
     }
 
 namespace stm {
+  uintptr_t
+  NOrecBarriers::validate(TxThread* tx)
+  {
+      while (true) {
+          // read the lock until it is even
+          uintptr_t s = timestamp.val;
+          if ((s & 1) == 1)
+              continue;
+
+          // check the read set
+          CFENCE;
+          // don't branch in the loop---consider it backoff if we fail
+          // validation early
+          bool valid = true;
+          foreach (ValueList, i, tx->vlist)
+              valid &= STM_LOG_VALUE_IS_VALID(i, tx);
+
+          if (!valid)
+              return VALIDATION_FAILED;
+
+          // restart if timestamp changed during read set iteration
+          CFENCE;
+          if (timestamp.val == s)
+              return s;
+      }
+  }
+
   FOREACH_NOREC(INIT_NOREC)
 }
 
@@ -18,7 +18,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::timestamp;
@@ -29,6 +29,8 @@ using stm::threads;
 using stm::WriteSetEntry;
 using stm::ValueList;
 using stm::ValueListEntry;
+using stm::tx_abort;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -123,7 +125,7 @@ namespace {
       // get the lock and validate (use RingSTM obstruction-free technique)
       while (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
           if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION);
 
       // redo writes
       tx->writes.writeback();
@@ -155,7 +157,7 @@ namespace {
 
       while (tx->start_time != timestamp.val) {
           if ((tx->start_time = validate(tx)) == VALIDATION_FAILED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION);
           tmp = *addr;
           CFENCE;
       }
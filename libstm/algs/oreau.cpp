@@ -32,6 +32,11 @@ using stm::get_orec;
 using stm::id_version_t;
 using stm::threads;
 using stm::UndoLogEntry;
+using stm::tx_abort;
+using stm::tx_abort_orec;
+using stm::ABORT_KILLED;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -122,7 +127,7 @@ namespace {
               uintptr_t ivt = (*i)->v.all;
               // if unlocked and newer than start time, abort
               if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
           }
       }
 
@@ -173,12 +178,12 @@ namespace {
               if (CM::mayKill(tx, ivt.fields.id - 1))
                   threads[ivt.fields.id-1]->alive = TX_ABORTED;
               else
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
           }
 
           // liveness check
           if (tx->alive == TX_ABORTED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
 
           // scale timestamp if ivt2 is too new
           uintptr_t newts = timestamp.val;
@@ -224,12 +229,12 @@ namespace {
               if (CM::mayKill(tx, ivt.fields.id - 1))
                   threads[ivt.fields.id-1]->alive = TX_ABORTED;
               else
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
           }
 
           // liveness check
           if (tx->alive == TX_ABORTED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
 
           // scale timestamp if ivt2 is too new
           uintptr_t newts = timestamp.val;
@@ -256,7 +261,7 @@ namespace {
           // common case: uncontended location... lock it
           if (ivt.all <= tx->start_time) {
               if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all);
 
               // save old, log lock, write, return
               o->p = ivt.all;
@@ -272,12 +277,12 @@ namespace {
               if (CM::mayKill(tx, ivt.fields.id - 1))
                   threads[ivt.fields.id-1]->alive = TX_ABORTED;
               else
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
           }
 
           // liveness check
           if (tx->alive == TX_ABORTED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
 
           // unlocked but too new... scale forward and try again
           uintptr_t newts = timestamp.val;
@@ -303,7 +308,7 @@ namespace {
           // common case: uncontended location... lock it
           if (ivt.all <= tx->start_time) {
               if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all);
 
               // save old, log lock, write, return
               o->p = ivt.all;
@@ -325,12 +330,12 @@ namespace {
               if (CM::mayKill(tx, ivt.fields.id - 1))
                   threads[ivt.fields.id-1]->alive = TX_ABORTED;
               else
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
           }
 
           // liveness check
           if (tx->alive == TX_ABORTED)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
 
           // unlocked but too new... scale forward and try again
           uintptr_t newts = timestamp.val;
@@ -404,7 +409,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if unlocked and newer than start time, abort
           if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
       }
   }
 
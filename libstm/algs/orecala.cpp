@@ -20,7 +20,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::timestamp;
@@ -32,6 +32,9 @@ using stm::orec_t;
 using stm::get_orec;
 using stm::WriteSetEntry;
 using stm::UNRECOVERABLE;
+using stm::tx_abort_orec;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -114,13 +117,13 @@ namespace {
           if (ivt <= tx->start_time) {
               // abort if cannot acquire
               if (!bcasptr(&o->v.all, ivt, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all);
               // save old version to o->p, remember that we hold the lock
               o->p = ivt;
               tx->locks.insert(o);
           }
           else if (ivt != tx->my_lock.all) {
-              tx->tmabort(tx);
+              tx_abort_orec(tx, o, ivt);
           }
       }
 
@@ -133,7 +136,7 @@ namespace {
               // read this orec
               uintptr_t ivt = (*i)->v.all;
               if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
           }
       }
 
@@ -176,7 +179,7 @@ namespace {
 
       // make sure this location isn't locked or too new
       if (o->v.all > tx->start_time)
-          tx->tmabort(tx);
+          tx_abort_orec(tx, o, o->v.all);
 
       // privatization safety: poll the timestamp, maybe validate
       uintptr_t ts = timestamp.val;
@@ -291,7 +294,7 @@ namespace {
           // if orec unlocked and newer than start time, it changed, so abort.
           // if locked, it's not locked by me so abort
           if ((*i)->v.all > tx->start_time)
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, (*i)->v.all);
       }
 
       // remember that we validated at this time
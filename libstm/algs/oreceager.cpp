@@ -52,6 +52,9 @@ using stm::orec_t;
 using stm::get_orec;
 using stm::id_version_t;
 using stm::UndoLogEntry;
+using stm::tx_abort_orec;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -74,6 +77,10 @@ namespace {
 
   TM_FASTCALL void* read(STM_READ_SIG(,,));
   TM_FASTCALL void write(STM_WRITE_SIG(,,,));
+  TM_FASTCALL void* read_after_read(STM_READ_SIG(,,));
+  TM_FASTCALL void* read_after_write(STM_READ_SIG(,,));
+  TM_FASTCALL void* read_for_write(STM_READ_SIG(,,));
+  TM_FASTCALL void write_after_write(STM_WRITE_SIG(,,,));
   bool irrevoc(TxThread*);
   NOINLINE void validate(TxThread*);
   void onSwitchTo();
@@ -95,6 +102,10 @@ namespace {
 
       stm::stms[id].read      = read;
       stm::stms[id].write     = write;
+      stm::stms[id].hints.read_after_read   = read_after_read;
+      stm::stms[id].hints.read_after_write  = read_after_write;
+      stm::stms[id].hints.read_for_write    = read_for_write;
+      stm::stms[id].hints.write_after_write = write_after_write;
       stm::stms[id].irrevoc   = irrevoc;
       stm::stms[id].switcher  = onSwitchTo;
       stm::stms[id].privatization_safe = false;
@@ -140,7 +151,7 @@ namespace {
               // abort unless orec older than start or owned by me
               uintptr_t ivt = (*i)->v.all;
               if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
           }
       }
 
@@ -194,7 +205,7 @@ namespace {
 
           // abort if locked
           if (__builtin_expect(ivt.fields.lock, 0))
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all, addr);
 
           // scale timestamp if ivt is too new, then try again
           uintptr_t newts = timestamp.val;
@@ -221,7 +232,7 @@ namespace {
           // common case: uncontended location... try to lock it, abort on fail
           if (ivt.all <= tx->start_time) {
               if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all, addr);
 
               // save old value, log lock, do the write, and return
               o->p = ivt.all;
@@ -242,7 +253,7 @@ namespace {
 
           // fail if lock held by someone else
           if (ivt.fields.lock)
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all, addr);
 
           // unlocked but too new... scale forward and try again
           uintptr_t newts = timestamp.val;
@@ -251,6 +262,98 @@ namespace {
       }
   }
 
+  /**
+   *  OrecEager read-after-read:
+   *
+   *    The orec is already in the read set (or locked by us), so if it is
+   *    unchanged we can skip logging it again
+   */
+  void*
+  read_after_read(STM_READ_SIG(tx,addr,mask))
+  {
+      orec_t* o = get_orec(addr);
+      uintptr_t ivt = o->v.all;
+      CFENCE;
+      void* tmp = *addr;
+      CFENCE;
+      if ((ivt == o->v.all) &&
+          ((ivt <= tx->start_time) || (ivt == tx->my_lock.all)))
+          return tmp;
+      return read(tx, addr STM_MASK(mask));
+  }
+
+  /**
+   *  OrecEager read-after-write:
+   *
+   *    We almost certainly hold the lock, and writes are in place
+   */
+  void*
+  read_after_write(STM_READ_SIG(tx,addr,mask))
+  {
+      if (get_orec(addr)->v.all == tx->my_lock.all)
+          return *addr;
+      return read(tx, addr STM_MASK(mask));
+  }
+
+  /**
+   *  OrecEager read-for-write:
+   *
+   *    Acquire the orec now, as the coming write would, and undo-log the
+   *    word, so that the read needs no read logging and the write can be a
+   *    write-after-write.  The word must be logged even if we already hold
+   *    the orec, since another word may be the one that got us the lock.
+   */
+  void*
+  read_for_write(STM_READ_SIG(tx,addr,mask))
+  {
+      orec_t* o = get_orec(addr);
+      while (true) {
+          id_version_t ivt;
+          ivt.all = o->v.all;
+
+          // already mine
+          if (ivt.all == tx->my_lock.all) {
+              tx->undo_log.insert(UndoLogEntry(STM_UNDO_LOG_ENTRY(addr, *addr, mask)));
+              return *addr;
+          }
+
+          // uncontended location... try to lock it, abort on fail
+          if (ivt.all <= tx->start_time) {
+              if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all))
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all, addr);
+              o->p = ivt.all;
+              tx->locks.insert(o);
+              tx->undo_log.insert(UndoLogEntry(STM_UNDO_LOG_ENTRY(addr, *addr, mask)));
+              return *addr;
+          }
+
+          // fail if lock held by someone else
+          if (ivt.fields.lock)
+              tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all, addr);
+
+          // unlocked but too new... scale forward and try again
+          uintptr_t newts = timestamp.val;
+          validate(tx);
+          tx->start_time = newts;
+      }
+  }
+
+  /**
+   *  OrecEager write-after-write:
+   *
+   *    The first write to this word logged its old value, so if we still
+   *    hold the lock we can write without logging again
+   */
+  void
+  write_after_write(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      if (get_orec(addr)->v.all == tx->my_lock.all) {
+          STM_DO_MASKED_WRITE(addr, val, mask);
+          return;
+      }
+      write(tx, addr, val STM_MASK(mask));
+  }
+
   /**
    *  OrecEager rollback:
    *
@@ -348,7 +451,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if unlocked and newer than start time, abort
           if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
       }
   }
 
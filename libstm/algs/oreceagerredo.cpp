@@ -20,7 +20,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -31,6 +31,9 @@ using stm::WriteSetEntry;
 using stm::timestamp;
 using stm::timestamp_max;
 using stm::id_version_t;
+using stm::tx_abort_orec;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -98,7 +101,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if unlocked and newer than start time, abort
           if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
       }
 
       // run the redo log
@@ -145,7 +148,7 @@ namespace {
 
           // abort if locked by other
           if (ivt.fields.lock)
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
 
           // scale timestamp if ivt is too new
           uintptr_t newts = timestamp.val;
@@ -190,7 +193,7 @@ namespace {
 
           // abort if locked by other
           if (ivt.fields.lock)
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
 
           // scale timestamp if ivt is too new
           uintptr_t newts = timestamp.val;
@@ -222,7 +225,7 @@ namespace {
           // common case: uncontended location... lock it
           if (ivt.all <= tx->start_time) {
               if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all);
 
               // save old, log lock, write, return
               o->p = ivt.all;
@@ -233,7 +236,7 @@ namespace {
 
           // fail if lock held
           if (ivt.fields.lock)
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
 
           // unlocked but too new... scale forward and try again
           uintptr_t newts = timestamp.val;
@@ -264,7 +267,7 @@ namespace {
           // common case: uncontended location... lock it
           if (ivt.all <= tx->start_time) {
               if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all);
 
               // save old, log lock, write, return
               o->p = ivt.all;
@@ -278,7 +281,7 @@ namespace {
 
           // fail if lock held
           if (ivt.fields.lock)
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
 
           // unlocked but too new... scale forward and try again
           uintptr_t newts = timestamp.val;
@@ -336,7 +339,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if unlocked and newer than start time, abort
           if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
       }
   }
 
@@ -21,7 +21,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::timestamp;
@@ -33,6 +33,9 @@ using stm::WriteSet;
 using stm::OrecList;
 using stm::WriteSetEntry;
 using stm::id_version_t;
+using stm::tx_abort_orec;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -111,14 +114,14 @@ namespace {
           if (ivt <= tx->start_time) {
               // abort if cannot acquire
               if (!bcasptr(&o->v.all, ivt, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all);
               // save old version to o->p, log lock
               o->p = ivt;
               tx->locks.insert(o);
           }
           // else if we don't hold the lock abort
           else if (ivt != tx->my_lock.all) {
-              tx->tmabort(tx);
+              tx_abort_orec(tx, o, ivt);
           }
       }
 
@@ -131,7 +134,7 @@ namespace {
               // read this orec
               uintptr_t ivt = (*i)->v.all;
               if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
           }
       }
 
@@ -200,7 +203,7 @@ namespace {
           foreach (OrecList, i, tx->r_orecs) {
               // if orec locked or newer than start time, abort
               if ((*i)->v.all > tx->start_time)
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, (*i)->v.all);
           }
 
           uintptr_t cs = last_complete.val;
@@ -313,7 +316,7 @@ namespace {
       foreach (OrecList, i, tx->r_orecs) {
           // if orec locked or newer than start time, abort
           if ((*i)->v.all > tx->start_time)
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, (*i)->v.all);
       }
       // careful here: we can't scale the start time past last_complete.val,
       // unless we want to re-introduce the need for prevalidation on every
@@ -24,7 +24,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::timestamp;
@@ -44,6 +44,12 @@ using stm::MAX_THREADS;
 using stm::threads;
 using stm::prioTxCount;
 using stm::WriteSetEntry;
+using stm::tx_abort;
+using stm::tx_abort_orec;
+using stm::ABORT_CONFLICT;
+using stm::ABORT_LOCKED;
+using stm::ABORT_TOO_NEW;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -149,7 +155,7 @@ namespace
           // else if we don't hold the lock abort
           else if (ivt.all != tx->my_lock.all) {
               if (!ivt.fields.lock)
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_TOO_NEW, o, ivt.all);
               // priority test... if I have priority, and the last unlocked
               // version of the orec was the one I read, and the current
               // owner has less priority than me, wait
@@ -159,7 +165,7 @@ namespace
                       continue;
                   }
               }
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
           }
           ++i;
       }
@@ -181,7 +187,7 @@ namespace
               unsigned mask = 1lu<<(slot % rrec_t::BITS);
               if (accumulator.bits[bucket] & mask) {
                   if (threads[slot]->prio > tx->prio)
-                      tx->tmabort(tx);
+                      tx_abort(tx, ABORT_CONFLICT, NULL, slot + 1);
               }
           }
       }
@@ -502,7 +508,7 @@ namespace
           // only a problem if locked or newer than start time
           if (ivt.all > tx->start_time) {
               if (!ivt.fields.lock)
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt.all);
               // priority test... if I have priority, and the last unlocked
               // orec was the one I read, and the current owner has less
               // priority than me, wait
@@ -512,7 +518,7 @@ namespace
                       continue;
                   }
               }
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt.all);
           }
           ++i;
       }
@@ -535,7 +541,7 @@ namespace
               ivt.all = (*i)->v.all;
               // if unlocked and newer than start time, abort
               if (!ivt.fields.lock && (ivt.all > tx->start_time))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt.all);
 
               // if locked and not by me, do a priority test
               if (ivt.fields.lock && (ivt.all != tx->my_lock.all)) {
@@ -548,7 +554,7 @@ namespace
                       spin64();
                       continue;
                   }
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt.all);
               }
               ++i;
           }
@@ -560,7 +566,7 @@ namespace
               ivt.all = (*i)->v.all;
               // if unlocked and newer than start time, abort
               if ((ivt.all > tx->start_time) && (ivt.all != tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt.all);
           }
       }
   }
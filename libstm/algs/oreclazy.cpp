@@ -21,7 +21,7 @@
 #include "../profiling.hpp"
 #include "../cm.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::get_orec;
@@ -32,6 +32,9 @@ using stm::orec_t;
 using stm::timestamp;
 using stm::timestamp_max;
 using stm::id_version_t;
+using stm::tx_abort_orec;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 namespace {
@@ -43,6 +46,9 @@ namespace {
       static TM_FASTCALL void* read_rw(STM_READ_SIG(,,));
       static TM_FASTCALL void write_ro(STM_WRITE_SIG(,,,));
       static TM_FASTCALL void write_rw(STM_WRITE_SIG(,,,));
+      static TM_FASTCALL void read_range(STM_READ_RANGE_SIG(,,,));
+      static TM_FASTCALL void write_range(STM_WRITE_RANGE_SIG(,,,));
+      static TM_FASTCALL void* read_after_read(STM_READ_SIG(,,));
       static TM_FASTCALL void commit_ro(TxThread*);
       static TM_FASTCALL void commit_rw(TxThread*);
 
@@ -66,6 +72,11 @@ namespace {
       stm::stms[id].commit    = OrecLazy_Generic<CM>::commit_ro;
       stm::stms[id].read      = OrecLazy_Generic<CM>::read_ro;
       stm::stms[id].write     = OrecLazy_Generic<CM>::write_ro;
+      stm::stms[id].read_range  = OrecLazy_Generic<CM>::read_range;
+      stm::stms[id].write_range = OrecLazy_Generic<CM>::write_range;
+      stm::stms[id].hints.read_after_read  =
+          OrecLazy_Generic<CM>::read_after_read;
+      stm::stms[id].hints.read_after_write = OrecLazy_Generic<CM>::read_rw;
       stm::stms[id].rollback  = OrecLazy_Generic<CM>::rollback;
       stm::stms[id].irrevoc   = irrevoc;
       stm::stms[id].switcher  = onSwitchTo;
@@ -123,14 +134,14 @@ namespace {
           if (ivt <= tx->start_time) {
               // abort if cannot acquire
               if (!bcasptr(&o->v.all, ivt, tx->my_lock.all))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, o->v.all, i->addr);
               // save old version to o->p, remember that we hold the lock
               o->p = ivt;
               tx->locks.insert(o);
           }
           // else if we don't hold the lock abort
           else if (ivt != tx->my_lock.all) {
-              tx->tmabort(tx);
+              tx_abort_orec(tx, o, ivt, i->addr);
           }
       }
 
@@ -139,7 +150,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if unlocked and newer than start time, abort
           if ((ivt > tx->start_time) && (ivt != tx->my_lock.all))
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, ivt);
       }
 
       // run the redo log
@@ -247,6 +258,63 @@ namespace {
       tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
   }
 
+  /**
+   *  OrecLazy range read:
+   *
+   *    Every word has its own orec, so there is still one check per word,
+   *    but the barrier is inlined into the loop rather than called through
+   *    tx->tmread, and the RAW check is skipped when nothing has been written
+   */
+  template <class CM>
+  void
+  OrecLazy_Generic<CM>::read_range(STM_READ_RANGE_SIG(tx,addr,to,n))
+  {
+      if (tx->writes.size()) {
+          for (size_t i = 0; i < n; ++i)
+              to[i] = read_rw(tx, addr + i STM_MASK(~0x0));
+      }
+      else {
+          for (size_t i = 0; i < n; ++i)
+              to[i] = read_ro(tx, addr + i STM_MASK(~0x0));
+      }
+  }
+
+  /**
+   *  OrecLazy range write:
+   *
+   *    Buffer every word, then switch to a writing context once
+   */
+  template <class CM>
+  void
+  OrecLazy_Generic<CM>::write_range(STM_WRITE_RANGE_SIG(tx,addr,from,n))
+  {
+      for (size_t i = 0; i < n; ++i)
+          tx->writes.insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr + i, from[i],
+                                                               ~0x0)));
+      if (n)
+          OnFirstWrite(tx, read_rw, write_rw, commit_rw);
+  }
+
+  /**
+   *  OrecLazy read-after-read:
+   *
+   *    The orec is already in the read set, so if it hasn't changed we
+   *    don't log it again.  Otherwise, the regular read handles it.
+   */
+  template <class CM>
+  void*
+  OrecLazy_Generic<CM>::read_after_read(STM_READ_SIG(tx,addr,mask))
+  {
+      if (tx->writes.size())
+          return read_rw(tx, addr STM_MASK(mask));
+
+      void* tmp = *addr;
+      CFENCE;
+      if (get_orec(addr)->v.all <= tx->start_time)
+          return tmp;
+      return read_ro(tx, addr STM_MASK(mask));
+  }
+
   /**
    *  OrecLazy rollback:
    *
@@ -306,7 +374,7 @@ namespace {
       foreach (OrecList, i, tx->r_orecs)
           // abort if orec locked, or if unlocked but timestamp too new
           if ((*i)->v.all > tx->start_time)
-              tx->tmabort(tx);
+              tx_abort_orec(tx, ABORT_VALIDATION, *i, (*i)->v.all);
   }
 
   /**
@@ -24,7 +24,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 #include <stm/UndoLog.hpp> // STM_DO_MASKED_WRITE
 
 using stm::TxThread;
@@ -39,6 +39,10 @@ using stm::OrecList;
 using stm::WriteSet;
 using stm::UNRECOVERABLE;
 using stm::WriteSetEntry;
+using stm::tx_abort;
+using stm::ABORT_SWITCH;
+using stm::ABORT_TOO_NEW;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -108,14 +112,14 @@ namespace {
           // in this wait loop, we need to check if an adaptivity action is
           // underway :(
           if (TxThread::tmbegin != begin)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_SWITCH);
       }
       foreach (OrecList, i, tx->r_orecs) {
           // read this orec
           uintptr_t ivt = (*i)->v.all;
           // if it has a timestamp of ts_cache or greater, abort
           if (ivt > tx->ts_cache)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION, *i);
       }
       // mark self as complete
       last_complete.val = tx->order;
@@ -142,14 +146,14 @@ namespace {
       // wait our turn, validate, writeback
       while (last_complete.val != ((uintptr_t)tx->order - 1)) {
           if (TxThread::tmbegin != begin)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_SWITCH);
       }
       foreach (OrecList, i, tx->r_orecs) {
           // read this orec
           uintptr_t ivt = (*i)->v.all;
           // if it has a timestamp of ts_cache or greater, abort
           if (ivt > tx->ts_cache)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION, *i);
       }
       // mark every location in the write set, and perform write-back
       // NB: we cannot abort anymore
@@ -215,7 +219,7 @@ namespace {
       uintptr_t ivt = o->v.all;
       // abort if this changed since the last time I saw someone finish
       if (ivt > tx->ts_cache)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_TOO_NEW, o);
       // log orec
       tx->r_orecs.insert(o);
       // validate if necessary
@@ -243,7 +247,7 @@ namespace {
       uintptr_t ivt = o->v.all;
       // abort if this changed since the last time I saw someone finish
       if (ivt > tx->ts_cache)
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_TOO_NEW, o);
       // log orec
       tx->r_orecs.insert(o);
       // validate if necessary
@@ -352,7 +356,7 @@ namespace {
           uintptr_t ivt = (*i)->v.all;
           // if it has a timestamp of ts_cache or greater, abort
           if (ivt > tx->ts_cache)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION, *i);
       }
       // now update the finish_cache to remember that at this time, we were
       // still valid
@@ -19,7 +19,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -29,6 +29,10 @@ using stm::last_init;
 using stm::ring_wf;
 using stm::RING_ELEMENTS;
 using stm::WriteSetEntry;
+using stm::tx_abort;
+using stm::ABORT_CONFLICT;
+using stm::ABORT_RING;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -103,7 +107,7 @@ namespace {
               // change from here on out.
               for (uintptr_t i = commit_time; i >= tx->start_time + 1; i--)
                   if (ring_wf[i % RING_ELEMENTS].intersect(tx->rf))
-                      tx->tmabort(tx);
+                      tx_abort(tx, ABORT_VALIDATION);
 
               // wait for newest entry to be wb-complete before continuing
               while (last_complete.val < commit_time)
@@ -111,7 +115,7 @@ namespace {
 
               // detect ring rollover: start.ts must not have changed
               if (timestamp.val > (tx->start_time + RING_ELEMENTS))
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_RING);
 
               // ensure this tx doesn't look at this entry again
               tx->start_time = commit_time;
@@ -147,7 +151,7 @@ namespace {
   {
       // abort if this read would violate ALA
       if (tx->cf->lookup(addr))
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_CONFLICT, addr);
 
       // read the value from memory, log the address, and validate
       void* val = *addr;
@@ -172,7 +176,7 @@ namespace {
 
       // abort if this read would violate ALA
       if (tx->cf->lookup(addr))
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_CONFLICT, addr);
 
       // read the value from memory, log the address, and validate
       void* val = *addr;
@@ -257,11 +261,11 @@ namespace {
       CFENCE;
       // detect ring rollover: start.ts must not have changed
       if (timestamp.val > (tx->start_time + RING_ELEMENTS))
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_RING);
 
       // now intersect my rf with my cf
       if (tx->rf->intersect(tx->cf))
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_VALIDATION);
 
       // wait for newest entry to be writeback-complete before returning
       while (last_complete.val < my_index)
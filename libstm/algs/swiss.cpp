@@ -10,7 +10,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -30,6 +30,11 @@ using stm::id_version_t;
 using stm::nanorec_t;
 using stm::NanorecList;
 using stm::OrecList;
+using stm::tx_abort;
+using stm::tx_abort_orec;
+using stm::ABORT_KILLED;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 
 /**
@@ -130,7 +135,7 @@ namespace
               // bad read: we'll go back to top, but first make sure we didn't
               // get aborted
               if (tx->alive == ABORTED)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_KILLED);
               continue;
           }
           // the read was good: log the orec
@@ -169,10 +174,10 @@ namespace
           // if locked, CM will either tell us to self-abort, or to continue
           if (ivt.fields.lock) {
               if (cm_should_abort(tx, ivt.fields.id))
-                  tx->tmabort(tx);
+                  tx_abort_orec(tx, ABORT_LOCKED, o, ivt.all);
               // check liveness before continuing
               if (tx->alive == ABORTED)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_KILLED);
               continue;
           }
 
@@ -180,7 +185,7 @@ namespace
           if (!bcasptr(&o->v.all, ivt.all, tx->my_lock.all)) {
               // check liveness before continuing
               if (tx->alive == ABORTED)
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_KILLED);
               continue;
           }
 
@@ -284,7 +289,7 @@ namespace
   {
       foreach (OrecList, i, tx->r_orecs) {
           if ((*i)->p > tx->start_time)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_VALIDATION, *i);
       }
   }
 
@@ -300,7 +305,7 @@ namespace
                   foreach (NanorecList, i, tx->nanorecs) {
                       i->o->p = i->v;
                   }
-                  tx->tmabort(tx);
+                  tx_abort(tx, ABORT_VALIDATION, *i);
               }
           }
       }
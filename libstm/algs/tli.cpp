@@ -19,7 +19,7 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -27,6 +27,8 @@ using stm::timestamp;
 using stm::threads;
 using stm::threadcount;
 using stm::WriteSetEntry;
+using stm::tx_abort;
+using stm::ABORT_KILLED;
 
 
 /**
@@ -70,7 +72,7 @@ namespace {
   {
       // if the transaction is invalid, abort
       if (__builtin_expect(tx->alive == 2, false))
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
 
       // ok, all is good
       tx->alive = 0;
@@ -86,7 +88,7 @@ namespace {
   {
       // if the transaction is invalid, abort
       if (__builtin_expect(tx->alive == 2, false))
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
 
       // grab the lock to stop the world
       uintptr_t tmp = timestamp.val;
@@ -98,7 +100,7 @@ namespace {
       // double check that we're valid
       if (__builtin_expect(tx->alive == 2,false)) {
           timestamp.val = tmp + 2; // release the lock
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_KILLED);
       }
 
       // kill conflicting transactions
@@ -147,7 +149,7 @@ namespace {
               return val;
           // abort if we're killed
           if (tx->alive == 2)
-              tx->tmabort(tx);
+              tx_abort(tx, ABORT_KILLED);
       }
   }
 
@@ -15,33 +15,28 @@
  *    algorithm allows multiple readers or a single irrevocable writer.  The
  *    semantics are at least as strong as ALA.
  *
- *    NB: now that we dropped the inlined-tml instrumentation hack, we should
- *        probably add ro/rw functions
+ *    NB: the read and write barriers are in stm/inline_barriers.hpp, so
+ *        that single-algorithm builds can inline them.  We should probably
+ *        add ro/rw functions.
  */
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "tml_inline.hpp"
-#include <stm/UndoLog.hpp> // STM_DO_MASKED_WRITE
 
 using stm::TxThread;
 using stm::timestamp;
 using stm::Trigger;
 using stm::UNRECOVERABLE;
+using stm::TMLBarriers;
 
 
 /**
  *  Declare the functions that we're going to implement, so that we can avoid
- *  circular dependencies.  Note that with TML, we don't expect the reads and
- *  writes to be called, because we expect the instrumentation to be inlined
- *  via the dispatch mechanism.  However, we must provide the code to handle
- *  the uncommon case.
+ *  circular dependencies.
  */
 namespace {
   struct TML {
       static TM_FASTCALL bool begin(TxThread*);
-      static TM_FASTCALL void* read(STM_READ_SIG(,,));
-      static TM_FASTCALL void write(STM_WRITE_SIG(,,,));
       static TM_FASTCALL void commit(TxThread*);
 
       static stm::scope_t* rollback(STM_ROLLBACK_SIG(,,));
@@ -87,41 +82,6 @@ namespace {
       Trigger::onCommitLock(tx);
   }
 
-  /**
-   *  TML read:
-   *
-   *    If we have the lock, we're irrevocable so just do a read.  Otherwise,
-   *    after doing the read, make sure we are still valid.
-   */
-  void*
-  TML::read(STM_READ_SIG(tx,addr,))
-  {
-      void* val = *addr;
-      if (tx->tmlHasLock)
-          return val;
-      // NB:  afterread_tml includes a CFENCE
-      afterread_TML(tx);
-      return val;
-  }
-
-  /**
-   *  TML write:
-   *
-   *    If we have the lock, do an in-place write and return.  Otherwise, we
-   *    need to become irrevocable first, then do the write.
-   */
-  void
-  TML::write(STM_WRITE_SIG(tx,addr,val,mask))
-  {
-      if (tx->tmlHasLock) {
-          STM_DO_MASKED_WRITE(addr, val, mask);
-          return;
-      }
-      // NB:  beforewrite_tml includes a fence via CAS
-      beforewrite_TML(tx);
-      STM_DO_MASKED_WRITE(addr, val, mask);
-  }
-
   /**
    *  TML unwinder
    *
@@ -178,8 +138,8 @@ namespace stm {
       // set the pointers
       stms[TML].begin     = ::TML::begin;
       stms[TML].commit    = ::TML::commit;
-      stms[TML].read      = ::TML::read;
-      stms[TML].write     = ::TML::write;
+      stms[TML].read      = TMLBarriers::read;
+      stms[TML].write     = TMLBarriers::write;
       stms[TML].rollback  = ::TML::rollback;
       stms[TML].irrevoc   = ::TML::irrevoc;
       stms[TML].switcher  = ::TML::onSwitchTo;
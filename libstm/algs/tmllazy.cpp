@@ -20,11 +20,14 @@
 
 #include "../profiling.hpp"
 #include "algs.hpp"
-#include "RedoRAWUtils.hpp"
+#include "stm/RedoRAWUtils.hpp"
 
 using stm::TxThread;
 using stm::timestamp;
 using stm::WriteSetEntry;
+using stm::tx_abort;
+using stm::ABORT_LOCKED;
+using stm::ABORT_VALIDATION;
 
 /**
  *  Declare the functions that we're going to implement, so that we can avoid
@@ -81,7 +84,7 @@ namespace {
   {
       // we have writes... if we can't get the lock, abort
       if (!bcasptr(&timestamp.val, tx->start_time, tx->start_time + 1))
-          tx->tmabort(tx);
+          tx_abort(tx, ABORT_LOCKED, &timestamp.val);
 
       // we're committed... run the redo log
       tx->writes.writeback();
@@ -107,7 +110,7 @@ namespace {
       // NB: this form of /if/ appears to be faster
       if (__builtin_expect(timestamp.val == tx->start_time, true))
           return tmp;
-      tx->tmabort(tx);
+      tx_abort(tx, ABORT_VALIDATION, &timestamp.val);
       // unreachable
       return NULL;
   }
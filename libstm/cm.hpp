@@ -104,8 +104,9 @@ namespace stm
       {
           if (!tx->strong_HG)
               while (fcm_timestamp.val)
-                  if (TxThread::tmbegin == begin_blocker)
-                      tx->tmabort(tx);
+                  if ((TxThread::tmbegin == begin_blocker) ||
+                      (TxThread::tmbegin == begin_draining))
+                      tx_abort(tx, ABORT_SWITCH);
       }
 
       /**
@@ -166,8 +167,9 @@ namespace stm
       {
           if (!tx->strong_HG)
               while (fcm_timestamp.val)
-                  if (TxThread::tmbegin == begin_blocker)
-                      tx->tmabort(tx);
+                  if ((TxThread::tmbegin == begin_blocker) ||
+                      (TxThread::tmbegin == begin_draining))
+                      tx_abort(tx, ABORT_SWITCH);
       }
 
       /**
@@ -220,8 +222,9 @@ namespace stm
       {
           if (!tx->strong_HG)
               while (fcm_timestamp.val)
-                  if (TxThread::tmbegin == begin_blocker)
-                      tx->tmabort(tx);
+                  if ((TxThread::tmbegin == begin_blocker) ||
+                      (TxThread::tmbegin == begin_draining))
+                      tx_abort(tx, ABORT_SWITCH);
       }
 
       /**
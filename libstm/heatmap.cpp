@@ -0,0 +1,154 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  Sampled conflict heatmap.  When libstm is configured with
+ *  libstm_enable_conflict_heatmap, one in every heat_period orec-based
+ *  aborts (per thread) is charged to a stripe of the orec table, along with
+ *  a representative program address that maps to that orec.  At shutdown,
+ *  or whenever dump_conflict_heatmap is called, we print the hottest
+ *  stripes and use dladdr to name the addresses that live in a loaded
+ *  object (globals, statics).  Heap addresses can't be named this way, but
+ *  the address is still printed so that it can be matched against the
+ *  program's own allocation logs.
+ */
+
+#include <stm/config.h>
+#include <stm/lib_globals.hpp>
+
+#ifdef STM_CONFLICT_HEATMAP_YES
+
+#include <dlfcn.h>
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+#include <stm/txthread.hpp>
+#include "algs/algs.hpp"
+
+using namespace stm;
+
+namespace
+{
+  /**
+   *  Many orecs share one stripe, so that the table stays small.  Each
+   *  stripe remembers the last orec and address charged to it.
+   */
+  const uint32_t HEAT_STRIPES = 65536;
+
+  struct heat_t
+  {
+      volatile uintptr_t   hits;
+      const volatile void* orec;
+      void*                addr;
+  };
+
+  heat_t heatmap[HEAT_STRIPES];
+
+  /*** order stripes from hottest to coldest */
+  bool hotter(const heat_t* a, const heat_t* b)
+  {
+      return a->hits > b->hits;
+  }
+
+  /**
+   *  If the caller didn't know the program address, we can often recover
+   *  one from the write set or undo log, since locks are usually acquired
+   *  on behalf of a logged write.
+   */
+  void* find_addr(TxThread* tx, const volatile void* o)
+  {
+      foreach (WriteSet, i, tx->writes)
+          if (get_orec(i->addr) == o)
+              return i->addr;
+      foreach (UndoLog, i, tx->undo_log)
+          if (get_orec(i->addr) == o)
+              return i->addr;
+      return NULL;
+  }
+} // (anonymous namespace)
+
+namespace stm
+{
+  /*** how many orec aborts per thread between samples */
+  uint32_t heat_period = 8;
+
+  /**
+   *  Charge a sampled conflict to o's stripe.  Only orecs from the global
+   *  table are counted; Nano's private orecs, for example, are ignored.
+   */
+  void heatmap_record(TxThread* tx, const volatile void* o, void* addr)
+  {
+      tx->heat_countdown = heat_period;
+
+      const orec_t* orec = (const orec_t*)o;
+      if ((orec < orecs) || (orec >= orecs + NUM_STRIPES))
+          return;
+      heat_t& h = heatmap[(orec - orecs) % HEAT_STRIPES];
+      faiptr(&h.hits);
+      h.orec = o;
+      if (!addr)
+          addr = find_addr(tx, o);
+      if (addr)
+          h.addr = addr;
+  }
+
+  /**
+   *  Print the top hottest stripes.  This is safe to call while
+   *  transactions are running, though the counts may be slightly stale.
+   */
+  void dump_conflict_heatmap(unsigned top)
+  {
+      std::vector<const heat_t*> hot;
+      uintptr_t total = 0;
+      for (uint32_t i = 0; i < HEAT_STRIPES; ++i) {
+          if (heatmap[i].hits) {
+              hot.push_back(&heatmap[i]);
+              total += heatmap[i].hits;
+          }
+      }
+      if (!total)
+          return;
+
+      if (top > hot.size())
+          top = hot.size();
+      std::partial_sort(hot.begin(), hot.begin() + top, hot.end(), hotter);
+
+      printf("Conflict heatmap: %lu samples (1 in %u), %lu stripes\n",
+             (unsigned long)total, heat_period, (unsigned long)hot.size());
+      for (unsigned i = 0; i < top; ++i) {
+          const heat_t* h = hot[i];
+          const orec_t* orec = (const orec_t*)h->orec;
+          printf("  %6.2f%% %8lu  orec %7lu  addr %p",
+                 (100.0 * h->hits) / total, (unsigned long)h->hits,
+                 (unsigned long)(orec - orecs), h->addr);
+
+          Dl_info info;
+          if (h->addr && dladdr(h->addr, &info)) {
+              if (info.dli_sname)
+                  printf("  %s+0x%lx", info.dli_sname,
+                         (unsigned long)((char*)h->addr -
+                                         (char*)info.dli_saddr));
+              else if (info.dli_fname)
+                  printf("  (in %s)", info.dli_fname);
+          }
+          printf("\n");
+      }
+  }
+} // namespace stm
+
+#else
+
+namespace stm
+{
+  /*** without the heatmap, there is nothing to report */
+  void dump_conflict_heatmap(unsigned) { }
+} // namespace stm
+
+#endif // STM_CONFLICT_HEATMAP_YES
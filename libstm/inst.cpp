@@ -17,15 +17,209 @@
 #include "policies/policies.hpp"
 #include "algs/algs.hpp"
 
+using namespace stm;
+
+namespace
+{
+  /**
+   *  The compatibility matrix for non-blocking switches.  Each row is a set
+   *  of algorithms that differ only in their contention manager: they share
+   *  all metadata, acquire locks the same way, and validate the same way, so
+   *  a transaction using one member of a set cannot tell that a concurrent
+   *  transaction is using another.
+   *
+   *  The Hourglass CMs treat a nonzero fcm_timestamp as a token, while FCM
+   *  uses fcm_timestamp as a counter, so variants that use the hourglass are
+   *  kept apart from those that don't.
+   *
+   *  Rows are terminated by -1.
+   */
+  const int compat_sets[][4] = {
+      { OrecLazy,       OrecLazyBackoff,  -1,           -1 },
+      { OrecLazyHour,   OrecLazyHB,       -1,           -1 },
+      { OrecEager,      OrecEagerBackoff, -1,           -1 },
+      { OrecEagerHour,  OrecEagerHB,      -1,           -1 },
+      { NOrec,          NOrecBackoff,     -1,           -1 },
+      { NOrecHour,      NOrecHB,          -1,           -1 },
+      { ByEAUBackoff,   ByEAUNoBackoff,   ByEAUFCM,     -1 },
+      { OrEAUBackoff,   OrEAUNoBackoff,   OrEAUFCM,     -1 }
+  };
+
+  /*** which row of compat_sets holds alg, or -1 */
+  int compat_set_of(int alg)
+  {
+      const int rows = sizeof(compat_sets) / sizeof(compat_sets[0]);
+      for (int r = 0; r < rows; ++r)
+          for (int c = 0; (c < 4) && (compat_sets[r][c] != -1); ++c)
+              if (compat_sets[r][c] == alg)
+                  return r;
+      return -1;
+  }
+
+  /**
+   *  While a draining switch is in progress, threads may be using either the
+   *  old or the new algorithm.  The global rollback and irrevocability
+   *  pointers can't be correct for both, so we install these instead.
+   */
+  scope_t* rollback_draining(STM_ROLLBACK_SIG(tx, except, len))
+  {
+#if defined(STM_ABORT_ON_THROW)
+      return stms[tx->alg].rollback(tx, except, len);
+#else
+      return stms[tx->alg].rollback(tx);
+#endif
+  }
+
+  /*** irrevocability has to wait until the switch is done */
+  bool irrevoc_draining(TxThread*)
+  {
+      return false;
+  }
+} // (anonymous namespace)
+
 namespace stm
 {
+  uint64_t switch_start = 0;
+  switch_histogram_t blocking_switches;
+  switch_histogram_t draining_switches;
+
+  void switch_histogram_t::record(uint64_t ticks)
+  {
+      uint32_t b = 0;
+      while ((b < BUCKETS - 1) && (ticks >> (b + 1)))
+          ++b;
+      ++buckets[b];
+      ++count;
+      total += ticks;
+      if (ticks > max)
+          max = ticks;
+  }
+
+  void switch_histogram_t::dump(const char* name) const
+  {
+      if (!count)
+          return;
+      printf("%s switches: %u, avg = %llu, max = %llu ticks\n", name, count,
+             (unsigned long long)(total / count), (unsigned long long)max);
+      for (uint32_t i = 0; i < BUCKETS; ++i)
+          if (buckets[i])
+              printf("  [2^%u, 2^%u): %u\n", i, i + 1, buckets[i]);
+  }
 
   void install_algorithm_local(int new_alg, TxThread* tx)
   {
       // set my read/write/commit pointers
       tx->tmread     = stms[new_alg].read;
       tx->tmwrite    = stms[new_alg].write;
+      tx->tmread_range  = stms[new_alg].read_range;
+      tx->tmwrite_range = stms[new_alg].write_range;
+      tx->hints      = &stms[new_alg].hints;
       tx->tmcommit   = stms[new_alg].commit;
+      tx->alg        = new_alg;
+  }
+
+  /**
+   *  During a draining switch, every transaction starts here.  If this
+   *  thread's pointers still belong to the old algorithm, we swap them before
+   *  doing anything else.  Since we are not in a transaction yet, nobody else
+   *  can be using them.
+   */
+  bool TM_FASTCALL begin_draining(TxThread* tx)
+  {
+      uint32_t alg = curr_policy.ALG_ID;
+      if (tx->alg != alg) {
+          install_algorithm_local(alg, tx);
+          tx->consec_aborts = 0;
+      }
+      return stms[alg].begin(tx);
+  }
+
+  bool switch_compatible(int old_alg, int new_alg)
+  {
+      if (old_alg == new_alg)
+          return false;
+      int r = compat_set_of(old_alg);
+      return (r != -1) && (r == compat_set_of(new_alg));
+  }
+
+  /**
+   *  A draining switch has three phases.
+   *
+   *  First, we claim tmbegin by installing begin_blocker, exactly as a
+   *  stop-the-world switch would, but we don't wait for anyone.  This
+   *  excludes concurrent switches, irrevocability, and thread creation.  We
+   *  then make the global rollback and irrevocability pointers safe for both
+   *  algorithms, and install begin_draining.  From here on, every new
+   *  transaction uses the new algorithm, while transactions that were
+   *  already running finish with the old one.
+   *
+   *  Second, we wait for every thread that is still in an old-algorithm
+   *  transaction to commit or abort.  New transactions are not delayed.
+   *
+   *  Third, some threads may have been idle for the whole switch and still
+   *  have old pointers.  We briefly install begin_blocker again, so that
+   *  none of them can start, fix their pointers remotely, and then install
+   *  the new algorithm's begin function.  This is the only time we touch
+   *  another thread's pointers, and we never wait for a transaction to
+   *  finish while doing it.
+   *
+   *  NB: we don't call the new algorithm's switcher: the metadata is
+   *      shared, and is already in use by the old algorithm, so it is
+   *      already valid.  Worse, the switchers are written for a quiescent
+   *      system and would race with in-flight commits.
+   */
+  bool drain_algorithm(int new_alg, TxThread* tx)
+  {
+      int old_alg = curr_policy.ALG_ID;
+      if (!bcasptr(&TxThread::tmbegin, stms[old_alg].begin, &begin_blocker))
+          return false;
+      uint64_t start = tick();
+
+      // diagnostic message
+      if (tx)
+          printf("[%u] draining from %s to %s\n", tx->id,
+                 stms[old_alg].name, stms[new_alg].name);
+      if (!stms[new_alg].privatization_safe)
+          printf("Warning: Algorithm %s is not privatization-safe!\n",
+                 stms[new_alg].name);
+
+      // phase 1: let new transactions use the new algorithm
+      TxThread::tmrollback = rollback_draining;
+      TxThread::tmirrevoc  = irrevoc_draining;
+      curr_policy.ALG_ID   = new_alg;
+      if (tx) {
+          install_algorithm_local(new_alg, tx);
+          STM_TRACE(tx, EV_SWITCH, 1, new_alg);
+      }
+      CFENCE;
+      TxThread::tmbegin    = begin_draining;
+      WBR;
+
+      // phase 2: wait for old transactions to finish.  Anyone who read the
+      // old begin function did so after setting scope, so we will see them.
+      for (unsigned i = 0; i < threadcount.val; ++i)
+          while ((threads[i] != tx) && (threads[i]->alg != (uint32_t)new_alg)
+                 && (threads[i]->scope))
+              spin64();
+
+      // phase 3: catch up idle threads, then release tmbegin
+      while (!bcasptr(&TxThread::tmbegin, &begin_draining, &begin_blocker))
+          spin64();
+      for (unsigned i = 0; i < threadcount.val; ++i) {
+          // a thread may be in begin_draining, past the blocker check; it
+          // is about to update its own pointers
+          while ((threads[i]->alg != (uint32_t)new_alg) && (threads[i]->scope))
+              spin64();
+          if (threads[i]->alg != (uint32_t)new_alg)
+              install_algorithm_local(new_alg, threads[i]);
+      }
+      TxThread::tmrollback = stms[new_alg].rollback;
+      TxThread::tmirrevoc  = stms[new_alg].irrevoc;
+      CFENCE;
+      TxThread::tmbegin    = stms[new_alg].begin;
+
+      draining_switches.record(tick() - start);
+      return true;
   }
 
   /**
@@ -66,15 +260,27 @@ namespace stm
       for (unsigned i = 0; i < threadcount.val; ++i) {
           threads[i]->tmread     = stms[new_alg].read;
           threads[i]->tmwrite    = stms[new_alg].write;
+          threads[i]->tmread_range  = stms[new_alg].read_range;
+          threads[i]->tmwrite_range = stms[new_alg].write_range;
+          threads[i]->hints      = &stms[new_alg].hints;
           threads[i]->tmcommit   = stms[new_alg].commit;
+          threads[i]->alg        = new_alg;
           threads[i]->consec_aborts  = 0;
       }
 
       TxThread::tmrollback = stms[new_alg].rollback;
       TxThread::tmirrevoc  = stms[new_alg].irrevoc;
       curr_policy.ALG_ID   = new_alg;
+      if (tx)
+          STM_TRACE(tx, EV_SWITCH, 0, new_alg);
       CFENCE;
       TxThread::tmbegin    = stms[new_alg].begin;
+
+      // record how long the world was stopped
+      if (switch_start) {
+          blocking_switches.record(tick() - switch_start);
+          switch_start = 0;
+      }
   }
 
 } // namespace stm
@@ -15,6 +15,7 @@
 
 #include <stm/config.h>
 #include <common/platform.hpp>
+#include <stm/metadata.hpp>
 
 namespace stm
 {
@@ -27,6 +28,32 @@ namespace stm
   /*** make just this thread use a new algorith (use in ctors) */
   void install_algorithm_local(int new_alg, TxThread* tx);
 
+  /**
+   *  Can transactions using old_alg run concurrently with transactions using
+   *  new_alg?  If so, we can switch between them without stopping the world.
+   */
+  bool switch_compatible(int old_alg, int new_alg);
+
+  /**
+   *  Switch from the current algorithm to a compatible one without blocking
+   *  new transactions while old ones drain.  Returns false if someone else
+   *  is already switching, installing irrevocability, or creating a thread.
+   */
+  bool drain_algorithm(int new_alg, TxThread* tx);
+
+  /**
+   *  Callers of install_algorithm() set this to tick() as soon as they have
+   *  installed begin_blocker, so that install_algorithm() can measure how
+   *  long the world was stopped.
+   */
+  extern uint64_t switch_start;
+
+  /*** latency of stop-the-world switches (begin_blocker until release) */
+  extern switch_histogram_t blocking_switches;
+
+  /*** latency of draining switches (new begin until old txns are done) */
+  extern switch_histogram_t draining_switches;
+
 } // namespace stm
 
 #endif // INST_HPP__
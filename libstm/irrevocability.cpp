@@ -8,6 +8,7 @@
  *          Please see the file LICENSE.RSTM for licensing information
  */
 
+#include <algorithm>              // std::min
 #include "profiling.hpp"         // Trigger
 #include "common/platform.hpp"   // NORETURN, FASTCALL, etc
 #include "stm/lib_globals.hpp"   // AbortHandler
@@ -15,7 +16,6 @@
 #include "stm/txthread.hpp"      // TxThread stuff
 #include "policies/policies.hpp" // curr_policy
 #include "algs/algs.hpp"         // stms
-#include "algs/tml_inline.hpp"
 
 using stm::UNRECOVERABLE;
 using stm::TxThread;
@@ -65,6 +65,9 @@ namespace {
   {
       tx.tmread           = stms[curr_policy.ALG_ID].read;
       tx.tmwrite          = stms[curr_policy.ALG_ID].write;
+      tx.tmread_range     = stms[curr_policy.ALG_ID].read_range;
+      tx.tmwrite_range    = stms[curr_policy.ALG_ID].write_range;
+      tx.hints            = &stms[curr_policy.ALG_ID].hints;
       tx.tmcommit         = stms[curr_policy.ALG_ID].commit;
       tx.tmrollback       = stms[curr_policy.ALG_ID].rollback;
       TxThread::tmirrevoc = stms[curr_policy.ALG_ID].irrevoc;
@@ -89,7 +92,7 @@ namespace {
       //     don't buffer allocations.
       tx->abort_hist.onCommit(tx->consec_aborts);
       tx->consec_aborts = 0;
-      ++tx->num_commits;
+      ++tx->stats.commits;
       Trigger::onCommitSTM(tx);
   }
 
@@ -100,6 +103,9 @@ namespace {
   {
       tx.tmread           = stms[CGL].read;
       tx.tmwrite          = stms[CGL].write;
+      tx.tmread_range     = stms[CGL].read_range;
+      tx.tmwrite_range    = stms[CGL].write_range;
+      tx.hints            = &stms[CGL].hints;
       tx.tmcommit         = commit_irrevocable;
       tx.tmrollback       = rollback_irrevocable;
       TxThread::tmirrevoc = stms[CGL].irrevoc;
@@ -163,7 +169,10 @@ namespace stm
       //  we'll just abort all the time.  The impact should be minimal.
       if (!bcasptr(&TxThread::tmbegin, stms[curr_policy.ALG_ID].begin,
                    &begin_blocker))
+      {
+          tx->abort_cause = ABORT_SWITCH;
           tx->tmabort(tx);
+      }
 
       // wait for everyone to be out of a transaction (scope == NULL)
       for (unsigned i = 0; i < threadcount.val; ++i)
@@ -177,6 +186,7 @@ namespace stm
       if (tx->irrevocable) {
           tx->allocator.onTxCommit();    // tell the allocator do cleanup
           set_irrevocable_barriers(*tx);
+          STM_TRACE(tx, EV_IRREVOC, 0, 0);
           return;
       }
 
@@ -190,6 +200,7 @@ namespace stm
       // begin_blocker sets our barriers to be irrevocable if we have our
       // irrevocable flag set.
       tx->irrevocable = true;
+      tx->abort_cause = ABORT_IRREVOC;
       tx->tmabort(tx);
   }
 
@@ -222,9 +233,14 @@ namespace stm
       //     transactions don't buffer allocation.
       if (tx->irrevocable) {
           set_irrevocable_barriers(*tx);
+          STM_TRACE(tx, EV_IRREVOC, 1, 0);
           return true;
       }
 
+#ifdef STM_EVENT_TRACE_YES
+      uint64_t blocked_at = tick();
+#endif
+
       // adapt without longjmp
       while (true) {
           // first, clear the outer scope, because it's our 'tx/nontx' flag
@@ -245,8 +261,12 @@ namespace stm
           // if begin_blocker is no longer installed, we can call the pointer
           // to start a transaction, and then return.  Otherwise, we missed our
           // window, so we need to go back to the top of the loop.
-          if (beginner != begin_blocker)
+          if (beginner != begin_blocker) {
+              STM_TRACE(tx, EV_BLOCKED, 0,
+                        (uint32_t)std::min<uint64_t>(tick() - blocked_at,
+                                                     UINT32_MAX));
               return beginner(tx);
+          }
       }
   }
 }
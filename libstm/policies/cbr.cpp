@@ -69,14 +69,7 @@ namespace
   TM_FASTCALL uint32_t profile_nochange()
   {
       // compute the read-only ratio
-      uint32_t ropct = 0;
-      uint32_t txns = 0;
-      uint32_t rotxns = 0;
-      for (uint32_t i = 0; i < threadcount.val; ++i) {
-          txns += threads[i]->num_commits;
-          rotxns += threads[i]->num_ro;
-      }
-      ropct = (100*rotxns)/(txns + rotxns);
+      uint32_t ropct = get_ro_pct();
 
       // we have some profiles sitting around: use them with the NN code
       dynprof_t summary_profile;
@@ -670,10 +663,18 @@ namespace
       int32_t  thrcount  = threadcount.val; // cache val since it is volatile
       uint32_t best_alg  = 0;               // our choice of algorithm
       int32_t  distance  = 0x7FFFFFFF;     // distance metric
+
+      // if the qtable wasn't trained at this thread count, use the nearest
+      // one that was.  Without a qtable, we keep the algorithm we had.
+      MiniVector<qtable_t>* tbl = get_qtable(thrcount);
+      if (tbl == NULL)
+          return (curr_policy.ALG_ID == ProfileTM)
+              ? curr_policy.PREPROFILE_ALG : curr_policy.ALG_ID;
+
       // go through the qtable, check each row
-      foreach (MiniVector<qtable_t>, i, (*qtbl[thrcount])) {
+      foreach (MiniVector<qtable_t>, i, (*tbl)) {
           // we no longer have to check if the thread count matches as the
-          // qtable we are using is sure to have only entries for the correct
+          // qtable we are using is sure to have only entries for a single
           // thread count
 
           int32_t metric_val = 0xFFFFFFFF;
@@ -697,14 +698,8 @@ namespace
   TM_FASTCALL uint32_t pol_CBR_RO()
   {
       // compute the read-only ratio
-      uint32_t txns = 0, rotxns = 0;
       qtable_t q;
-      for (uint32_t i = 0; i < threadcount.val; ++i) {
-          txns += threads[i]->num_commits;
-          rotxns += threads[i]->num_ro;
-      }
-
-      q.pct_ro = (100*rotxns)/(txns + rotxns);
+      q.pct_ro = get_ro_pct();
       return cbr_tail<RO>(q);
   }
 
@@ -720,15 +715,8 @@ namespace
       // Eliminator will handle this, so we use some template stuff to guide
       // when the code runs.
       qtable_t q;
-      if (C::uses_RO()) {
-          uint32_t txns = 0;
-          uint32_t rotxns = 0;
-          for (uint32_t i = 0; i < threadcount.val; ++i) {
-              txns += threads[i]->num_commits;
-              rotxns += threads[i]->num_ro;
-          }
-          q.pct_ro = (100*rotxns)/(txns + rotxns);
-      }
+      if (C::uses_RO())
+          q.pct_ro = get_ro_pct();
 
       // Average all the profiles we've collected
       dynprof_t::doavg(q.p, profiles, profile_txns);
@@ -96,6 +96,34 @@ namespace
       std::cout << "Qtable Initialization:  loaded " << count << " lines from "
                 << qstr << std::endl;
   }
+
+  /**
+   *  Figure out the thread counts at which a newly created thread should ask
+   *  the current policy to reselect an algorithm.
+   *
+   *  The STM_THREADTRIGGER environment variable holds a comma-separated list
+   *  of thread counts (e.g., "4,8,16,32,64").  If it is not set, we trigger
+   *  at every thread count for which the qtable has rows, since those are the
+   *  points at which a CBR policy can actually make a different decision.
+   */
+  void init_thread_triggers()
+  {
+      char* tstr = getenv("STM_THREADTRIGGER");
+      if (tstr == NULL) {
+          for (unsigned i = 0; i <= MAX_THREADS; ++i)
+              thread_triggers[i] = (qtbl[i] != NULL);
+          return;
+      }
+      while (*tstr) {
+          char* end;
+          unsigned long thr = strtoul(tstr, &end, 10);
+          if (end == tstr)
+              UNRECOVERABLE("Invalid STM_THREADTRIGGER string");
+          if (thr <= MAX_THREADS)
+              thread_triggers[thr] = true;
+          tstr = (*end == ',') ? end + 1 : end;
+      }
+  }
 } // namespace {}
 
 namespace stm
@@ -110,6 +138,25 @@ namespace stm
   /*** the qtable for CBR policies */
   MiniVector<qtable_t>* qtbl[MAX_THREADS+1]  = {NULL};
 
+  /*** the thread counts that trigger a reselection */
+  bool thread_triggers[MAX_THREADS+1] = {false};
+
+  /*** find the qtable for the nearest trained thread count */
+  MiniVector<qtable_t>* get_qtable(uint32_t thr)
+  {
+      if (thr > MAX_THREADS)
+          thr = MAX_THREADS;
+      // prefer the largest trained thread count that is <= thr
+      for (int i = thr; i >= 0; --i)
+          if (qtbl[i] != NULL)
+              return qtbl[i];
+      // otherwise use the smallest trained thread count
+      for (unsigned i = thr + 1; i <= MAX_THREADS; ++i)
+          if (qtbl[i] != NULL)
+              return qtbl[i];
+      return NULL;
+  }
+
   /*** Use the policies array to map a string name to a policy ID */
   int pol_name_map(const char* phasename)
   {
@@ -155,6 +202,9 @@ namespace stm
       char* qstr = getenv("STM_QTABLE");
       if (qstr != NULL)
           load_qtable(qstr);
+
+      // the thread-count trigger defaults depend on the qtable
+      init_thread_triggers();
   }
 
 } // namespace stm
@@ -276,25 +276,39 @@ namespace stm
   extern pol_t                 pols[POL_MAX];       // describe all policies
   extern MiniVector<qtable_t>* qtbl[MAX_THREADS+1]; // hold the CBR data
   extern behavior_t            curr_policy;         // the current STM alg
+  extern bool thread_triggers[MAX_THREADS+1];       // reselect at these counts
 
   /**
-   *  Helper function.  This is a terrible thing, and one we must get rid of,
-   *  especially since we are calling it far more often than we should!
+   *  The qtable only has rows for the thread counts at which it was trained.
+   *  This returns the table for the closest trained thread count that does
+   *  not exceed thr (or the smallest one, if thr is below all of them), or
+   *  NULL if no qtable was loaded.
    */
+  MiniVector<qtable_t>* get_qtable(uint32_t thr);
+
+  /**
+   *  The policies don't walk the TxThreads to read counters.  Instead, they
+   *  use this snapshot, which is re-aggregated from the per-thread stats
+   *  blocks whenever it is more than a few million ticks old (stats.cpp).
+   */
+  const stats_t& get_aggregate_stats();
+
+  /*** estimate the global nontx time per transaction */
   TM_INLINE
   inline unsigned long long get_nontxtime()
   {
-      // extimate the global nontx time per transaction
-      uint32_t commits = 1;
-      unsigned long long nontxn_time = 0;
-      for (unsigned z = 0; z < threadcount.val; z++){
-          nontxn_time += threads[z]->total_nontxn_time;
-          commits += threads[z]->num_commits;
-          commits += threads[z]->num_ro;
-      }
-      commits += !commits; // if commits is 0, make it 1, without control flow
-      unsigned long long ans = 1 + (nontxn_time / commits);
-      return ans;
+      const stats_t& s = get_aggregate_stats();
+      uint64_t commits = 1 + s.commits + s.ro_commits;
+      return 1 + (s.nontx_time / commits);
+  }
+
+  /*** percentage of commits that were read-only */
+  TM_INLINE
+  inline uint32_t get_ro_pct()
+  {
+      const stats_t& s = get_aggregate_stats();
+      uint64_t txns = s.commits + s.ro_commits;
+      return txns ? (100 * s.ro_commits) / txns : 0;
   }
 
   /*** used in the policies impementations to register policies */
@@ -47,6 +47,13 @@ namespace
       }
   }
 
+  /**
+   *  set_policy sets this when it takes over from ProfileTM, so that the
+   *  transaction that completes the profile doesn't wait to switch
+   *  algorithms itself.
+   */
+  volatile bool profile_cancelled = false;
+
   /**
    *  Collecting profiles is a lot like changing algorithms, but there are a
    *  few customizations we make to address the probing.
@@ -57,6 +64,7 @@ namespace
       if (!bcasptr(&TxThread::tmbegin, stms[curr_policy.ALG_ID].begin,
                    &begin_blocker))
           return;
+      switch_start = tick();
 
       // wait for everyone to be out of a transaction (scope == NULL)
       for (unsigned i = 0; i < threadcount.val; ++i)
@@ -67,6 +75,7 @@ namespace
       curr_policy.PREPROFILE_ALG = curr_policy.ALG_ID;
 
       // install ProfileTM
+      profile_cancelled = false;
       install_algorithm(ProfileTM, tx);
   }
 
@@ -76,15 +85,27 @@ namespace
    */
   void change_algorithm(TxThread* tx, unsigned new_algorithm)
   {
-      // NB: we could compare new_algorithm to curr_policy.ALG_ID, and if
-      //     they were the same, then we could just adjust the thresholds
-      //     without doing any other work.  For now, we ignore that
-      //     optimization
+      // keeping the current algorithm only needs the thresholds adjusted,
+      // not a switch
+      if (new_algorithm == curr_policy.ALG_ID) {
+          adjust_thresholds(new_algorithm, new_algorithm);
+          return;
+      }
+
+      // if both algorithms can run at the same time, there's no need to
+      // stop the world
+      uint32_t old_algorithm = curr_policy.ALG_ID;
+      if (switch_compatible(old_algorithm, new_algorithm)) {
+          if (drain_algorithm(new_algorithm, tx))
+              adjust_thresholds(new_algorithm, old_algorithm);
+          return;
+      }
 
       // prevent new txns from starting
       if (!bcasptr(&TxThread::tmbegin, stms[curr_policy.ALG_ID].begin,
                    &begin_blocker))
           return;
+      switch_start = tick();
 
       // wait for everyone to be out of a transaction (scope == NULL)
       for (unsigned i = 0; i < threadcount.val; ++i)
@@ -98,6 +119,161 @@ namespace
       install_algorithm(new_algorithm, tx);
   }
 
+  /**
+   *  Per-thread state for the sampling profiler.  While a transaction is
+   *  sampled, its per-thread read/write/commit pointers are the wrappers
+   *  below, and the algorithm's own pointers are kept here.
+   */
+  struct sample_t
+  {
+      ReadBarrier   read;     // the algorithm's read barrier
+      WriteBarrier  write;    // the algorithm's write barrier
+      CommitBarrier commit;   // the algorithm's commit barrier
+      ReadRangeBarrier  read_range;  // the algorithm's range barriers, which
+      WriteRangeBarrier write_range; //   would bypass the wrappers
+      const barrier_hints_t* hints;  // the algorithm's hints, ditto
+      uint32_t      alg;      // the algorithm the saved pointers belong to
+      bool          wrapped;  // are the range/hints pointers saved above?
+      dynprof_t     prof;     // counts for the current sample
+      WriteSet*     writes;   // addresses written by the current sample
+      uint32_t      skipped;  // txns since the last sample
+      bool          committing; // did we reach the wrapped commit?
+  } TM_ALIGN(64);
+
+  sample_t samples[MAX_THREADS];
+
+  /*** ticket for profiles[] slots, and count of slots filled */
+  pad_word_t sample_slot = {0};
+  pad_word_t sample_done = {0};
+
+  TM_FASTCALL void* sample_read(STM_READ_SIG(,,));
+  TM_FASTCALL void sample_write(STM_WRITE_SIG(,,,));
+  TM_FASTCALL void sample_commit(TxThread*);
+
+  /**
+   *  The algorithm changes the per-thread pointers on its own (e.g., on the
+   *  first write).  When it does, remember the new pointers and put the
+   *  wrappers back.
+   */
+  inline void sample_rewrap(TxThread* tx, sample_t& s)
+  {
+      if (tx->tmread != sample_read) {
+          s.read = tx->tmread;
+          tx->tmread = sample_read;
+      }
+      if (tx->tmwrite != sample_write) {
+          s.write = tx->tmwrite;
+          tx->tmwrite = sample_write;
+      }
+      if (tx->tmcommit != sample_commit) {
+          s.commit = tx->tmcommit;
+          tx->tmcommit = sample_commit;
+      }
+  }
+
+  /*** start (or restart) a sample with the current pointers */
+  void sample_arm(TxThread* tx, sample_t& s)
+  {
+      if (!s.writes)
+          s.writes = new WriteSet(64);
+      s.writes->reset();
+      s.prof.clear();
+      s.committing = false;
+      sample_rewrap(tx, s);
+      // if we are re-arming after an abort, the ranges may already be
+      // wrapped; unless a switch installed new pointers in the meantime,
+      // the saved ones are still right
+      if (!s.wrapped || (s.alg != tx->alg)) {
+          s.read_range  = tx->tmread_range;
+          s.write_range = tx->tmwrite_range;
+          s.hints       = tx->hints;
+          s.alg         = tx->alg;
+          s.wrapped     = true;
+      }
+      tx->tmread_range  = read_range_words;
+      tx->tmwrite_range = write_range_words;
+      tx->hints         = &no_hints;
+      sample_active[tx->id-1].val = 1;
+  }
+
+  /*** stop sampling, and give the algorithm back its pointers */
+  void sample_disarm(TxThread* tx, sample_t& s)
+  {
+      if (tx->tmread == sample_read)
+          tx->tmread = s.read;
+      if (tx->tmwrite == sample_write)
+          tx->tmwrite = s.write;
+      if (tx->tmcommit == sample_commit)
+          tx->tmcommit = s.commit;
+      // NB: after a switch, install_algorithm has already given us the new
+      //     algorithm's pointers, which may well be read_range_words or
+      //     no_hints; the saved ones belong to the old algorithm
+      if (s.wrapped && (s.alg == tx->alg)) {
+          tx->tmread_range  = s.read_range;
+          tx->tmwrite_range = s.write_range;
+          tx->hints         = s.hints;
+      }
+      s.wrapped = false;
+      sample_active[tx->id-1].val = 0;
+  }
+
+  /**
+   *  Count a read.  Like ProfileTM, we classify reads by whether the
+   *  transaction has written yet, and by whether they hit in the write log.
+   *
+   *  NB: the transaction's duration is measured from its first barrier,
+   *      since we don't wrap begin.
+   */
+  void* sample_read(STM_READ_SIG(tx,addr,mask))
+  {
+      sample_t& s = samples[tx->id-1];
+      if (!s.prof.txn_time)
+          s.prof.txn_time = tick();
+      if (!s.writes->size()) {
+          ++s.prof.read_ro;
+      }
+      else {
+          WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
+          if (s.writes->find(log))
+              ++s.prof.read_rw_raw;
+          else
+              ++s.prof.read_rw_nonraw;
+      }
+      void* val = s.read(tx, addr STM_MASK(mask));
+      sample_rewrap(tx, s);
+      return val;
+  }
+
+  /*** Count a write, and whether it is to a location we already wrote */
+  void sample_write(STM_WRITE_SIG(tx,addr,val,mask))
+  {
+      sample_t& s = samples[tx->id-1];
+      if (!s.prof.txn_time)
+          s.prof.txn_time = tick();
+      WriteSetEntry log(STM_WRITE_SET_ENTRY(addr, NULL, mask));
+      if (s.writes->find(log)) {
+          ++s.prof.write_waw;
+      }
+      else {
+          ++s.prof.write_nonwaw;
+          s.writes->insert(WriteSetEntry(STM_WRITE_SET_ENTRY(addr, val, mask)));
+      }
+      s.write(tx, addr, val STM_MASK(mask));
+      sample_rewrap(tx, s);
+  }
+
+  /**
+   *  Note that the sample reached commit.  If the commit succeeds, the
+   *  algorithm's commit hook finishes the sample.
+   */
+  void sample_commit(TxThread* tx)
+  {
+      sample_t& s = samples[tx->id-1];
+      if (!s.prof.txn_time)
+          s.prof.txn_time = tick();
+      s.committing = true;
+      s.commit(tx);
+  }
 } // (anonymous namespace)
 
 namespace stm
@@ -127,9 +303,13 @@ namespace stm
       while (!bcasptr(&TxThread::tmbegin, stms[curr_policy.ALG_ID].begin,
                       &begin_blocker))
       {
+          // set_policy has cancelled the profile, and is waiting for us to
+          // finish
+          if (profile_cancelled)
+              return;
           spin64();
       }
-
+      switch_start = tick();
 
       // Use the policy to decide what algorithm to switch to
       uint32_t new_algorithm = pols[curr_policy.POL_ID].decider();
@@ -141,11 +321,82 @@ namespace stm
       install_algorithm(new_algorithm, tx);
   }
 
+  bool cancel_profile()
+  {
+      if (!bcasptr(&TxThread::tmbegin, stms[ProfileTM].begin, &begin_blocker))
+          return false;
+      profile_cancelled = true;
+      return true;
+  }
+
+  uint32_t   sample_period = 0;
+  pad_word_t sample_request = {0};
+  pad_word_t sample_active[MAX_THREADS] = {{0}};
+
+  void sample_oncommit(TxThread* tx)
+  {
+      sample_t& s = samples[tx->id-1];
+
+      // finish the sample that just committed
+      if (sample_active[tx->id-1].val) {
+          sample_disarm(tx, s);
+          if (!s.committing || !sample_request.val)
+              return;
+          s.prof.txn_time = tick() - s.prof.txn_time;
+
+          // claim a slot; if the set is already full, drop the sample
+          uintptr_t slot = faiptr(&sample_slot.val);
+          if (slot >= profile_txns)
+              return;
+          profiles[slot] = s.prof;
+          WBR;
+          if (faiptr(&sample_done.val) + 1 != profile_txns)
+              return;
+
+          // we have a full set of profiles: stop sampling, and pick an
+          // algorithm just like profile_oncomplete does.  set_policy may
+          // have installed a non-adaptive policy while we were sampling.
+          sample_request.val = 0;
+          uint32_t new_algorithm = curr_policy.ALG_ID;
+          if (pols[curr_policy.POL_ID].decider)
+              new_algorithm = pols[curr_policy.POL_ID].decider();
+          sample_slot.val = 0;
+          sample_done.val = 0;
+          change_algorithm(tx, new_algorithm);
+          return;
+      }
+
+      // sample one in every sample_period transactions
+      if (++s.skipped < sample_period)
+          return;
+      s.skipped = 0;
+      sample_arm(tx, s);
+  }
+
+  void sample_onabort(TxThread* tx)
+  {
+      // keep sampling the retry, otherwise transactions that abort a lot
+      // would never be sampled
+      sample_t& s = samples[tx->id-1];
+      if (sample_request.val)
+          sample_arm(tx, s);
+      else
+          sample_disarm(tx, s);
+  }
+
   void trigger_common(TxThread* tx)
   {
-      // if we're dynamic, ask for profiles to be requested and then return
+      // if we're dynamic, ask for profiles to be requested and then return.
+      // With sampling, this just tells every thread to start sampling.
       if (pols[curr_policy.POL_ID].isDynamic) {
-          collect_profiles(tx);
+          if (!sample_period) {
+              collect_profiles(tx);
+          }
+          else if (!sample_request.val) {
+              curr_policy.PREPROFILE_ALG = curr_policy.ALG_ID;
+              WBR;
+              sample_request.val = 1;
+          }
           return;
       }
       // if we're static, run the policy-specific code to decide what to do.
@@ -154,5 +405,30 @@ namespace stm
       uint32_t new_algorithm = pols[curr_policy.POL_ID].decider();
       change_algorithm(tx, new_algorithm);
   }
+
+  void thread_count_trigger(TxThread* tx)
+  {
+      // a non-adaptive policy can't do anything about the new thread
+      if (!pols[curr_policy.POL_ID].decider)
+          return;
+      // only reselect when we reach one of the configured thread counts.
+      // Only the TxThread constructor writes threadcount.val, so our id is
+      // the thread count that we just created.
+      if (!thread_triggers[tx->id])
+          return;
+      // if someone is already collecting profiles, the decision that follows
+      // will see the new thread count anyway
+      if (curr_policy.ALG_ID == ProfileTM)
+          return;
+
+      // NB: collect_profiles and change_algorithm give up if they can't
+      //     install begin_blocker, so wait for any concurrent thread
+      //     creation or mode switch to finish first.  This is best-effort:
+      //     if we lose a race anyway, the next threshold will catch up.
+      while (TxThread::tmbegin == begin_blocker)
+          spin64();
+      curr_policy.abort_switch = false;
+      trigger_common(tx);
+  }
 } // namespace stm
 
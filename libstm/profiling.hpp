@@ -33,6 +33,14 @@ namespace stm
   /*** After profiles are collected, select and install a new algorithm */
   void profile_oncomplete(TxThread* tx);
 
+  /**
+   *  Stop a pending ProfileTM profile, for set_policy.  Returns false if
+   *  ProfileTM is not installed (or a switch is under way).  On success,
+   *  begin_blocker is installed, the transactions that already got a profile
+   *  slot are left to finish, and the caller installs the next algorithm.
+   */
+  bool cancel_profile();
+
   /**
    * custom begin method that blocks the starting thread, in order to get
    * rendezvous correct during mode switching and GRL irrevocability
@@ -41,6 +49,13 @@ namespace stm
    */
   bool begin_blocker(TxThread* tx) TM_FASTCALL;
 
+  /**
+   *  custom begin method used while switching between two algorithms that
+   *  can run concurrently; it moves the starting thread to the new algorithm
+   *  (implemented in inst.cpp)
+   */
+  bool begin_draining(TxThread* tx) TM_FASTCALL;
+
   /**
    *  This is the code for deciding whether to adapt or not.  It's a little bit
    *  messy because we want to limit what gets inlined.
@@ -53,6 +68,14 @@ namespace stm
 
   void trigger_common(TxThread* tx) TM_FASTCALL NOINLINE;
 
+  /**
+   *  Thread creation can change the best algorithm just as much as a change
+   *  in workload can.  A new TxThread calls this once it is fully set up and
+   *  has released begin_blocker; if the new thread count is one of the
+   *  configured thresholds, we ask the current policy to reselect.
+   */
+  void thread_count_trigger(TxThread* tx) NOINLINE;
+
   /**
    *  A simple trigger: request collection of profiles after 16 consecutive
    *  aborts, or on a begin-time wait of >=2048
@@ -143,7 +166,7 @@ namespace stm
           if (tx->id != 2)
               return;
           // return if not a trigger commit number
-          unsigned c = tx->num_ro + tx->num_commits;
+          unsigned c = tx->stats.ro_commits + tx->stats.commits;
           if (c != next)
               return;
           // update the trigger commit number
@@ -171,6 +194,48 @@ namespace stm
       static void onAbort(TxThread* tx) { AbortWaitTrigger::onAbort(tx); }
   };
 
+  /**
+   *  The sampling profiler is an alternative to ProfileTM.  Instead of
+   *  stopping the world and running profile_txns transactions serially, we
+   *  let every thread keep running the current algorithm, and each thread
+   *  wraps one in every sample_period of its transactions with counting
+   *  barriers.  When profile_txns samples have committed, we call the
+   *  policy's decider just as profile_oncomplete would.
+   *
+   *  sample_period == 0 (the default) means we use ProfileTM.
+   */
+  extern uint32_t   sample_period;
+  extern pad_word_t sample_request;              // nonzero while sampling
+  extern pad_word_t sample_active[MAX_THREADS];  // is my txn being sampled?
+
+  /*** start/finish a sample from a commit hook */
+  void sample_oncommit(TxThread* tx) NOINLINE;
+
+  /*** restart the sample when a sampled transaction aborts */
+  void sample_onabort(TxThread* tx) NOINLINE;
+
+  /**
+   *  The part of the sampling profiler that gets inlined into the commit and
+   *  rollback hooks.  When we aren't sampling, this costs a read of a shared
+   *  word that nobody writes, and of a word that only we write.
+   */
+  struct Sampler
+  {
+      TM_INLINE
+      static void onCommit(TxThread* tx)
+      {
+          if (sample_request.val || sample_active[tx->id-1].val)
+              sample_oncommit(tx);
+      }
+
+      TM_INLINE
+      static void onAbort(TxThread* tx)
+      {
+          if (sample_active[tx->id-1].val)
+              sample_onabort(tx);
+      }
+  };
+
 #ifdef STM_PROFILETMTRIGGER_ALL
   typedef CommitTrigger Trigger;
 #elif defined(STM_PROFILETMTRIGGER_PATHOLOGY)
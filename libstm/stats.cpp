@@ -0,0 +1,125 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  Statistics aggregation.  Each TxThread counts its own commits, aborts,
+ *  and time in a padded tx_stats_t.  The code in this file sums those
+ *  counters, either on demand (get_stats) or at most once per STATS_PERIOD
+ *  (get_aggregate_stats, which the adaptivity policies use).
+ */
+
+#include <cstdio>
+#include <stm/txthread.hpp>
+#include <stm/lib_globals.hpp>
+#include "policies/policies.hpp"
+#include "inst.hpp"
+
+using namespace stm;
+
+namespace
+{
+  /*** how stale (in ticks) the policies' view of the stats may be */
+  const uint64_t STATS_PERIOD = 1ull << 22;
+
+  /**
+   *  We keep two snapshots.  Readers use the one named by 'current', and
+   *  the (single) aggregator fills in the other one and then flips
+   *  'current'.
+   */
+  stats_t    snapshots[2];
+  pad_word_t current     = {0};
+  pad_word_t aggregating = {0};
+
+  /*** names for the abort_cause_t values */
+  const char* cause_names[ABORT_CAUSES] = {
+      "conflict", "validation", "locked", "too_new", "ring", "killed",
+      "switch", "restart", "irrevoc"
+  };
+
+  /*** sum the per-thread counters into s */
+  void sum_stats(stats_t& s)
+  {
+      s.commits = s.ro_commits = s.restarts = s.aborts = 0;
+      s.tx_time = s.nontx_time = 0;
+      s.latency.clear();
+      s.attempts.clear();
+      for (int c = 0; c < ABORT_CAUSES; ++c)
+          s.aborts_by_cause[c] = 0;
+
+      s.threads = threadcount.val;
+      for (uint32_t i = 0; i < s.threads; ++i) {
+          const tx_stats_t& t = threads[i]->stats;
+          s.commits    += t.commits;
+          s.ro_commits += t.ro_commits;
+          s.restarts   += t.restarts;
+          for (int c = 0; c < ABORT_CAUSES; ++c)
+              s.aborts_by_cause[c] += t.aborts[c];
+          s.tx_time    += t.tx_time;
+          s.nontx_time += t.nontx_time;
+#ifdef STM_LATENCY_HISTOGRAM_YES
+          s.latency.merge(t.latency);
+          s.attempts.merge(t.attempts);
+#endif
+      }
+      for (int c = 0; c < ABORT_CAUSES; ++c)
+          s.aborts += s.aborts_by_cause[c];
+      s.blocking_switches = blocking_switches;
+      s.draining_switches = draining_switches;
+      s.when = tick();
+  }
+} // (anonymous namespace)
+
+namespace stm
+{
+  stats_t get_stats()
+  {
+      stats_t s;
+      sum_stats(s);
+      return s;
+  }
+
+  const stats_t& get_aggregate_stats()
+  {
+      const stats_t& cur = snapshots[current.val];
+      if (tick() - cur.when < STATS_PERIOD)
+          return cur;
+
+      // if someone else is already refreshing, their result will be
+      // almost as stale as ours
+      if (!bcasptr(&aggregating.val, 0ul, 1ul))
+          return cur;
+      uintptr_t next = 1 - current.val;
+      sum_stats(snapshots[next]);
+      WBR;
+      current.val = next;
+      CFENCE;
+      aggregating.val = 0;
+      return snapshots[next];
+  }
+
+  void latency_hist_t::dump(const char* name) const
+  {
+      if (!count)
+          return;
+      printf("%s: n = %llu, p50 = %llu, p90 = %llu, p99 = %llu, "
+             "p99.9 = %llu, max = %llu\n", name,
+             (unsigned long long)count,
+             (unsigned long long)percentile(50),
+             (unsigned long long)percentile(90),
+             (unsigned long long)percentile(99),
+             (unsigned long long)percentile(99.9),
+             (unsigned long long)max);
+  }
+
+  const char* abort_cause_name(uint32_t cause)
+  {
+      return (cause < ABORT_CAUSES) ? cause_names[cause] : "unknown";
+  }
+} // namespace stm
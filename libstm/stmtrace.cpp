@@ -0,0 +1,316 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  stmtrace: read a trace written by a libstm built with
+ *  libstm_enable_event_trace, and report
+ *
+ *    - per-thread summaries (commits, aborts by cause, time blocked)
+ *    - conflict chains: who aborted whom, and the longest sequences of
+ *      threads aborting each other (requires conflict attribution)
+ *    - switch stalls: every algorithm switch, and the longest waits in
+ *      begin_blocker
+ *    - optionally (-t), the merged timeline of every event
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <stm/trace.hpp>
+#include <stm/lib_globals.hpp>
+
+using namespace stm;
+
+namespace
+{
+  /*** an event, along with the thread that recorded it */
+  struct event_t
+  {
+      uint32_t      thread;
+      trace_event_t e;
+  };
+
+  bool earlier(const event_t& a, const event_t& b)
+  {
+      return a.e.when < b.e.when;
+  }
+
+  bool longer_block(const event_t& a, const event_t& b)
+  {
+      return a.e.arg > b.e.arg;
+  }
+
+  /*** a chain's length, and the index in all[] of the abort it starts at */
+  typedef std::pair<size_t, size_t> chain_t;
+
+  bool longer_chain(const chain_t& a, const chain_t& b)
+  {
+      return a.first > b.first;
+  }
+
+  std::vector<std::string>           algs;
+  std::vector<trace_thread_t>        thread_info;
+  std::vector<std::vector<event_t> > by_thread;
+  std::vector<event_t>               all;
+
+  const char* alg_name(uint32_t a)
+  {
+      return (a < algs.size()) ? algs[a].c_str() : "?";
+  }
+
+  void usage()
+  {
+      printf("Usage: stmtrace [-t] [-n top] tracefile\n");
+      printf("    -t     print the merged timeline of every event\n");
+      printf("    -n     how many chains/stalls to list (default 10)\n");
+      exit(1);
+  }
+
+  void load(const char* file)
+  {
+      FILE* f = fopen(file, "rb");
+      if (!f) {
+          perror(file);
+          exit(1);
+      }
+      trace_header_t h;
+      if ((fread(&h, sizeof(h), 1, f) != 1) ||
+          memcmp(h.magic, TRACE_MAGIC, sizeof(h.magic)))
+      {
+          fprintf(stderr, "%s is not an RSTM trace\n", file);
+          exit(1);
+      }
+      for (uint32_t a = 0; a < h.algs; ++a) {
+          char name[TRACE_NAME_LEN + 1] = {0};
+          if (fread(name, TRACE_NAME_LEN, 1, f) != 1)
+              break;
+          algs.push_back(name);
+      }
+      for (uint32_t i = 0; i < h.threads; ++i) {
+          trace_thread_t t;
+          if (fread(&t, sizeof(t), 1, f) != 1)
+              break;
+          thread_info.push_back(t);
+          by_thread.push_back(std::vector<event_t>());
+          for (uint64_t n = 0; n < t.events; ++n) {
+              event_t ev;
+              ev.thread = t.id;
+              if (fread(&ev.e, sizeof(ev.e), 1, f) != 1)
+                  break;
+              by_thread.back().push_back(ev);
+              all.push_back(ev);
+          }
+      }
+      fclose(f);
+      std::stable_sort(all.begin(), all.end(), earlier);
+  }
+
+  void describe(const event_t& ev, uint64_t origin)
+  {
+      printf("%14llu  T%-3u ", (unsigned long long)(ev.e.when - origin),
+             ev.thread);
+      switch (ev.e.type) {
+        case EV_BEGIN:   printf("begin\n"); break;
+        case EV_COMMIT:  printf("commit (%u attempts)\n", ev.e.arg); break;
+        case EV_ABORT:
+          printf("abort: %s", abort_cause_name(ev.e.code));
+          if (ev.e.arg)
+              printf(" (by T%u)", ev.e.arg);
+          printf("\n");
+          break;
+        case EV_IRREVOC: printf("irrevocable\n"); break;
+        case EV_SWITCH:
+          printf("%s switch to %s\n", ev.e.code ? "draining" : "blocking",
+                 alg_name(ev.e.arg));
+          break;
+        case EV_BLOCKED: printf("blocked %u ticks\n", ev.e.arg); break;
+        default:         printf("unknown event %u\n", ev.e.type);
+      }
+  }
+
+  void summarize()
+  {
+      printf("Per-thread summary:\n");
+      for (size_t i = 0; i < by_thread.size(); ++i) {
+          uint64_t commits = 0, aborts = 0, blocked = 0, irrevoc = 0;
+          std::map<uint32_t, uint64_t> causes;
+          for (size_t j = 0; j < by_thread[i].size(); ++j) {
+              const trace_event_t& e = by_thread[i][j].e;
+              if (e.type == EV_COMMIT)  ++commits;
+              if (e.type == EV_IRREVOC) ++irrevoc;
+              if (e.type == EV_BLOCKED) blocked += e.arg;
+              if (e.type == EV_ABORT) {
+                  ++aborts;
+                  ++causes[e.code];
+              }
+          }
+          printf("  T%-3u %llu events (%llu dropped), %llu commits, "
+                 "%llu aborts, %llu irrevoc, %llu ticks blocked\n",
+                 thread_info[i].id,
+                 (unsigned long long)thread_info[i].events,
+                 (unsigned long long)thread_info[i].dropped,
+                 (unsigned long long)commits, (unsigned long long)aborts,
+                 (unsigned long long)irrevoc, (unsigned long long)blocked);
+          if (!causes.empty()) {
+              printf("       aborts:");
+              for (std::map<uint32_t, uint64_t>::iterator c = causes.begin();
+                   c != causes.end(); ++c)
+                  printf(" %s=%llu", abort_cause_name(c->first),
+                         (unsigned long long)c->second);
+              printf("\n");
+          }
+      }
+  }
+
+  /*** each thread's attributed aborts, in time order */
+  std::map<uint32_t, std::vector<event_t> > attributed;
+
+  /**
+   *  Starting from an abort that names its owner, follow the owner's most
+   *  recent attributed abort before that time, and so on, stopping at 16
+   *  links or when we come back to the first thread.
+   */
+  void walk(const event_t& start, std::vector<event_t>& chain)
+  {
+      chain.assign(1, start);
+      while (chain.size() < 16) {
+          event_t last = chain.back();
+          std::vector<event_t>& prev = attributed[last.e.arg];
+          std::vector<event_t>::iterator it =
+              std::lower_bound(prev.begin(), prev.end(), last, earlier);
+          if (it == prev.begin())
+              break;
+          --it;
+          if (it->thread == start.thread)
+              break;
+          chain.push_back(*it);
+      }
+  }
+
+  /**
+   *  Report who aborts whom, and the longest chains of aborts.  Long chains
+   *  mean that aborts are cascading rather than being isolated conflicts.
+   */
+  void chains(unsigned top)
+  {
+      std::map<std::pair<uint32_t, uint32_t>, uint64_t> pairs;
+      for (size_t i = 0; i < all.size(); ++i) {
+          if ((all[i].e.type == EV_ABORT) && all[i].e.arg) {
+              attributed[all[i].thread].push_back(all[i]);
+              ++pairs[std::make_pair(all[i].thread, all[i].e.arg)];
+          }
+      }
+      if (pairs.empty()) {
+          printf("No attributed aborts (build with "
+                 "libstm_enable_conflict_attribution for conflict chains)\n");
+          return;
+      }
+
+      std::vector<std::pair<uint64_t, std::pair<uint32_t, uint32_t> > > p;
+      for (std::map<std::pair<uint32_t, uint32_t>, uint64_t>::iterator
+               i = pairs.begin(); i != pairs.end(); ++i)
+          p.push_back(std::make_pair(i->second, i->first));
+      std::sort(p.rbegin(), p.rend());
+      printf("Most frequent conflicts (victim <- owner):\n");
+      for (size_t i = 0; i < p.size() && i < top; ++i)
+          printf("  T%u <- T%u: %llu\n", p[i].second.first,
+                 p[i].second.second, (unsigned long long)p[i].first);
+
+      std::vector<chain_t> found;
+      std::vector<event_t> c;
+      for (size_t i = 0; i < all.size(); ++i) {
+          if ((all[i].e.type != EV_ABORT) || !all[i].e.arg)
+              continue;
+          walk(all[i], c);
+          if (c.size() > 2)
+              found.push_back(std::make_pair(c.size(), i));
+      }
+      std::stable_sort(found.begin(), found.end(), longer_chain);
+      printf("Longest conflict chains:\n");
+      for (size_t i = 0; i < found.size() && i < top; ++i) {
+          walk(all[found[i].second], c);
+          printf("  %zu:", c.size());
+          for (size_t j = 0; j < c.size(); ++j)
+              printf(" T%u <-", c[j].thread);
+          printf(" T%u, over %llu ticks\n", c.back().e.arg,
+                 (unsigned long long)(c.front().e.when - c.back().e.when));
+      }
+  }
+
+  /*** list every switch, and the longest waits in begin_blocker */
+  void stalls(unsigned top, uint64_t origin)
+  {
+      std::vector<event_t> switches, blocks;
+      for (size_t i = 0; i < all.size(); ++i) {
+          if (all[i].e.type == EV_SWITCH)  switches.push_back(all[i]);
+          if (all[i].e.type == EV_BLOCKED) blocks.push_back(all[i]);
+      }
+      printf("Algorithm switches:\n");
+      for (size_t i = 0; i < switches.size(); ++i)
+          describe(switches[i], origin);
+
+      std::sort(blocks.begin(), blocks.end(), longer_block);
+      printf("Longest stalls in begin_blocker:\n");
+      for (size_t i = 0; i < blocks.size() && i < top; ++i) {
+          // name the switch that was in progress, if any
+          const event_t* cause = NULL;
+          uint64_t start = blocks[i].e.when - blocks[i].e.arg;
+          for (size_t j = 0; j < switches.size(); ++j)
+              if ((switches[j].e.when >= start) &&
+                  (switches[j].e.when <= blocks[i].e.when))
+                  cause = &switches[j];
+          printf("  T%-3u %10u ticks, ending at %llu", blocks[i].thread,
+                 blocks[i].e.arg,
+                 (unsigned long long)(blocks[i].e.when - origin));
+          if (cause)
+              printf(" (switch to %s by T%u)", alg_name(cause->e.arg),
+                     cause->thread);
+          printf("\n");
+      }
+  }
+} // (anonymous namespace)
+
+int main(int argc, char** argv)
+{
+    bool timeline = false;
+    unsigned top = 10;
+    int opt;
+    while ((opt = getopt(argc, argv, "tn:h")) != -1) {
+        switch (opt) {
+          case 't': timeline = true;        break;
+          case 'n': top = atoi(optarg);     break;
+          default:  usage();
+        }
+    }
+    if (optind != argc - 1)
+        usage();
+
+    load(argv[optind]);
+    if (all.empty()) {
+        printf("No events\n");
+        return 0;
+    }
+    uint64_t origin = all.front().e.when;
+
+    if (timeline) {
+        for (size_t i = 0; i < all.size(); ++i)
+            describe(all[i], origin);
+        return 0;
+    }
+    summarize();
+    chains(top);
+    stalls(top, origin);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  Support for the per-thread event trace (see stm/trace.hpp): sizing and
+ *  allocating the rings, and writing them to a file.  The recording itself
+ *  is inline, in trace_ring_t::record.
+ */
+
+#include <stm/config.h>
+
+#ifdef STM_EVENT_TRACE_YES
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <stm/txthread.hpp>
+#include <stm/lib_globals.hpp>
+#include "algs/algs.hpp"
+
+using namespace stm;
+
+namespace
+{
+  /*** events per ring (a power of two) */
+  uint64_t ring_size = 1 << 16;
+
+  /*** where trace_dump writes by default */
+  char trace_file[256] = "stm_trace.bin";
+
+  /*** write(2) until everything is out, or we hit an error */
+  bool write_all(int fd, const void* buf, size_t len)
+  {
+      const char* p = (const char*)buf;
+      while (len) {
+          ssize_t w = write(fd, p, len);
+          if (w <= 0)
+              return false;
+          p += w;
+          len -= w;
+      }
+      return true;
+  }
+
+  /*** SIGUSR2 dumps the trace without stopping the program */
+  void on_sigusr2(int)
+  {
+      trace_dump();
+  }
+} // (anonymous namespace)
+
+namespace stm
+{
+  void trace_configure()
+  {
+      if (const char* s = getenv("STM_TRACE_EVENTS")) {
+          uint64_t want = strtoull(s, 0, 10);
+          ring_size = 1;
+          while (ring_size < want)
+              ring_size <<= 1;
+      }
+      if (const char* f = getenv("STM_TRACE_FILE")) {
+          strncpy(trace_file, f, sizeof(trace_file) - 1);
+          trace_file[sizeof(trace_file) - 1] = '\0';
+      }
+      signal(SIGUSR2, on_sigusr2);
+  }
+
+  void trace_init(TxThread* tx)
+  {
+      tx->trace.events =
+          (trace_event_t*)malloc(ring_size * sizeof(trace_event_t));
+      if (!tx->trace.events)
+          UNRECOVERABLE("Could not allocate the event trace");
+      tx->trace.mask = ring_size - 1;
+  }
+
+  /**
+   *  NB: other threads keep recording while we write.  We take each ring's
+   *      'next' once, so the only damage is that the oldest few events of a
+   *      busy thread may be overwritten while we copy them.
+   */
+  void trace_dump(const char* filename)
+  {
+      int fd = open(filename ? filename : trace_file,
+                    O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0)
+          return;
+
+      trace_header_t h;
+      memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+      h.threads = threadcount.val;
+      h.algs    = ALG_MAX;
+      bool ok = write_all(fd, &h, sizeof(h));
+
+      for (uint32_t a = 0; ok && a < ALG_MAX; ++a) {
+          char name[TRACE_NAME_LEN] = {0};
+          if (stms[a].name)
+              strncpy(name, stms[a].name, TRACE_NAME_LEN - 1);
+          ok = write_all(fd, name, TRACE_NAME_LEN);
+      }
+
+      for (uint32_t i = 0; ok && i < h.threads; ++i) {
+          const trace_ring_t& r = threads[i]->trace;
+          uint64_t next  = r.next;
+          uint64_t count = (next < r.mask + 1) ? next : r.mask + 1;
+
+          trace_thread_t t;
+          t.id      = threads[i]->id;
+          t.unused  = 0;
+          t.events  = count;
+          t.dropped = next - count;
+          ok = write_all(fd, &t, sizeof(t));
+
+          // the events may wrap around the end of the ring
+          uint64_t first = (next - count) & r.mask;
+          uint64_t run   = r.mask + 1 - first;
+          if (run > count)
+              run = count;
+          ok = ok && write_all(fd, r.events + first,
+                               run * sizeof(trace_event_t));
+          ok = ok && write_all(fd, r.events,
+                               (count - run) * sizeof(trace_event_t));
+      }
+      close(fd);
+  }
+} // namespace stm
+
+#endif // STM_EVENT_TRACE_YES
@@ -8,12 +8,17 @@
  *          Please see the file LICENSE.RSTM for licensing information
  */
 
-#include <setjmp.h>
 #include <iostream>
+#include <stm/config.h>
+#ifdef STM_NUMA_LOCAL_YES
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 #include <stm/txthread.hpp>
 #include <stm/lib_globals.hpp>
+#include <stm/checkpoint.hpp>
 #include "policies/policies.hpp"
-#include "algs/tml_inline.hpp"
 #include "algs/algs.hpp"
 #include "inst.hpp"
 
@@ -26,6 +31,23 @@ namespace
    */
   const char* init_lib_name;
 
+  /**
+   *  Run the abort handlers that an aborted transaction registered (see
+   *  stm::on_abort), newest first, so that they can undo its effects in
+   *  reverse.  The commit handlers are just dropped.
+   */
+  void run_abort_handlers(TxThread* tx)
+  {
+      for (HandlerList::iterator i = tx->abort_handlers.end();
+           i != tx->abort_handlers.begin(); )
+      {
+          --i;
+          i->fn(i->arg);
+      }
+      tx->abort_handlers.reset();
+      tx->commit_handlers.reset();
+  }
+
   /**
    *  The default mechanism that libstm uses for an abort. An API environment
    *  may also provide its own abort mechanism (see itm2stm for an example of
@@ -36,13 +58,17 @@ namespace
   NORETURN void
   default_abort_handler(TxThread* tx)
   {
-      jmp_buf* scope = (jmp_buf*)TxThread::tmrollback(tx
+      STM_CHECKPOINT_T* scope = (STM_CHECKPOINT_T*)TxThread::tmrollback(tx
 #if defined(STM_ABORT_ON_THROW)
                                                       , NULL, 0
 #endif
                                                );
+      // the rollback has reset the nesting depth, so the handlers run
+      // outside of any transaction
+      if (tx->abort_handlers.size() | tx->commit_handlers.size())
+          run_abort_handlers(tx);
       // need to null out the scope
-      longjmp(*scope, 1);
+      STM_CHECKPOINT_RESTORE(scope, 1);
   }
 } // (anonymous namespace)
 
@@ -59,8 +85,14 @@ namespace stm
   TxThread::TxThread()
       : nesting_depth(0),
         allocator(),
-        num_commits(0), num_aborts(0), num_restarts(0),
-        num_ro(0), scope(NULL),
+        abort_cause(ABORT_CONFLICT),
+#ifdef STM_CONFLICT_ATTRIBUTION_YES
+        conflict_addr(NULL), conflict_owner(0),
+#endif
+#ifdef STM_CONFLICT_HEATMAP_YES
+        heat_countdown(1),
+#endif
+        scope(NULL),
 #ifdef STM_PROTECT_STACK
         stack_high(NULL),
         stack_low((void**)~0x0),
@@ -78,7 +110,9 @@ namespace stm
         nanorecs(64),
         begin_wait(0),
         strong_HG(),
-        irrevocable(false)
+        irrevocable(false), alg(0), commit_handlers(16), abort_handlers(16),
+        adds(16),
+        begin_txn_time(0), end_txn_time(0), stats()
   {
       // prevent new txns from starting.
       while (true) {
@@ -133,17 +167,16 @@ namespace stm
       // set the epoch to default
       epochs[id-1].val = EPOCH_MAX;
 
+#ifdef STM_EVENT_TRACE_YES
+      // allocate my event ring
+      trace_init(this);
+#endif
+
       // NB: at this point, we could change the mode based on the thread
-      //     count.  The best way to do so would be to install ProfileTM.  We
-      //     would need to be very careful, though, in case another thread is
-      //     already running ProfileTM.  We'd also need a way to skip doing
-      //     so if a non-adaptive policy was in place.  An even better
-      //     strategy might be to put a request for switching outside the
-      //     critical section, as the last line of this method.
-      //
-      // NB: For the release, we are omitting said code, as it does not
-      //     matter in the workloads we provide.  We should revisit at some
-      //     later time.
+      //     count, but doing so from inside the critical section would
+      //     require us to be very careful about ProfileTM and about
+      //     non-adaptive policies.  Instead, we put a request for switching
+      //     outside the critical section, as the last line of this method.
 
       // now publish threadcount.val
       CFENCE;
@@ -152,6 +185,9 @@ namespace stm
       // now we can let threads progress again
       CFENCE;
       tmbegin = stms[curr_policy.ALG_ID].begin;
+
+      // the new thread count may call for a different algorithm
+      thread_count_trigger(this);
   }
 
   /*** print a message and die */
@@ -186,6 +222,40 @@ namespace stm
       Self = new TxThread();
   }
 
+  void TxThread::thread_shutdown()
+  {
+      if (Self)
+          Self->allocator.flushRemoteFrees();
+  }
+
+#ifdef STM_NUMA_LOCAL_YES
+  /**
+   *  A descriptor gets pages of its own, with the MPOL_LOCAL policy, so
+   *  they are placed on the node of the CPU that first touches them.  That
+   *  is the constructor, which runs on the descriptor's thread, so the
+   *  descriptor is local even when the process runs under an interleaved
+   *  policy, and no other thread's data shares its pages.  The logs that
+   *  the constructor allocates, and later grows, come from malloc on the
+   *  same thread, and are placed by first touch under the default policy.
+   */
+  void* TxThread::operator new(size_t size)
+  {
+      void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ptr == MAP_FAILED)
+          UNRECOVERABLE("Could not map a TxThread");
+      // MPOL_LOCAL is 4 in <linux/mempolicy.h>; it needs Linux 3.8, and
+      // without it we just get the process's policy
+      syscall(SYS_mbind, ptr, size, 4, NULL, 0, 0);
+      return ptr;
+  }
+
+  void TxThread::operator delete(void* ptr, size_t size)
+  {
+      munmap(ptr, size);
+  }
+#endif
+
   /**
    *  Simplified support for self-abort
    */
@@ -194,11 +264,102 @@ namespace stm
       // get the thread's tx context
       TxThread* tx = Self;
       // register this restart
-      ++tx->num_restarts;
+      ++tx->stats.restarts;
       // call the abort code
+      tx->abort_cause = ABORT_RESTART;
       tx->tmabort(tx);
   }
 
+  /**
+   *  Run the commit handlers of a transaction that just committed, in the
+   *  order they were registered.  The abort handlers are just dropped.
+   */
+  void run_commit_handlers(TxThread* tx)
+  {
+      for (HandlerList::iterator i = tx->commit_handlers.begin(),
+               e = tx->commit_handlers.end(); i != e; ++i)
+          i->fn(i->arg);
+      tx->commit_handlers.reset();
+      tx->abort_handlers.reset();
+  }
+
+  /**
+   *  The handlers that tx_add registers: apply the deferred increments of a
+   *  transaction that committed, or drop those of one that aborted
+   */
+  void apply_deferred_adds(void* arg)
+  {
+      TxThread* tx = static_cast<TxThread*>(arg);
+      for (AddList::iterator i = tx->adds.begin(), e = tx->adds.end();
+           i != e; ++i)
+          faaptr(i->addr, i->delta);
+      tx->adds.reset();
+  }
+
+  void drop_deferred_adds(void* arg)
+  {
+      static_cast<TxThread*>(arg)->adds.reset();
+  }
+
+  /*** this transaction's deferred increments of addr, summed */
+  uintptr_t pending_adds(TxThread* tx, const volatile uintptr_t* addr)
+  {
+      uintptr_t sum = 0;
+      for (AddList::iterator i = tx->adds.begin(), e = tx->adds.end();
+           i != e; ++i)
+          if (i->addr == addr)
+              sum += i->delta;
+      return sum;
+  }
+
+
+  /**
+   *  The commit and time counters when the ProfileApp counters were last
+   *  reset, so that a profile covers only the work done since then.
+   */
+  static stats_t app_profile_base;
+
+  /**
+   *  Clear ProfileApp's counters, so the next get_app_profile covers only
+   *  what runs after this call.  Call it while no transactions are running.
+   */
+  void reset_app_profile()
+  {
+      if (app_profiles)
+          app_profiles->clear();
+      app_profile_base = get_stats();
+  }
+
+  /**
+   *  Turn ProfileApp's running totals into one qtable row.  Returns false if
+   *  ProfileApp never ran.
+   */
+  bool get_app_profile(app_profile_t& ap)
+  {
+      if (!app_profiles)
+          return false;
+
+      stats_t totals        = get_stats();
+      uint64_t nontxn_count = totals.nontx_time - app_profile_base.nontx_time;
+      uint64_t ro_count     = totals.ro_commits - app_profile_base.ro_commits;
+      uint64_t txn_count    = totals.commits - app_profile_base.commits
+                            + ro_count;
+
+      uint64_t divisor = (curr_policy.ALG_ID == ProfileAppAvg) ? txn_count : 1;
+      if (divisor == 0)
+          divisor = ~0ull; // unsigned infinity :)
+
+      ap.read_ro        = app_profiles->read_ro / divisor;
+      ap.read_rw_nonraw = app_profiles->read_rw_nonraw / divisor;
+      ap.read_rw_raw    = app_profiles->read_rw_raw / divisor;
+      ap.write_nonwaw   = app_profiles->write_nonwaw / divisor;
+      ap.write_waw      = app_profiles->write_waw / divisor;
+      ap.txn_time       = app_profiles->txn_time / divisor;
+      ap.pct_txtime     = (!nontxn_count)
+          ? 0 : (100 * app_profiles->timecounter) / nontxn_count;
+      ap.roratio        = (!txn_count) ? 0 : (100 * ro_count) / txn_count;
+      return true;
+  }
 
   /**
    *  When the transactional system gets shut down, we call this to dump stats
@@ -208,47 +369,82 @@ namespace stm
       static volatile unsigned int mtx = 0;
       while (!bcas32(&mtx, 0u, 1u)) { }
 
-      uint64_t nontxn_count = 0;                // time outside of txns
-      uint32_t pct_ro       = 0;                // read only txn ratio
-      uint32_t txn_count    = 0;                // total txns
-      uint32_t rw_txns      = 0;                // rw commits
-      uint32_t ro_txns      = 0;                // ro commits
       for (uint32_t i = 0; i < threadcount.val; i++) {
+          const tx_stats_t& t = threads[i]->stats;
           std::cout << "Thread: "       << threads[i]->id
-                    << "; RW Commits: " << threads[i]->num_commits
-                    << "; RO Commits: " << threads[i]->num_ro
-                    << "; Aborts: "     << threads[i]->num_aborts
-                    << "; Restarts: "   << threads[i]->num_restarts
+                    << "; RW Commits: " << t.commits
+                    << "; RO Commits: " << t.ro_commits
+                    << "; Aborts: "     << t.total_aborts()
+                    << "; Restarts: "   << t.restarts
                     << std::endl;
           threads[i]->abort_hist.dump();
-          rw_txns += threads[i]->num_commits;
-          ro_txns += threads[i]->num_ro;
-          nontxn_count += threads[i]->total_nontxn_time;
+#ifdef STM_CONFLICT_ATTRIBUTION_YES
+          std::cout << "  Aborted by:";
+          for (uint32_t o = 0; o <= MAX_THREADS; ++o)
+              if (t.conflicts_with[o]) {
+                  if (o)
+                      std::cout << " " << o;
+                  else
+                      std::cout << " ?";
+                  std::cout << "=" << t.conflicts_with[o];
+              }
+          std::cout << std::endl;
+          // the last few conflict locations, oldest first
+          uint32_t n = t.recent_next;
+          if (n > tx_stats_t::CONFLICT_LOG)
+              n = tx_stats_t::CONFLICT_LOG;
+          if (n) {
+              std::cout << "  Recent conflicts:";
+              for (uint32_t k = t.recent_next - n; k != t.recent_next; ++k) {
+                  uint32_t slot = k % tx_stats_t::CONFLICT_LOG;
+                  std::cout << " " << abort_cause_name(t.recent_cause[slot])
+                            << "@" << (const void*)t.recent[slot];
+              }
+              std::cout << std::endl;
+          }
+#endif
       }
-      txn_count = rw_txns + ro_txns;
-      pct_ro = (!txn_count) ? 0 : (100 * ro_txns) / txn_count;
+
+      stats_t totals       = get_stats();
+      uint64_t nontxn_count = totals.nontx_time;  // time outside of txns
 
       std::cout << "Total nontxn work:\t" << nontxn_count << std::endl;
+      std::cout << "Total txn work:\t"    << totals.tx_time << std::endl;
+      std::cout << "Aborts by cause:";
+      for (int c = 0; c < ABORT_CAUSES; ++c)
+          std::cout << " " << abort_cause_name(c) << "="
+                    << totals.aborts_by_cause[c];
+      std::cout << std::endl;
+      totals.latency.dump("Txn latency (ticks)");
+      totals.attempts.dump("Attempts per commit");
+
+#ifdef STM_CONFLICT_HEATMAP_YES
+      dump_conflict_heatmap();
+#endif
+
+#ifdef STM_EVENT_TRACE_YES
+      trace_dump();
+#endif
+
+      // how long did mode switches take?
+      totals.blocking_switches.dump("Blocking");
+      totals.draining_switches.dump("Draining");
 
       // if we ever switched to ProfileApp, then we should print out the
       // ProfileApp custom output.
-      if (app_profiles) {
-          uint32_t divisor =
-              (curr_policy.ALG_ID == ProfileAppAvg) ? txn_count : 1;
-          if (divisor == 0)
-              divisor = 0u - 1u; // unsigned infinity :)
-
+      app_profile_t ap;
+      if (get_app_profile(ap)) {
           std::cout << "# " << stms[curr_policy.ALG_ID].name << " #" << std::endl;
           std::cout << "# read_ro, read_rw_nonraw, read_rw_raw, write_nonwaw, write_waw, txn_time, "
                     << "pct_txtime, roratio #" << std::endl;
-          std::cout << app_profiles->read_ro  / divisor << ", "
-                    << app_profiles->read_rw_nonraw / divisor << ", "
-                    << app_profiles->read_rw_raw / divisor << ", "
-                    << app_profiles->write_nonwaw / divisor << ", "
-                    << app_profiles->write_waw / divisor << ", "
-                    << app_profiles->txn_time / divisor << ", "
-                    << ((100*app_profiles->timecounter)/nontxn_count) << ", "
-                    << pct_ro << " #" << std::endl;
+          std::cout << ap.read_ro << ", "
+                    << ap.read_rw_nonraw << ", "
+                    << ap.read_rw_raw << ", "
+                    << ap.write_nonwaw << ", "
+                    << ap.write_waw << ", "
+                    << ap.txn_time << ", "
+                    << ap.pct_txtime << ", "
+                    << ap.roratio << " #" << std::endl;
       }
       CFENCE;
       mtx = 0;
@@ -263,22 +459,6 @@ namespace stm
    */
   void set_policy(const char* phasename)
   {
-      // prevent new txns from starting.  Note that we can't be in ProfileTM
-      // while doing this
-      while (true) {
-          int i = curr_policy.ALG_ID;
-          if (i == ProfileTM)
-              continue;
-          if (bcasptr(&TxThread::tmbegin, stms[i].begin, &begin_blocker))
-              break;
-          spin64();
-      }
-
-      // wait for everyone to be out of a transaction (scope == NULL)
-      for (unsigned i = 0; i < threadcount.val; ++i)
-          while (threads[i]->scope)
-              spin64();
-
       // figure out the algorithm for the STM, and set the adapt policy
 
       // we assume that the phase is a single-algorithm phase
@@ -292,6 +472,36 @@ namespace stm
           new_algorithm = pols[tmp].startmode;
       }
 
+      // prevent new txns from starting.  If a profile is being collected,
+      // we cancel it: there may be no transactions left to finish it.  If
+      // the current algorithm can run alongside the new one, we switch
+      // without waiting for everyone to finish.
+      while (true) {
+          int i = curr_policy.ALG_ID;
+          if (i == ProfileTM) {
+              if (cancel_profile())
+                  break;
+          }
+          else if (switch_compatible(i, new_algorithm)) {
+              if (drain_algorithm(new_algorithm, Self)) {
+                  curr_policy.POL_ID = new_policy;
+                  curr_policy.waitThresh = pols[new_policy].waitThresh;
+                  curr_policy.abortThresh = pols[new_policy].abortThresh;
+                  return;
+              }
+          }
+          else if (bcasptr(&TxThread::tmbegin, stms[i].begin, &begin_blocker)) {
+              break;
+          }
+          spin64();
+      }
+      switch_start = tick();
+
+      // wait for everyone to be out of a transaction (scope == NULL)
+      for (unsigned i = 0; i < threadcount.val; ++i)
+          while (threads[i]->scope)
+              spin64();
+
       curr_policy.POL_ID = new_policy;
       curr_policy.waitThresh = pols[new_policy].waitThresh;
       curr_policy.abortThresh = pols[new_policy].abortThresh;
@@ -349,12 +559,22 @@ namespace stm
           MetaInitializer<0>::init();
 
           // guess a default configuration, then check env for a better option
+#ifdef STM_SINGLE_ALG
+          // the library API inlines this algorithm's barriers
+          const char* cfg = STM_SINGLE_ALG;
+#else
           const char* cfg = "NOrec";
+#endif
           const char* configstring = getenv("STM_CONFIG");
           if (configstring)
               cfg = configstring;
           else
               printf("STM_CONFIG environment variable not found... using %s\n", cfg);
+#ifdef STM_SINGLE_ALG
+          if (strcmp(cfg, STM_SINGLE_ALG))
+              printf("Warning: barriers are only inlined for %s\n",
+                     STM_SINGLE_ALG);
+#endif
           init_lib_name = cfg;
 
           // now initialize the the adaptive policies
@@ -369,6 +589,24 @@ namespace stm
           for (unsigned i = 0; i < profile_txns; i++)
               profiles[i].clear();
 
+          // if requested, collect those profiles by sampling one in every
+          // STM_SAMPLEPERIOD transactions, instead of with ProfileTM
+          char* sps = getenv("STM_SAMPLEPERIOD");
+          if (sps != NULL)
+              sample_period = strtol(sps, 0, 10);
+
+#ifdef STM_EVENT_TRACE_YES
+          // size the event rings, and arrange for SIGUSR2 to dump them
+          trace_configure();
+#endif
+
+#ifdef STM_CONFLICT_HEATMAP_YES
+          // sample one in every STM_HEATPERIOD orec conflicts
+          char* hps = getenv("STM_HEATPERIOD");
+          if (hps != NULL && strtol(hps, 0, 10) > 0)
+              heat_period = strtol(hps, 0, 10);
+#endif
+
           // Initialize the global abort handler.
           if (conflict_abort_handler)
               TxThread::tmabort = conflict_abort_handler;
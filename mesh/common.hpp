@@ -53,7 +53,35 @@ extern __thread thread* currentThread;
 #   define END_TRANSACTION }
 #endif
 
-#ifdef ITM
+#if defined(ITM) && defined(__GNUC__) && !defined(__ICC)
+// gcc -fgnu-tm (with libitm2stm's gccitm2stm) spells these differently, and
+// already knows that new and delete are transaction safe. It doesn't know
+// that a failing assert can't need to be undone, so we tell it.
+#   include <cassert>
+#   ifdef __GLIBC__
+    extern "C" void __assert_fail(const char*, const char*, unsigned int,
+                                  const char*)
+        throw() __attribute__((__noreturn__, transaction_pure));
+#   endif
+#   define BEGIN_TRANSACTION(TYPE)              \
+    currentThread->enter_transaction();         \
+    currentThread->erase_buffered_output();     \
+    __transaction_##TYPE {
+#   define END_TRANSACTION }                   \
+        currentThread->dump_buffered_output(); \
+        currentThread->leave_transaction();
+#   define TRANSACTION_SAFE __attribute__((transaction_safe))
+#   define TRANSACTION_PURE __attribute__((transaction_pure))
+#   define TRANSACTION_WAIVER
+
+#include "itm.h"
+
+#   define  SYS_INIT                   _ITM_initializeProcess
+#   define  THREAD_INIT                _ITM_initializeThread
+#   define  THREAD_SHUTDOWN            _ITM_finalizeThread
+#   define  SYS_SHUTDOWN               _ITM_finalizeProcess
+
+#elif defined(ITM)
 #   include <new>
     [[transaction_safe]]
     void* operator new (std::size_t size) throw (std::bad_alloc);
@@ -11,4 +11,7 @@ include (CMakeDependentOption)
 cmake_dependent_option(
   stamp_use_waiver
   "ON to use Intel's __transaction [[waiver]] extension." ON
-  "rstm_enable_itm OR rstm_enable_itm2stm" OFF)
\ No newline at end of file
+  "rstm_enable_itm OR rstm_enable_itm2stm" OFF)
+option(
+  stamp_sharded_queue
+  "ON to give intruder and labyrinth the per-thread sharded work queue." OFF)
@@ -1304,8 +1304,7 @@ learnStructure (void* argPtr)
                                       newBaseLogLikelihood);
                     TM_END();
                     TM_BEGIN();
-                    long numTotalParent = (long)TM_SHARED_READ_L(learnerPtr->numTotalParent);
-                    TM_SHARED_WRITE_L(learnerPtr->numTotalParent, (numTotalParent + 1));
+                    TM_SHARED_ADD_L(learnerPtr->numTotalParent, 1);
                     TM_END();
                     break;
                 }
@@ -1333,8 +1332,7 @@ learnStructure (void* argPtr)
                                       newBaseLogLikelihood);
                     TM_END();
                     TM_BEGIN();
-                    long numTotalParent = (long)TM_SHARED_READ_L(learnerPtr->numTotalParent);
-                    TM_SHARED_WRITE_L(learnerPtr->numTotalParent, (numTotalParent - 1));
+                    TM_SHARED_ADD_L(learnerPtr->numTotalParent, -1);
                     TM_END();
                     break;
                 }
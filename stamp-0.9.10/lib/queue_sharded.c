@@ -0,0 +1,644 @@
+/**
+ *  Copyright (C) 2011
+ *  University of Rochester Department of Computer Science
+ *    and
+ *  Lehigh University Department of Computer Science and Engineering
+ *
+ * License: Modified BSD
+ *          Please see the file LICENSE.RSTM for licensing information
+ */
+
+/**
+ *  A drop-in replacement for queue.c, for queues that transactions share.
+ *
+ *  queue.c keeps one ring buffer, so every TMqueue_push and TMqueue_pop
+ *  reads and writes the same pop and push indices, and any two transactions
+ *  that touch the queue conflict.  Here the queue is split into one ring
+ *  buffer (shard) per thread.  A transaction pushes to its own shard, and
+ *  pops from its own shard first, stealing from the others only when its
+ *  shard is empty.  In each shard, the consumer's index and the producer's
+ *  fields are on different cache lines.
+ *
+ *  Nontransactional pushes and pops go round-robin over the shards, so a
+ *  queue that is only used sequentially is still exactly FIFO.  Once
+ *  transactions use it, order is FIFO per shard only, which is all that the
+ *  STAMP work queues rely on.  Pqueue_alloc makes a single shard, since a
+ *  private queue never has a second thread to share with.
+ *
+ *  The number of shards comes from thread_getNumThread(), so shared queues
+ *  should be allocated after thread_startup().
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "random.h"
+#include "thread.h"
+#include "tm.h"
+#include "types.h"
+#include "queue.h"
+
+
+enum config {
+    QUEUE_GROWTH_FACTOR = 2,
+    QUEUE_CACHE_LINE    = 64,
+};
+
+typedef struct queue_shard {
+    /* consumer */
+    long pop; /* points before element to pop */
+    char padPop[QUEUE_CACHE_LINE - sizeof(long)];
+    /* producer */
+    long push;
+    long capacity;
+    void** elements;
+    char padPush[QUEUE_CACHE_LINE - 2 * sizeof(long) - sizeof(void*)];
+} queue_shard_t;
+
+struct queue {
+    long numShard;         /* fixed at allocation */
+    queue_shard_t* shards; /* fixed at allocation, cache-line aligned */
+    void* raw;             /* what was allocated for shards */
+    long nextPush;         /* round-robin position of nontransactional push */
+    long nextPop;          /* ... and pop */
+};
+
+
+/* =============================================================================
+ * shard helpers
+ * =============================================================================
+ */
+static long
+shardCapacity (long initCapacity, long numShard)
+{
+    long capacity = ((initCapacity < 0) ? 0 : initCapacity);
+    capacity = (capacity + numShard - 1) / numShard;
+    return ((capacity < 2) ? 2 : capacity);
+}
+
+static queue_shard_t*
+alignShards (void* raw)
+{
+    uintptr_t addr = ((uintptr_t)raw + QUEUE_CACHE_LINE - 1);
+    return (queue_shard_t*)(addr & ~(uintptr_t)(QUEUE_CACHE_LINE - 1));
+}
+
+static void
+shardInit (queue_shard_t* shardPtr, void** elements, long capacity)
+{
+    shardPtr->pop      = capacity - 1;
+    shardPtr->push     = 0;
+    shardPtr->capacity = capacity;
+    shardPtr->elements = elements;
+}
+
+static long
+shardNumElement (queue_shard_t* shardPtr)
+{
+    long pop      = shardPtr->pop;
+    long push     = shardPtr->push;
+    long capacity = shardPtr->capacity;
+
+    if (pop < push) {
+        return push - (pop + 1);
+    }
+    return capacity - (pop - push + 1);
+}
+
+static void*
+queueMalloc (size_t size, bool_t isPrivate)
+{
+    if (isPrivate) {
+        return P_MALLOC(size);
+    }
+    return SEQ_MALLOC(size);
+}
+
+static void
+queueFree (void* ptr, bool_t isPrivate)
+{
+    if (isPrivate) {
+        P_FREE(ptr);
+    } else {
+        SEQ_FREE(ptr);
+    }
+}
+
+
+/* =============================================================================
+ * allocQueue
+ * =============================================================================
+ */
+static queue_t*
+allocQueue (long initCapacity, long numShard, bool_t isPrivate)
+{
+    queue_t* queuePtr = (queue_t*)queueMalloc(sizeof(queue_t), isPrivate);
+    if (queuePtr == NULL) {
+        return NULL;
+    }
+
+    void* raw = queueMalloc((numShard * sizeof(queue_shard_t) +
+                             QUEUE_CACHE_LINE),
+                            isPrivate);
+    if (raw == NULL) {
+        queueFree(queuePtr, isPrivate);
+        return NULL;
+    }
+    queue_shard_t* shards = alignShards(raw);
+
+    long capacity = shardCapacity(initCapacity, numShard);
+    long s;
+    for (s = 0; s < numShard; s++) {
+        void** elements =
+            (void**)queueMalloc(capacity * sizeof(void*), isPrivate);
+        if (elements == NULL) {
+            while (s-- > 0) {
+                queueFree(shards[s].elements, isPrivate);
+            }
+            queueFree(raw, isPrivate);
+            queueFree(queuePtr, isPrivate);
+            return NULL;
+        }
+        shardInit(&shards[s], elements, capacity);
+    }
+
+    queuePtr->numShard = numShard;
+    queuePtr->shards   = shards;
+    queuePtr->raw      = raw;
+    queuePtr->nextPush = 0;
+    queuePtr->nextPop  = 0;
+
+    return queuePtr;
+}
+
+
+/* =============================================================================
+ * queue_alloc
+ * =============================================================================
+ */
+queue_t*
+queue_alloc (long initCapacity)
+{
+    long numShard = thread_getNumThread();
+    return allocQueue(initCapacity, ((numShard < 1) ? 1 : numShard), FALSE);
+}
+
+
+/* =============================================================================
+ * Pqueue_alloc
+ * =============================================================================
+ */
+queue_t*
+Pqueue_alloc (long initCapacity)
+{
+    return allocQueue(initCapacity, 1, TRUE);
+}
+
+
+/* =============================================================================
+ * TMqueue_alloc
+ * =============================================================================
+ */
+queue_t*
+TMqueue_alloc (TM_ARGDECL  long initCapacity)
+{
+    long numShard = thread_getNumThread();
+    numShard = ((numShard < 1) ? 1 : numShard);
+
+    queue_t* queuePtr = (queue_t*)TM_MALLOC(sizeof(queue_t));
+    if (queuePtr == NULL) {
+        return NULL;
+    }
+
+    void* raw = TM_MALLOC(numShard * sizeof(queue_shard_t) + QUEUE_CACHE_LINE);
+    if (raw == NULL) {
+        TM_FREE(queuePtr);
+        return NULL;
+    }
+    queue_shard_t* shards = alignShards(raw);
+
+    long capacity = shardCapacity(initCapacity, numShard);
+    long s;
+    for (s = 0; s < numShard; s++) {
+        void** elements = (void**)TM_MALLOC(capacity * sizeof(void*));
+        if (elements == NULL) {
+            while (s-- > 0) {
+                TM_FREE(shards[s].elements);
+            }
+            TM_FREE(raw);
+            TM_FREE(queuePtr);
+            return NULL;
+        }
+        shardInit(&shards[s], elements, capacity);
+    }
+
+    queuePtr->numShard = numShard;
+    queuePtr->shards   = shards;
+    queuePtr->raw      = raw;
+    queuePtr->nextPush = 0;
+    queuePtr->nextPop  = 0;
+
+    return queuePtr;
+}
+
+
+/* =============================================================================
+ * queue_free
+ * =============================================================================
+ */
+void
+queue_free (queue_t* queuePtr)
+{
+    long s;
+    for (s = 0; s < queuePtr->numShard; s++) {
+        SEQ_FREE(queuePtr->shards[s].elements);
+    }
+    SEQ_FREE(queuePtr->raw);
+    SEQ_FREE(queuePtr);
+}
+
+
+/* =============================================================================
+ * Pqueue_free
+ * =============================================================================
+ */
+void
+Pqueue_free (queue_t* queuePtr)
+{
+    long s;
+    for (s = 0; s < queuePtr->numShard; s++) {
+        P_FREE(queuePtr->shards[s].elements);
+    }
+    P_FREE(queuePtr->raw);
+    P_FREE(queuePtr);
+}
+
+
+/* =============================================================================
+ * TMqueue_free
+ * =============================================================================
+ */
+void
+TMqueue_free (TM_ARGDECL  queue_t* queuePtr)
+{
+    long s;
+    for (s = 0; s < queuePtr->numShard; s++) {
+        queue_shard_t* shardPtr = &queuePtr->shards[s];
+        TM_FREE((void**)TM_SHARED_READ_P(shardPtr->elements));
+    }
+    TM_FREE(queuePtr->raw);
+    TM_FREE(queuePtr);
+}
+
+
+/* =============================================================================
+ * queue_isEmpty
+ * =============================================================================
+ */
+bool_t
+queue_isEmpty (queue_t* queuePtr)
+{
+    long s;
+    for (s = 0; s < queuePtr->numShard; s++) {
+        queue_shard_t* shardPtr = &queuePtr->shards[s];
+        if ((shardPtr->pop + 1) % shardPtr->capacity != shardPtr->push) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * queue_clear
+ * =============================================================================
+ */
+void
+queue_clear (queue_t* queuePtr)
+{
+    long s;
+    for (s = 0; s < queuePtr->numShard; s++) {
+        queue_shard_t* shardPtr = &queuePtr->shards[s];
+        shardPtr->pop  = shardPtr->capacity - 1;
+        shardPtr->push = 0;
+    }
+    queuePtr->nextPush = 0;
+    queuePtr->nextPop  = 0;
+}
+
+void
+TMqueue_clear (TM_ARGDECL queue_t* queuePtr)
+{
+    long s;
+    for (s = 0; s < queuePtr->numShard; s++) {
+        queue_shard_t* shardPtr = &queuePtr->shards[s];
+        long capacity = (long)TM_SHARED_READ_L(shardPtr->capacity);
+        TM_SHARED_WRITE_L(shardPtr->pop,  capacity - 1);
+        TM_SHARED_WRITE_L(shardPtr->push, 0L);
+    }
+}
+
+
+/* =============================================================================
+ * TMmyShard
+ * -- The shard that this thread pushes to, and pops from first
+ * =============================================================================
+ */
+static TM_CALLABLE long
+TMmyShard (TM_ARGDECL  queue_t* queuePtr)
+{
+    long threadId;
+    TM_BEGIN_WAIVER();
+    threadId = thread_getId();
+    TM_END_WAIVER();
+    return threadId % queuePtr->numShard;
+}
+
+
+/* =============================================================================
+ * TMqueue_isEmpty
+ * =============================================================================
+ */
+bool_t
+TMqueue_isEmpty (TM_ARGDECL  queue_t* queuePtr)
+{
+    long numShard = queuePtr->numShard;
+    long myShard  = TMmyShard(TM_ARG  queuePtr);
+
+    long i;
+    for (i = 0; i < numShard; i++) {
+        queue_shard_t* shardPtr = &queuePtr->shards[(myShard + i) % numShard];
+        long pop      = (long)TM_SHARED_READ_L(shardPtr->pop);
+        long push     = (long)TM_SHARED_READ_L(shardPtr->push);
+        long capacity = (long)TM_SHARED_READ_L(shardPtr->capacity);
+        if ((pop + 1) % capacity != push) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * queue_shuffle
+ * -- Shuffles across shards, as if they were one queue
+ * =============================================================================
+ */
+static void**
+shuffleSlot (queue_t* queuePtr, long index)
+{
+    long s;
+    for (s = 0; s < queuePtr->numShard; s++) {
+        queue_shard_t* shardPtr = &queuePtr->shards[s];
+        long numElement = shardNumElement(shardPtr);
+        if (index < numElement) {
+            long i = (shardPtr->pop + 1 + index) % shardPtr->capacity;
+            return &shardPtr->elements[i];
+        }
+        index -= numElement;
+    }
+    assert(0);
+    return NULL;
+}
+
+void
+queue_shuffle (queue_t* queuePtr, random_t* randomPtr)
+{
+    long numElement = 0;
+    long s;
+    for (s = 0; s < queuePtr->numShard; s++) {
+        numElement += shardNumElement(&queuePtr->shards[s]);
+    }
+
+    long i;
+    for (i = 0; i < numElement; i++) {
+        long r1 = random_generate(randomPtr) % numElement;
+        long r2 = random_generate(randomPtr) % numElement;
+        void** i1 = shuffleSlot(queuePtr, r1);
+        void** i2 = shuffleSlot(queuePtr, r2);
+        void* tmp = *i1;
+        *i1 = *i2;
+        *i2 = tmp;
+    }
+}
+
+
+/* =============================================================================
+ * shardPush
+ * =============================================================================
+ */
+static bool_t
+shardPush (queue_shard_t* shardPtr, void* dataPtr, bool_t isPrivate)
+{
+    long pop      = shardPtr->pop;
+    long push     = shardPtr->push;
+    long capacity = shardPtr->capacity;
+
+    assert(pop != push);
+
+    /* Need to resize */
+    long newPush = (push + 1) % capacity;
+    if (newPush == pop) {
+
+        long newCapacity = capacity * QUEUE_GROWTH_FACTOR;
+        void** newElements =
+            (void**)queueMalloc(newCapacity * sizeof(void*), isPrivate);
+        if (newElements == NULL) {
+            return FALSE;
+        }
+
+        long dst = 0;
+        void** elements = shardPtr->elements;
+        if (pop < push) {
+            long src;
+            for (src = (pop + 1); src < push; src++, dst++) {
+                newElements[dst] = elements[src];
+            }
+        } else {
+            long src;
+            for (src = (pop + 1); src < capacity; src++, dst++) {
+                newElements[dst] = elements[src];
+            }
+            for (src = 0; src < push; src++, dst++) {
+                newElements[dst] = elements[src];
+            }
+        }
+
+        queueFree(elements, isPrivate);
+        shardPtr->elements = newElements;
+        shardPtr->pop      = newCapacity - 1;
+        shardPtr->capacity = newCapacity;
+        push = dst;
+        newPush = push + 1; /* no need modulo */
+    }
+
+    shardPtr->elements[push] = dataPtr;
+    shardPtr->push = newPush;
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * queue_push
+ * =============================================================================
+ */
+bool_t
+queue_push (queue_t* queuePtr, void* dataPtr)
+{
+    long s = queuePtr->nextPush;
+    if (!shardPush(&queuePtr->shards[s], dataPtr, FALSE)) {
+        return FALSE;
+    }
+    queuePtr->nextPush = (s + 1) % queuePtr->numShard;
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * Pqueue_push
+ * =============================================================================
+ */
+bool_t
+Pqueue_push (queue_t* queuePtr, void* dataPtr)
+{
+    long s = queuePtr->nextPush;
+    if (!shardPush(&queuePtr->shards[s], dataPtr, TRUE)) {
+        return FALSE;
+    }
+    queuePtr->nextPush = (s + 1) % queuePtr->numShard;
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TMqueue_push
+ * =============================================================================
+ */
+bool_t
+TMqueue_push (TM_ARGDECL  queue_t* queuePtr, void* dataPtr)
+{
+    queue_shard_t* shardPtr =
+        &queuePtr->shards[TMmyShard(TM_ARG  queuePtr)];
+
+    long pop      = (long)TM_SHARED_READ_L(shardPtr->pop);
+    long push     = (long)TM_SHARED_READ_L(shardPtr->push);
+    long capacity = (long)TM_SHARED_READ_L(shardPtr->capacity);
+
+    assert(pop != push);
+
+    /* Need to resize */
+    long newPush = (push + 1) % capacity;
+    if (newPush == pop) {
+        long newCapacity = capacity * QUEUE_GROWTH_FACTOR;
+        void** newElements = (void**)TM_MALLOC(newCapacity * sizeof(void*));
+        if (newElements == NULL) {
+            return FALSE;
+        }
+
+        long dst = 0;
+        void** elements = (void**)TM_SHARED_READ_P(shardPtr->elements);
+        if (pop < push) {
+            long src;
+            for (src = (pop + 1); src < push; src++, dst++) {
+                newElements[dst] = (void*)TM_SHARED_READ_P(elements[src]);
+            }
+        } else {
+            long src;
+            for (src = (pop + 1); src < capacity; src++, dst++) {
+                newElements[dst] = (void*)TM_SHARED_READ_P(elements[src]);
+            }
+            for (src = 0; src < push; src++, dst++) {
+                newElements[dst] = (void*)TM_SHARED_READ_P(elements[src]);
+            }
+        }
+
+        TM_FREE(elements);
+        TM_SHARED_WRITE_P(shardPtr->elements, newElements);
+        TM_SHARED_WRITE_L(shardPtr->pop,      newCapacity - 1);
+        TM_SHARED_WRITE_L(shardPtr->capacity, newCapacity);
+        push = dst;
+        newPush = push + 1; /* no need modulo */
+
+    }
+
+    void** elements = (void**)TM_SHARED_READ_P(shardPtr->elements);
+    TM_SHARED_WRITE_P(elements[push], dataPtr);
+    TM_SHARED_WRITE_L(shardPtr->push, newPush);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * queue_pop
+ * =============================================================================
+ */
+void*
+queue_pop (queue_t* queuePtr)
+{
+    long numShard = queuePtr->numShard;
+
+    long i;
+    for (i = 0; i < numShard; i++) {
+        long s = (queuePtr->nextPop + i) % numShard;
+        queue_shard_t* shardPtr = &queuePtr->shards[s];
+        long newPop = (shardPtr->pop + 1) % shardPtr->capacity;
+        if (newPop != shardPtr->push) {
+            void* dataPtr = shardPtr->elements[newPop];
+            shardPtr->pop = newPop;
+            queuePtr->nextPop = (s + 1) % numShard;
+            return dataPtr;
+        }
+    }
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ * TMqueue_pop
+ * -- Tries this thread's shard first, then steals from the others
+ * =============================================================================
+ */
+void*
+TMqueue_pop (TM_ARGDECL  queue_t* queuePtr)
+{
+    long numShard = queuePtr->numShard;
+    long myShard  = TMmyShard(TM_ARG  queuePtr);
+
+    long i;
+    for (i = 0; i < numShard; i++) {
+        queue_shard_t* shardPtr = &queuePtr->shards[(myShard + i) % numShard];
+
+        long pop      = (long)TM_SHARED_READ_L(shardPtr->pop);
+        long push     = (long)TM_SHARED_READ_L(shardPtr->push);
+        long capacity = (long)TM_SHARED_READ_L(shardPtr->capacity);
+
+        long newPop = (pop + 1) % capacity;
+        if (newPop == push) {
+            continue;
+        }
+
+        void** elements = (void**)TM_SHARED_READ_P(shardPtr->elements);
+        void* dataPtr = (void*)TM_SHARED_READ_P(elements[newPop]);
+        TM_SHARED_WRITE_L(shardPtr->pop, newPop);
+
+        return dataPtr;
+    }
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ *
+ * End of queue_sharded.c
+ *
+ * =============================================================================
+ */
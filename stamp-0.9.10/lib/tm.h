@@ -435,13 +435,17 @@
 #      define TM_BEGIN_WAIVER()
 #      define TM_END_WAIVER()
 
-#      define P_MALLOC(size)            malloc(size)
-#      define P_FREE(ptr)               free(ptr)
-#      define SEQ_MALLOC(size)          malloc(size)
-#      define SEQ_FREE(ptr)             free(ptr)
+       /* All of STAMP's memory goes through libstm's allocator.  TM_ memory
+        * is logged, so that frees are deferred to commit and allocations are
+        * undone on abort; P_ and SEQ_ memory is not, since the private
+        * structures that hold it are not rolled back either. */
+#      define P_MALLOC(size)            tx_safe_non_tx_alloc(size)
+#      define P_FREE(ptr)               tx_safe_non_tx_free(ptr)
+#      define SEQ_MALLOC(size)          tx_safe_non_tx_alloc(size)
+#      define SEQ_FREE(ptr)             tx_safe_non_tx_free(ptr)
 
 #      define TM_MALLOC(size)           TM_ALLOC(size)
-//#      define TM_FREE(ptr)              STM_FREE(ptr)
+       /* TM_FREE(ptr) is stm::tx_free, from api/library.hpp */
 #    endif /* !OTM */
 
 #  endif /* !SIMULATOR */
@@ -591,6 +595,8 @@
 #  define TM_SHARED_WRITE_P(var, val)   ({var = val; var;})
 #  define TM_SHARED_WRITE_F(var, val)   ({var = val; var;})
 
+#  define TM_SHARED_ADD_L(var, val)     ({var += val; var;})
+
 #  define TM_LOCAL_WRITE_I(var, val)    ({var = val; var;})
 #  define TM_LOCAL_WRITE_L(var, val)    ({var = val; var;})
 #  define TM_LOCAL_WRITE_P(var, val)    ({var = val; var;})
@@ -611,6 +617,11 @@
 #  define TM_SHARED_WRITE_P(var, val)   STMWRITE(&var, val, (stm::TxThread*)STM_SELF)
 #  define TM_SHARED_WRITE_F(var, val)   STMWRITE(&var, val, (stm::TxThread*)STM_SELF)
 
+   /* A blind increment, applied at commit (see stm::tx_add).  The counter
+    * must only be updated this way, and reads of it are not ordered with
+    * concurrent increments. */
+#  define TM_SHARED_ADD_L(var, val)     stm::tx_add(&var, (long)(val), (stm::TxThread*)STM_SELF)
+
 #  define TM_LOCAL_WRITE_I(var, val)    STM_LOCAL_WRITE_I(var, val)
 #  define TM_LOCAL_WRITE_L(var, val)    STM_LOCAL_WRITE_L(var, val)
 #  define TM_LOCAL_WRITE_P(var, val)    STM_LOCAL_WRITE_P(var, val)
@@ -631,6 +642,8 @@
 #  define TM_SHARED_WRITE_P(var, val)   ({var = val; var;})
 #  define TM_SHARED_WRITE_F(var, val)   ({var = val; var;})
 
+#  define TM_SHARED_ADD_L(var, val)     ({var += val; var;})
+
 #  define TM_LOCAL_WRITE_I(var, val)    ({var = val; var;})
 #  define TM_LOCAL_WRITE_L(var, val)    ({var = val; var;})
 #  define TM_LOCAL_WRITE_P(var, val)    ({var = val; var;})